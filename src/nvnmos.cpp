@@ -25,17 +25,38 @@
 
 #include "nvnmos.h"
 
+#include <algorithm>
+#include <climits>
+#include <mutex>
+#include <thread>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/iterator_range_core.hpp>
 #include "cpprest/host_utils.h"
 #include "nmos/asset.h"
 #include "nmos/log_gate.h"
+#include "nmos/mdns.h"
 #include "nmos/model.h"
 #include "nmos/node_server.h"
 #include "nmos/process_utils.h"
 #include "nmos/server.h"
+#include "pplx/threadpool.h"
+#include "nvnmos_activation_queue.h"
+#include "nvnmos_api.h"
+#include "nvnmos_change_feed.h"
+#include "nvnmos_connection_index.h"
+#include "nvnmos_event_loop.h"
+#include "nvnmos_format.h"
 #include "nvnmos_impl.h"
+#include "nvnmos_link_events.h"
+#include "nvnmos_metrics.h"
+#include "nvnmos_ptp_status.h"
+#include "nvnmos_query_cache.h"
+#include "nvnmos_registry_accounting.h"
+#include "nvnmos_replication.h"
+#include "nvnmos_sdp_store.h"
+#include "nvnmos_state_digest.h"
+#include "nvnmos_transportfile.h"
 
 namespace utility
 {
@@ -48,6 +69,9 @@ namespace utility
 
 namespace nvnmos
 {
+    // the initial size of the buffer for the JSON merge patch of each resource of a custom format
+    const std::size_t format_patch_size = 16384;
+
     class log_gate : public slog::base_gate
     {
     public:
@@ -84,23 +108,80 @@ namespace nvnmos
         server(const NvNmosNodeConfig& config, NvNmosNodeServer* server);
         ~server();
 
-        void add_receiver(const NvNmosReceiverConfig& config);
-        void remove_receiver(const std::string& id);
-        void add_sender(const NvNmosSenderConfig& config);
-        void remove_sender(const std::string& id);
+        node_implementation_status add_receiver(const NvNmosReceiverConfig& config);
+        node_implementation_status remove_receiver(const std::string& id);
+        node_implementation_status add_sender(const NvNmosSenderConfig& config);
+        node_implementation_status remove_sender(const std::string& id);
+        node_implementation_status add_receivers_and_senders(const NvNmosReceiverConfig* receivers, unsigned int num_receivers, const NvNmosSenderConfig* senders, unsigned int num_senders);
+        void reset();
+
+        node_implementation_status activate_rtp_connection(const std::string& id, const std::string& sdp);
+        bool activate_rtp_connection_async(const char* id, const char* sdp) { return activations && activations->push(id, sdp); }
+
+        void data_plane_alive() { liveness.alive(); }
+        bool link_state_event(const std::string& interface_name, bool up);
+
+        bool run_once(std::chrono::milliseconds timeout);
+        bool get_poll_fds(int* fds, unsigned int& num_fds, int& timeout) const;
 
-        void activate_rtp_connection(const std::string& id, const std::string& sdp);
+        bool promote();
+
+        bool resync_change_feed();
+        void get_state_digest(unsigned char* result);
+        std::vector<std::string> find_receivers_by_sender(const std::string& sender_id);
+        std::vector<std::string> find_receivers_by_group(const std::string& group);
+        web::json::value get_metrics() const;
+        void get_startup_times(NvNmosStartupTimes& times) const;
 
     private:
         static nmos::settings make_settings(const NvNmosNodeConfig& config);
         void log_current_exception();
 
+        bool promote_();
+        void replicate(const utility::string_t& op, const utility::string_t& key = {}, const std::string& value = {});
+
+        // declared first, so that the start time is as early as possible
+        startup_times startup;
+
         nmos::node_model node_model;
         nmos::experimental::log_model log_model;
         log_gate gate;
 
         nmos::experimental::node_implementation node_implementation;
         std::unique_ptr<nmos::server> node_server;
+
+        data_plane_liveness liveness;
+        node_health health;
+        std::unique_ptr<activation_queue> activations;
+        std::unique_ptr<link_event_source> link_events;
+        // the same source, when the link events are pushed by the application
+        fake_link_event_source* application_link_events = nullptr;
+        std::unique_ptr<ptp_status_source> ptp_status;
+        std::unique_ptr<change_feed> changes;
+        query_cache remote_senders;
+        format_registry formats;
+        sdp_store sdps;
+        sdp_cache parsed_sdps;
+        transportfile_store transportfiles;
+        activation_rollback rollback;
+        state_digest digest;
+        connection_index connections;
+        http_metrics http_requests;
+        std::unique_ptr<registry_accounting> registry;
+        event_loop loop;
+        // with the application's event loop, a standby applies the replication stream using this loop until it is promoted
+        event_loop standby_loop;
+
+        // the primary's log, or the standby's stream, when replication is enabled
+        // the log is created by the standby thread or task when the standby is promoted automatically, so it is guarded by the mutex
+        std::mutex replication_mutex;
+        std::unique_ptr<replication_log> replication;
+        std::unique_ptr<replication_stream> replication_source;
+        std::thread standby;
+        std::atomic<bool> standby_stopping{ false };
+        std::mutex promote_mutex;
+        // whether the node server has been opened, which a standby only does when promoted
+        std::atomic<bool> opened{ false };
     };
 
     server::server(const NvNmosNodeConfig& config, NvNmosNodeServer* server)
@@ -113,6 +194,7 @@ namespace nvnmos
             // Prepare settings
 
             node_model.settings = make_settings(config);
+            startup.complete(startup_times::settings);
 
             log_model.settings = node_model.settings;
             log_model.level = nmos::fields::logging_level(log_model.settings);
@@ -125,24 +207,316 @@ namespace nvnmos
             slog::log<slog::severities::info>(gate, SLOG_FLF) << "Build settings: " << nmos::get_build_settings_info();
             slog::log<slog::severities::info>(gate, SLOG_FLF) << "Initial settings: " << node_model.settings.serialize();
 
+            // The cache of remote senders is maintained by its own thread, which the application's event loop is meant to avoid
+
+            if (nvnmos::fields::external_event_loop(node_model.settings) && !nvnmos::fields::query_api(node_model.settings).empty())
+            {
+                slog::log<slog::severities::severe>(gate, SLOG_FLF) << "The Query API cannot be used with the application's event loop";
+                throw node_implementation_exception();
+            }
+
             // Set up the callbacks between the node server and the underlying implementation
 
             const auto& activated = config.rtp_connection_activated;
             auto& gate_ = gate;
             auto rtp_connection_activated = [activated, server, &gate_](const std::string& id, const std::string& sdp)
             {
-                if (!activated) return;
+                if (!activated) return true;
                 const bool success = activated(server, id.c_str(), !sdp.empty() ? sdp.c_str() : 0);
                 if (!success)
                 {
                     slog::log<slog::severities::warning>(gate_, SLOG_FLF) << "Activation failed for internal id: " << id;
                 }
+                return success;
             };
-            node_implementation = make_node_implementation(node_model, rtp_connection_activated, gate);
+            sender_transportfile_resolver resolve_sender_transportfile;
+            if (!nvnmos::fields::query_api(node_model.settings).empty())
+            {
+                resolve_sender_transportfile = [this](const utility::string_t& sender_id) { return remote_senders.find_transportfile(sender_id); };
+            }
+            // Register the handlers for any custom formats, before any senders or receivers are added
+
+            for (unsigned int i = 0; i < config.num_formats; ++i)
+            {
+                const auto& format_config = config.formats[i];
+                if (0 == format_config.media_type || 0 == format_config.format)
+                {
+                    slog::log<slog::severities::severe>(gate, SLOG_FLF) << "Invalid custom format";
+                    throw node_implementation_exception();
+                }
+
+                const nmos::media_type media_type{ utility::s2us(format_config.media_type) };
+                const nmos::format format{ utility::s2us(format_config.format) };
+                if (nmos::formats::video != format && nmos::formats::audio != format && nmos::formats::data != format && nmos::formats::mux != format)
+                {
+                    slog::log<slog::severities::severe>(gate, SLOG_FLF) << "Unsupported format: " << format.name << " for custom media type: " << media_type.name;
+                    throw node_implementation_exception();
+                }
+
+                const auto& make_resource = format_config.make_resource;
+                format_resource_patcher patch_resource;
+                if (make_resource)
+                {
+                    patch_resource = [make_resource, server, &gate_](const utility::string_t& type, const std::string& sdp, web::json::value& patch)
+                    {
+                        const auto type_name = utility::us2s(type);
+                        std::vector<char> buffer(format_patch_size, '\0');
+                        auto size = (unsigned int)buffer.size();
+                        if (!make_resource(server, type_name.c_str(), sdp.c_str(), buffer.data(), &size)) return false;
+                        if (buffer.size() < size)
+                        {
+                            // the callback is made once more with a buffer of the size it requires
+                            buffer.assign(size, '\0');
+                            if (!make_resource(server, type_name.c_str(), sdp.c_str(), buffer.data(), &size)) return false;
+                        }
+                        if (buffer.size() < size || buffer.end() == std::find(buffer.begin(), buffer.end(), '\0'))
+                        {
+                            slog::log<slog::severities::error>(gate_, SLOG_FLF) << "Truncated " << type << " patch for custom format";
+                            return false;
+                        }
+                        const std::string patch_data(buffer.data());
+                        if (patch_data.empty()) return true;
+                        try
+                        {
+                            patch = web::json::value::parse(utility::s2us(patch_data));
+                            return true;
+                        }
+                        catch (const web::json::json_exception& e)
+                        {
+                            slog::log<slog::severities::error>(gate_, SLOG_FLF) << "Invalid " << type << " patch for custom format: " << e.what();
+                            return false;
+                        }
+                    };
+                }
+                formats.insert(media_type, make_custom_format_handler(format, media_type, patch_resource));
+
+                slog::log<slog::severities::info>(gate, SLOG_FLF) << "Registered custom media type: " << media_type.name << " with format: " << format.name;
+            }
+
+            node_implementation = make_node_implementation(node_model, rtp_connection_activated, resolve_sender_transportfile, sdps, parsed_sdps, transportfiles, rollback, connections, liveness, health, startup, gate);
+
+            // Limit the threads used for HTTP and WebSocket requests, if required
+            // (the thread pool is shared by the whole process, so it can only be initialized once)
+
+            if (0 != nvnmos::fields::http_threads(node_model.settings))
+            {
+                try
+                {
+                    crossplat::threadpool::initialize_with_threads((size_t)nvnmos::fields::http_threads(node_model.settings));
+                }
+                catch (const std::exception& e)
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Could not limit the HTTP thread pool: " << e.what();
+                }
+            }
 
             // Set up the node server
 
             node_server.reset(new nmos::server(nmos::experimental::make_node_server(node_model, node_implementation, log_model, gate)));
+            startup.complete(startup_times::server);
+
+            node_implementation_customize_behaviour(*node_server, node_model, node_implementation, gate);
+
+            // The node implementation's tasks are either run by their own threads, or by the application's event loop
+
+            const bool external_event_loop = nvnmos::fields::external_event_loop(node_model.settings);
+            auto run_task = [&](node_implementation_task task, int fd)
+            {
+                if (external_event_loop)
+                {
+                    loop.add(std::move(task), fd);
+                }
+                else
+                {
+                    node_server->thread_functions.push_back([&, task] { node_implementation_task_thread(node_model, task); });
+                }
+            };
+
+            // Apply queued activations, if required
+
+            if (0 != nvnmos::fields::activation_queue_size(node_model.settings))
+            {
+                activations.reset(new activation_queue(nvnmos::fields::activation_queue_size(node_model.settings), nvnmos::fields::activation_queue_sdp_size(node_model.settings)));
+
+                const auto& completed = config.rtp_connection_activation_completed;
+                auto activation_completed = [completed, server](const std::string& id, bool success)
+                {
+                    if (completed) completed(server, id.c_str(), success);
+                };
+                auto task = make_node_implementation_activation_queue_task(node_model, *activations, sdps, parsed_sdps, transportfiles, rollback, connections, liveness, activation_completed, gate);
+                if (external_event_loop)
+                {
+                    run_task(task, activations->poll_fd());
+                }
+                else
+                {
+                    // the thread waits on the queue itself, rather than polling it with the model lock
+                    node_server->thread_functions.push_back([&, task] { node_implementation_activation_queue_thread(node_model, *activations, task); });
+                }
+            }
+
+            // Retry failed activations, if required
+
+            if (0 != nvnmos::fields::activation_retries(node_model.settings))
+            {
+                run_task(make_node_implementation_activation_retry_task(node_model, rollback, connections, rtp_connection_activated, sdps, transportfiles, liveness, gate), -1);
+            }
+
+            // Monitor the data plane liveness, if required
+
+            if (0 != nvnmos::fields::data_plane_timeout(node_model.settings))
+            {
+                run_task(make_node_implementation_data_plane_task(node_model, liveness, gate), -1);
+            }
+
+            // Monitor the network interfaces' link state, if required
+
+            if (nvnmos::fields::link_monitor(node_model.settings))
+            {
+                if (U("application") == nvnmos::fields::link_events(node_model.settings))
+                {
+                    application_link_events = new fake_link_event_source;
+                    link_events.reset(application_link_events);
+                }
+                else
+                {
+                    link_events = make_netlink_event_source();
+                }
+                if (link_events)
+                {
+                    const auto& changed = config.link_state_changed;
+                    auto link_state_changed = [changed, server](const std::string& id, unsigned int leg, bool up)
+                    {
+                        if (changed) changed(server, id.c_str(), leg, up);
+                    };
+                    if (external_event_loop)
+                    {
+                        run_task(make_node_implementation_link_monitor_task(node_model, *link_events, link_state_changed, gate), link_events->poll_fd());
+                    }
+                    else
+                    {
+                        node_server->thread_functions.push_back([&, link_state_changed] { node_implementation_link_monitor_thread(node_model, *link_events, link_state_changed, gate); });
+                    }
+                }
+                else
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Network interface link state monitoring is not supported on this platform";
+                }
+            }
+
+            // Monitor the PTP status, if required
+
+            if (!nvnmos::fields::ptp_status(node_model.settings).empty())
+            {
+                ptp_status = make_ptp_status_source(utility::us2s(nvnmos::fields::ptp_status(node_model.settings)), nvnmos::fields::ptp_status_domain(node_model.settings));
+                if (ptp_status)
+                {
+                    // in the application's event loop, the query mustn't block, so the responses are read when they are available
+                    const bool split = external_event_loop && -1 != ptp_status->poll_fd();
+                    run_task(make_node_implementation_ptp_status_task(node_model, *ptp_status, sdps, transportfiles, split, gate), ptp_status->poll_fd());
+                }
+                else
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "PTP status monitoring via pmc is not supported on this platform";
+                }
+            }
+
+            // Maintain the cache of remote senders, if required
+
+            if (!nvnmos::fields::query_api(node_model.settings).empty())
+            {
+                // the WebSocket client is driven by the HTTP thread pool anyway, so this has its own thread, and isn't allowed
+                // with the application's event loop
+                node_server->thread_functions.push_back([&] { query_cache_thread(node_model, remote_senders, gate); });
+            }
+
+            // Account for the Registration API requests caused by each operation, if required
+
+            if (nvnmos::fields::registry_accounting(node_model.settings))
+            {
+                registry.reset(new registry_accounting);
+
+                if (external_event_loop)
+                {
+                    run_task(make_registry_accounting_task(node_model, *registry), -1);
+                }
+                else
+                {
+                    node_server->thread_functions.push_back([&] { registry_accounting_thread(node_model, *registry); });
+                }
+            }
+
+            // Publish the changes to the node's resources, if required
+
+            if (0 != config.change_feed)
+            {
+                const auto& changed = config.change_feed;
+                changes.reset(new change_feed([changed, server](const std::string& change)
+                {
+                    changed(server, change.c_str());
+                }));
+                if (external_event_loop)
+                {
+                    run_task(make_change_feed_task(node_model, *changes, gate), -1);
+                }
+                else
+                {
+                    node_server->thread_functions.push_back([&] { change_feed_thread(node_model, *changes, gate); });
+                }
+            }
+
+            // Replicate the node's state to standby servers, or from the primary, if required
+
+            const auto replication_socket = utility::us2s(nvnmos::fields::replication_socket(node_model.settings));
+            const bool is_standby = !replication_socket.empty() && nvnmos::fields::replication_standby(node_model.settings);
+            if (!replication_socket.empty())
+            {
+                if (is_standby)
+                {
+                    replication_source = make_replication_stream(replication_socket);
+                }
+                else
+                {
+                    replication = make_replication_log(replication_socket);
+                }
+                if (!replication && !replication_source)
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Replication is not supported on this platform";
+                }
+
+                // a standby only starts publishing its state when promoted, since the primary's socket is still in use
+                if (external_event_loop)
+                {
+                    // the task is added when a standby is promoted
+                    if (replication) run_task(make_replication_publisher_task(node_model, *replication, transportfiles, gate), replication->poll_fd());
+                }
+                else
+                {
+                    node_server->thread_functions.push_back([&]
+                    {
+                        replication_log* log = nullptr;
+                        {
+                            std::lock_guard<std::mutex> lock(replication_mutex);
+                            log = replication.get();
+                        }
+                        if (log) replication_publisher_thread(node_model, *log, transportfiles, gate);
+                    });
+                }
+            }
+
+            // Set up the custom endpoints on the Connection API port
+
+            node_server->api_routers[{ {}, nmos::fields::connection_port(node_model.settings) }].mount(U("/x-nvnmos"), make_nvnmos_api(node_model, transportfiles, digest, [this] { return get_metrics(); }, gate));
+
+            // Set up the health endpoints for orchestrator probes at the root of the same port
+
+            const bool registration_required = !nmos::fields::registry_address(node_model.settings).empty();
+            const std::chrono::milliseconds data_plane_timeout(nvnmos::fields::data_plane_timeout(node_model.settings));
+            node_server->api_routers[{ {}, nmos::fields::connection_port(node_model.settings) }].mount({}, make_nvnmos_health_api(health, liveness, registration_required, data_plane_timeout));
+
+            // Record the latency of the requests to each route, now that all the routes have been added
+
+            instrument_api_routers(*node_server, http_requests);
 
             // Disable TRACE method
 
@@ -154,26 +528,61 @@ namespace nvnmos
             // Set up the node resources, etc.
 
             node_implementation_init(node_model, gate);
+            startup.complete(startup_times::init);
 
-            for (auto& receiver : boost::make_iterator_range_n(config.receivers, config.num_receivers))
+            if (node_implementation_status::ok != add_receivers_and_senders(config.receivers, config.num_receivers, config.senders, config.num_senders))
             {
-                if (!receiver.sdp) throw std::logic_error("invalid receiver config");
-                node_implementation_add_receiver(node_model, receiver.sdp, gate);
+                slog::log<slog::severities::severe>(gate, SLOG_FLF) << "Could not add the configured receivers and senders";
+                throw node_implementation_exception();
             }
+            startup.complete(startup_times::resources);
+
+            // A standby keeps its model identical to the primary's, but doesn't open the API ports or register until promoted
 
-            for (auto& sender : boost::make_iterator_range_n(config.senders, config.num_senders))
+            if (replication_source)
             {
-                if (!sender.sdp) throw std::logic_error("invalid sender config");
-                node_implementation_add_sender(node_model, sender.sdp, gate);
+                slog::log<slog::severities::info>(gate, SLOG_FLF) << "Standing by for replication from primary";
+
+                if (external_event_loop)
+                {
+                    auto primary_lost = [this]
+                    {
+                        if (nvnmos::fields::replication_auto_promote(node_model.settings)) promote_();
+                    };
+                    standby_loop.add(make_replication_standby_task(node_model, *replication_source, sdps, formats, transportfiles, rollback, connections, standby_stopping, primary_lost, gate), replication_source->poll_fd());
+                    return;
+                }
+
+                standby = std::thread([this]
+                {
+                    try
+                    {
+                        const bool primary_lost = replication_standby_thread(node_model, *replication_source, sdps, formats, transportfiles, rollback, connections, standby_stopping, gate);
+                        if (primary_lost && nvnmos::fields::replication_auto_promote(node_model.settings)) promote_();
+                    }
+                    catch (...)
+                    {
+                        log_current_exception();
+                    }
+                });
+                return;
             }
 
             // Open the API ports and start up node operation (including the DNS-SD advertisements)
 
             slog::log<slog::severities::info>(gate, SLOG_FLF) << "Preparing for connections";
 
+            // Start the data plane deadline from now, rather than from construction
+
+            liveness.alive();
+
             node_server->open().wait();
+            opened = true;
+            health.listening = true;
+            startup.complete(startup_times::open);
 
             slog::log<slog::severities::info>(gate, SLOG_FLF) << "Ready for connections";
+            slog::log<slog::severities::info>(gate, SLOG_FLF) << "Startup times: " << startup.summary();
         }
         catch (...)
         {
@@ -184,11 +593,15 @@ namespace nvnmos
 
     server::~server()
     {
+        standby_stopping = true;
+        if (standby.joinable()) standby.join();
+
         if (!node_server) return;
-        try
+        if (opened) try
         {
             slog::log<slog::severities::info>(gate, SLOG_FLF) << "Closing connections";
 
+            health.listening = false;
             node_server->close().wait();
         }
         catch (...)
@@ -210,7 +623,9 @@ namespace nvnmos
 
         const auto host_name = 0 != config.host_name ? utility::s2us(config.host_name) : nmos::get_host_name({});
         const auto dot = host_name.find(U('.'));
-        const auto domain = utility::string_t::npos != dot ? host_name.substr(dot + 1) : nmos::get_domain({});
+        const auto domain = 0 != config.discovery && 0 != config.discovery->domain
+            ? utility::s2us(config.discovery->domain)
+            : utility::string_t::npos != dot ? host_name.substr(dot + 1) : nmos::get_domain({});
         web::json::insert(settings, std::make_pair(nmos::fields::host_name, host_name));
         web::json::insert(settings, std::make_pair(nmos::fields::domain, domain));
 
@@ -230,10 +645,143 @@ namespace nvnmos
         {
             web::json::insert(settings, std::make_pair(nmos::fields::http_port, config.http_port));
         }
+        if (0 != config.discovery)
+        {
+            const auto& discovery = *config.discovery;
+
+            if (discovery.disable_node_advertisement)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::node_advertisement, false));
+            }
+
+            if (0 != discovery.registry_address)
+            {
+                web::json::insert(settings, std::make_pair(nmos::fields::registry_address, utility::s2us(discovery.registry_address)));
+                if (0 != discovery.registry_port)
+                {
+                    web::json::insert(settings, std::make_pair(nmos::fields::registration_port, discovery.registry_port));
+                }
+
+                // no priority in the range means DNS-SD browsing is skipped and the specified registry is used directly
+                web::json::insert(settings, std::make_pair(nmos::fields::highest_pri, nmos::service_priorities::no_priority));
+                web::json::insert(settings, std::make_pair(nmos::fields::lowest_pri, nmos::service_priorities::no_priority));
+            }
+
+            if (0 != discovery.backoff_min)
+            {
+                web::json::insert(settings, std::make_pair(nmos::fields::discovery_backoff_min, discovery.backoff_min));
+            }
+            if (0 != discovery.backoff_max)
+            {
+                web::json::insert(settings, std::make_pair(nmos::fields::discovery_backoff_max, discovery.backoff_max));
+            }
+
+            if (0 != discovery.query_api)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::query_api, utility::s2us(discovery.query_api)));
+            }
+        }
+
         web::json::insert(settings, std::make_pair(nmos::fields::events_port, -1));
         web::json::insert(settings, std::make_pair(nmos::fields::events_ws_port, -1));
         web::json::insert(settings, std::make_pair(nmos::fields::channelmapping_port, -1));
 
+        if (0 != config.activation_queue_size)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::activation_queue_size, config.activation_queue_size));
+            if (0 != config.activation_queue_sdp_size)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::activation_queue_sdp_size, config.activation_queue_sdp_size));
+            }
+        }
+
+        if (0 != config.activation_retries)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::activation_retries, config.activation_retries));
+            if (0 != config.activation_retry_interval)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::activation_retry_interval, config.activation_retry_interval));
+            }
+        }
+
+        if (config.external_event_loop)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::external_event_loop, true));
+        }
+
+        if (0 != config.http_threads)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::http_threads, config.http_threads));
+        }
+
+        if (0 != config.data_plane_timeout)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::data_plane_timeout, config.data_plane_timeout));
+        }
+
+        if (config.registry_accounting)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::registry_accounting, true));
+        }
+
+        if (config.lazy_transport_files)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::lazy_transport_files, true));
+        }
+
+        if (config.monitor_links)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::link_monitor, true));
+            if (config.application_link_events)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::link_events, utility::string_t(U("application"))));
+            }
+        }
+
+        if (0 != config.rtp_port_min)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::rtp_port_min, config.rtp_port_min));
+        }
+
+        if (0 != config.rtp_port_max)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::rtp_port_max, config.rtp_port_max));
+        }
+
+        if (config.ssm_only)
+        {
+            web::json::insert(settings, std::make_pair(nvnmos::fields::ssm_only, true));
+        }
+
+        if (0 != config.ptp_status)
+        {
+            const auto& ptp_status = *config.ptp_status;
+            if (0 == ptp_status.path) throw std::logic_error("invalid PTP status config");
+
+            web::json::insert(settings, std::make_pair(nvnmos::fields::ptp_status, utility::s2us(ptp_status.path)));
+            web::json::insert(settings, std::make_pair(nvnmos::fields::ptp_status_domain, ptp_status.domain));
+            if (0 != ptp_status.interval)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::ptp_status_interval, ptp_status.interval));
+            }
+        }
+
+        if (0 != config.replication)
+        {
+            const auto& replication = *config.replication;
+            if (0 == replication.socket_path) throw std::logic_error("invalid replication config");
+
+            web::json::insert(settings, std::make_pair(nvnmos::fields::replication_socket, utility::s2us(replication.socket_path)));
+            if (replication.standby)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::replication_standby, true));
+            }
+            if (replication.auto_promote)
+            {
+                web::json::insert(settings, std::make_pair(nvnmos::fields::replication_auto_promote, true));
+            }
+        }
+
         if (0 != config.asset_tags)
         {
             const auto& asset = *config.asset_tags;
@@ -327,14 +875,15 @@ namespace nvnmos
         }
     }
 
-    void server::add_receiver(const NvNmosReceiverConfig& config)
+    node_implementation_status server::add_receiver(const NvNmosReceiverConfig& config)
     {
-        using web::json::value_of;
-
         try
         {
-            if (!config.sdp) throw std::logic_error("invalid receiver config");
-            node_implementation_add_receiver(node_model, config.sdp, gate);
+            if (!config.sdp) return node_implementation_status::invalid_argument;
+            registry_accounting::scope accounting(registry.get(), node_model, U("add_receiver"));
+            const auto status = node_implementation_add_receiver(node_model, sdps, formats, config.sdp, gate);
+            if (node_implementation_status::ok == status) replicate(replication_ops::add_receiver, replication_fields::sdp.key, config.sdp);
+            return status;
         }
         catch (...)
         {
@@ -343,11 +892,14 @@ namespace nvnmos
         }
     }
 
-    void server::remove_receiver(const std::string& id)
+    node_implementation_status server::remove_receiver(const std::string& id)
     {
         try
         {
-            node_implementation_remove_receiver(node_model, utility::s2us(id), gate);
+            registry_accounting::scope accounting(registry.get(), node_model, U("remove_receiver"));
+            const auto status = node_implementation_remove_receiver(node_model, sdps, rollback, connections, utility::s2us(id), gate);
+            if (node_implementation_status::ok == status) replicate(replication_ops::remove_receiver, replication_fields::id.key, id);
+            return status;
         }
         catch (...)
         {
@@ -356,14 +908,31 @@ namespace nvnmos
         }
     }
 
-    void server::add_sender(const NvNmosSenderConfig& config)
+    node_implementation_status server::add_sender(const NvNmosSenderConfig& config)
     {
-        using web::json::value_of;
+        try
+        {
+            if (!config.sdp) return node_implementation_status::invalid_argument;
+            registry_accounting::scope accounting(registry.get(), node_model, U("add_sender"));
+            const auto status = node_implementation_add_sender(node_model, sdps, formats, config.sdp, gate);
+            if (node_implementation_status::ok == status) replicate(replication_ops::add_sender, replication_fields::sdp.key, config.sdp);
+            return status;
+        }
+        catch (...)
+        {
+            log_current_exception();
+            throw;
+        }
+    }
 
+    node_implementation_status server::remove_sender(const std::string& id)
+    {
         try
         {
-            if (!config.sdp) throw std::logic_error("invalid sender config");
-            node_implementation_add_sender(node_model, config.sdp, gate);
+            registry_accounting::scope accounting(registry.get(), node_model, U("remove_sender"));
+            const auto status = node_implementation_remove_sender(node_model, sdps, transportfiles, rollback, utility::s2us(id), gate);
+            if (node_implementation_status::ok == status) replicate(replication_ops::remove_sender, replication_fields::id.key, id);
+            return status;
         }
         catch (...)
         {
@@ -372,11 +941,32 @@ namespace nvnmos
         }
     }
 
-    void server::remove_sender(const std::string& id)
+    node_implementation_status server::add_receivers_and_senders(const NvNmosReceiverConfig* receivers, unsigned int num_receivers, const NvNmosSenderConfig* senders, unsigned int num_senders)
     {
         try
         {
-            node_implementation_remove_sender(node_model, utility::s2us(id), gate);
+            std::vector<std::string> receiver_sdps;
+            for (auto& receiver : boost::make_iterator_range_n(receivers, num_receivers))
+            {
+                if (!receiver.sdp) return node_implementation_status::invalid_argument;
+                receiver_sdps.push_back(receiver.sdp);
+            }
+
+            std::vector<std::string> sender_sdps;
+            for (auto& sender : boost::make_iterator_range_n(senders, num_senders))
+            {
+                if (!sender.sdp) return node_implementation_status::invalid_argument;
+                sender_sdps.push_back(sender.sdp);
+            }
+
+            registry_accounting::scope accounting(registry.get(), node_model, U("add_receivers_and_senders"));
+            const auto status = node_implementation_add_receivers_and_senders(node_model, sdps, formats, receiver_sdps, sender_sdps, gate);
+            if (node_implementation_status::ok == status)
+            {
+                for (auto& sdp : receiver_sdps) replicate(replication_ops::add_receiver, replication_fields::sdp.key, sdp);
+                for (auto& sdp : sender_sdps) replicate(replication_ops::add_sender, replication_fields::sdp.key, sdp);
+            }
+            return status;
         }
         catch (...)
         {
@@ -385,11 +975,13 @@ namespace nvnmos
         }
     }
 
-    void server::activate_rtp_connection(const std::string& id, const std::string& sdp)
+    void server::reset()
     {
         try
         {
-            node_implementation_activate_rtp_connection(node_model, utility::s2us(id), sdp, gate);
+            registry_accounting::scope accounting(registry.get(), node_model, U("reset"));
+            node_implementation_reset(node_model, sdps, transportfiles, rollback, connections, gate);
+            replicate(replication_ops::reset);
         }
         catch (...)
         {
@@ -397,28 +989,259 @@ namespace nvnmos
             throw;
         }
     }
-}
 
-NVNMOS_API
-bool create_nmos_node_server(
-    const NvNmosNodeConfig* config,
-    NvNmosNodeServer* server)
-{
-    if (!config || !server) return false;
-    try
+    node_implementation_status server::activate_rtp_connection(const std::string& id, const std::string& sdp)
     {
-        std::unique_ptr<nvnmos::server> impl(new nvnmos::server(*config, server));
+        try
+        {
+            registry_accounting::scope accounting(registry.get(), node_model, U("activate_rtp_connection"));
+            return node_implementation_activate_rtp_connection(node_model, sdps, parsed_sdps, transportfiles, rollback, connections, liveness, utility::s2us(id), sdp, gate);
+        }
+        catch (...)
+        {
+            log_current_exception();
+            throw;
+        }
+    }
 
-        server->impl = impl.release();
-        return true;
+    web::json::value server::get_metrics() const
+    {
+        auto metrics = web::json::value_of({
+            { U("http"), http_requests.to_json() },
+            { U("sdp_cache"), web::json::value_of({
+                { U("hits"), parsed_sdps.hits() },
+                { U("misses"), parsed_sdps.misses() },
+                { U("size"), (uint64_t)parsed_sdps.size() },
+                { U("capacity"), (uint64_t)parsed_sdps.max_size() }
+            }, true) }
+        }, true);
+        if (registry) metrics[U("registry")] = registry->to_json();
+        return metrics;
     }
-    catch (...)
+
+    void server::get_startup_times(NvNmosStartupTimes& times) const
     {
-        return false;
+        auto elapsed = [this](startup_times::phase phase) -> int64_t
+        {
+            const auto time = startup.elapsed[phase].load();
+            return 0 <= time ? (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(startup_times::clock::duration(time)).count() : -1;
+        };
+
+        times.start = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(startup.start.time_since_epoch()).count();
+        times.settings = elapsed(startup_times::settings);
+        times.server = elapsed(startup_times::server);
+        times.init = elapsed(startup_times::init);
+        times.resources = elapsed(startup_times::resources);
+        times.open = elapsed(startup_times::open);
+        times.registered = elapsed(startup_times::registered);
     }
-}
 
-NVNMOS_API
+    void server::get_state_digest(unsigned char* result)
+    {
+        static_assert(NVNMOS_STATE_DIGEST_SIZE == std::tuple_size<state_digest_value>::value, "digest size mismatch");
+
+        state_digest_value value;
+        {
+            auto lock = node_model.read_lock();
+            value = digest.get(node_model);
+        }
+        std::copy(value.begin(), value.end(), result);
+    }
+
+    std::vector<std::string> server::find_receivers_by_sender(const std::string& sender_id)
+    {
+        try
+        {
+            // the index has its own lock, so this doesn't need the model lock
+            return connections.find_receivers_by_sender(utility::s2us(sender_id));
+        }
+        catch (...)
+        {
+            log_current_exception();
+            throw;
+        }
+    }
+
+    std::vector<std::string> server::find_receivers_by_group(const std::string& group)
+    {
+        try
+        {
+            return connections.find_receivers_by_group(utility::s2us(group));
+        }
+        catch (...)
+        {
+            log_current_exception();
+            throw;
+        }
+    }
+
+    bool server::link_state_event(const std::string& interface_name, bool up)
+    {
+        if (!application_link_events) return false;
+
+        application_link_events->push({ utility::s2us(interface_name), up, false });
+        return true;
+    }
+
+    bool server::resync_change_feed()
+    {
+        if (!changes) return false;
+
+        // set the flag under the lock so that the change feed thread cannot miss the notification
+        {
+            auto lock = node_model.write_lock();
+            changes->resync();
+        }
+        node_model.notify();
+        return true;
+    }
+
+    bool server::promote()
+    {
+        try
+        {
+            // stop applying the replication stream, unless the standby has already been promoted automatically
+            standby_stopping = true;
+            if (standby.joinable() && std::this_thread::get_id() != standby.get_id()) standby.join();
+
+            return promote_();
+        }
+        catch (...)
+        {
+            log_current_exception();
+            throw;
+        }
+    }
+
+    bool server::promote_()
+    {
+        std::lock_guard<std::mutex> lock(promote_mutex);
+        if (opened) return true;
+
+        slog::log<slog::severities::info>(gate, SLOG_FLF) << "Promoting standby to primary";
+
+        // take over the primary's socket, so that a new standby can replicate from this server
+        const auto replication_socket = utility::us2s(nvnmos::fields::replication_socket(node_model.settings));
+        if (!replication_socket.empty())
+        {
+            try
+            {
+                auto log = make_replication_log(replication_socket);
+                std::lock_guard<std::mutex> lock(replication_mutex);
+                replication = std::move(log);
+
+                // the application's event loop only runs the node's tasks once it has been opened, so the task can be added now
+                if (replication && nvnmos::fields::external_event_loop(node_model.settings))
+                {
+                    loop.add(make_replication_publisher_task(node_model, *replication, transportfiles, gate), replication->poll_fd());
+                }
+            }
+            catch (const std::system_error& e)
+            {
+                slog::log<slog::severities::error>(gate, SLOG_FLF) << "Could not publish replication stream: " << e.what();
+            }
+        }
+
+        // the application has not been told about the replicated activations, so it is now, before the APIs are opened, and any
+        // which it fails to apply are rolled back, as for an IS-05 Connection API activation
+        node_implementation_activate_active(node_model, node_implementation, gate);
+
+        liveness.alive();
+
+        node_server->open().wait();
+        opened = true;
+        health.listening = true;
+        startup.complete(startup_times::open);
+
+        slog::log<slog::severities::info>(gate, SLOG_FLF) << "Ready for connections";
+        return true;
+    }
+
+    void server::replicate(const utility::string_t& op, const utility::string_t& key, const std::string& value)
+    {
+        std::lock_guard<std::mutex> lock(replication_mutex);
+        if (!replication) return;
+
+        auto data = web::json::value_of({ { replication_fields::op, op } });
+        if (!key.empty()) data[key] = web::json::value::string(utility::s2us(value));
+
+        // the op is only queued, and is sent by the publisher thread, which is woken by the notification
+        replication->append(data);
+        node_model.notify();
+    }
+
+    bool server::run_once(std::chrono::milliseconds timeout)
+    {
+        if (!nvnmos::fields::external_event_loop(node_model.settings)) return false;
+
+        // a standby's tasks only run once it has been promoted, until when it only applies the replication stream
+        try
+        {
+            if (opened) loop.run_once(timeout);
+            else standby_loop.run_once(timeout);
+            return true;
+        }
+        catch (...)
+        {
+            log_current_exception();
+            throw;
+        }
+    }
+
+    bool server::get_poll_fds(int* fds, unsigned int& num_fds, int& timeout) const
+    {
+        if (!nvnmos::fields::external_event_loop(node_model.settings)) return false;
+
+        // a standby's tasks only run once it has been promoted, until when it only applies the replication stream
+        const auto& current = opened ? loop : standby_loop;
+
+        const auto poll_fds = current.poll_fds();
+        const auto capacity = num_fds;
+        num_fds = (unsigned int)poll_fds.size();
+        if (capacity < num_fds) return false;
+        std::copy(poll_fds.begin(), poll_fds.end(), fds);
+
+        const auto next_timeout = current.next_timeout();
+        timeout = std::chrono::milliseconds(INT_MAX) < next_timeout ? -1 : (int)next_timeout.count();
+        return true;
+    }
+
+    NvNmosStatus make_status(node_implementation_status status)
+    {
+        switch (status)
+        {
+        case node_implementation_status::ok: return NVNMOS_STATUS_OK;
+        case node_implementation_status::not_found: return NVNMOS_STATUS_NOT_FOUND;
+        case node_implementation_status::duplicate_id: return NVNMOS_STATUS_DUPLICATE_ID;
+        case node_implementation_status::unsupported_format: return NVNMOS_STATUS_UNSUPPORTED_FORMAT;
+        case node_implementation_status::no_interface: return NVNMOS_STATUS_NO_INTERFACE;
+        case node_implementation_status::invalid_sdp: return NVNMOS_STATUS_INVALID_SDP;
+        case node_implementation_status::invalid_argument: return NVNMOS_STATUS_INVALID_ARGUMENT;
+        }
+        return NVNMOS_STATUS_ERROR;
+    }
+}
+
+NVNMOS_API
+bool create_nmos_node_server(
+    const NvNmosNodeConfig* config,
+    NvNmosNodeServer* server)
+{
+    if (!config || !server) return false;
+    try
+    {
+        std::unique_ptr<nvnmos::server> impl(new nvnmos::server(*config, server));
+
+        server->impl = impl.release();
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_API
 bool destroy_nmos_node_server(
     NvNmosNodeServer* server)
 {
@@ -442,8 +1265,7 @@ bool add_nmos_receiver_to_node_server(
 
     try
     {
-        impl->add_receiver(*config);
-        return true;
+        return nvnmos::node_implementation_status::ok == impl->add_receiver(*config);
     }
     catch (...)
     {
@@ -451,6 +1273,26 @@ bool add_nmos_receiver_to_node_server(
     }
 }
 
+NVNMOS_API
+NvNmosStatus add_nmos_receiver_to_node_server_ex(
+    NvNmosNodeServer* server,
+    const NvNmosReceiverConfig* config)
+{
+    if (!server) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!config) return NVNMOS_STATUS_INVALID_ARGUMENT;
+
+    try
+    {
+        return nvnmos::make_status(impl->add_receiver(*config));
+    }
+    catch (...)
+    {
+        return NVNMOS_STATUS_ERROR;
+    }
+}
+
 NVNMOS_API
 bool remove_nmos_receiver_from_node_server(
     NvNmosNodeServer* server,
@@ -463,8 +1305,7 @@ bool remove_nmos_receiver_from_node_server(
 
     try
     {
-        impl->remove_receiver(id);
-        return true;
+        return nvnmos::node_implementation_status::ok == impl->remove_receiver(id);
     }
     catch (...)
     {
@@ -472,6 +1313,26 @@ bool remove_nmos_receiver_from_node_server(
     }
 }
 
+NVNMOS_API
+NvNmosStatus remove_nmos_receiver_from_node_server_ex(
+    NvNmosNodeServer* server,
+    const char* id)
+{
+    if (!server) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!id) return NVNMOS_STATUS_INVALID_ARGUMENT;
+
+    try
+    {
+        return nvnmos::make_status(impl->remove_receiver(id));
+    }
+    catch (...)
+    {
+        return NVNMOS_STATUS_ERROR;
+    }
+}
+
 NVNMOS_API
 bool add_nmos_sender_to_node_server(
     NvNmosNodeServer* server,
@@ -484,8 +1345,7 @@ bool add_nmos_sender_to_node_server(
 
     try
     {
-        impl->add_sender(*config);
-        return true;
+        return nvnmos::node_implementation_status::ok == impl->add_sender(*config);
     }
     catch (...)
     {
@@ -493,6 +1353,26 @@ bool add_nmos_sender_to_node_server(
     }
 }
 
+NVNMOS_API
+NvNmosStatus add_nmos_sender_to_node_server_ex(
+    NvNmosNodeServer* server,
+    const NvNmosSenderConfig* config)
+{
+    if (!server) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!config) return NVNMOS_STATUS_INVALID_ARGUMENT;
+
+    try
+    {
+        return nvnmos::make_status(impl->add_sender(*config));
+    }
+    catch (...)
+    {
+        return NVNMOS_STATUS_ERROR;
+    }
+}
+
 NVNMOS_API
 bool remove_nmos_sender_from_node_server(
     NvNmosNodeServer* server,
@@ -505,7 +1385,93 @@ bool remove_nmos_sender_from_node_server(
 
     try
     {
-        impl->remove_sender(id);
+        return nvnmos::node_implementation_status::ok == impl->remove_sender(id);
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_API
+NvNmosStatus remove_nmos_sender_from_node_server_ex(
+    NvNmosNodeServer* server,
+    const char* id)
+{
+    if (!server) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!id) return NVNMOS_STATUS_INVALID_ARGUMENT;
+
+    try
+    {
+        return nvnmos::make_status(impl->remove_sender(id));
+    }
+    catch (...)
+    {
+        return NVNMOS_STATUS_ERROR;
+    }
+}
+
+NVNMOS_API
+bool add_nmos_receivers_and_senders_to_node_server(
+    NvNmosNodeServer* server,
+    const NvNmosReceiverConfig* receivers,
+    unsigned int num_receivers,
+    const NvNmosSenderConfig* senders,
+    unsigned int num_senders)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!receivers && 0 != num_receivers) return false;
+    if (!senders && 0 != num_senders) return false;
+
+    try
+    {
+        return nvnmos::node_implementation_status::ok == impl->add_receivers_and_senders(receivers, num_receivers, senders, num_senders);
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_API
+NvNmosStatus add_nmos_receivers_and_senders_to_node_server_ex(
+    NvNmosNodeServer* server,
+    const NvNmosReceiverConfig* receivers,
+    unsigned int num_receivers,
+    const NvNmosSenderConfig* senders,
+    unsigned int num_senders)
+{
+    if (!server) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!receivers && 0 != num_receivers) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!senders && 0 != num_senders) return NVNMOS_STATUS_INVALID_ARGUMENT;
+
+    try
+    {
+        return nvnmos::make_status(impl->add_receivers_and_senders(receivers, num_receivers, senders, num_senders));
+    }
+    catch (...)
+    {
+        return NVNMOS_STATUS_ERROR;
+    }
+}
+
+NVNMOS_API
+bool reset_nmos_node_server(
+    NvNmosNodeServer* server)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+
+    try
+    {
+        impl->reset();
         return true;
     }
     catch (...)
@@ -528,7 +1494,240 @@ bool nmos_connection_rtp_activate(
 
     try
     {
-        impl->activate_rtp_connection(id, sdp);
+        return nvnmos::node_implementation_status::ok == impl->activate_rtp_connection(id, sdp);
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_API
+NvNmosStatus nmos_connection_rtp_activate_ex(
+    NvNmosNodeServer* server,
+    const char* id,
+    const char* sdp)
+{
+    if (!server) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!id) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    if (!sdp) sdp = "";
+
+    try
+    {
+        return nvnmos::make_status(impl->activate_rtp_connection(id, sdp));
+    }
+    catch (...)
+    {
+        return NVNMOS_STATUS_ERROR;
+    }
+}
+
+NVNMOS_API
+bool nmos_connection_rtp_activate_async(
+    NvNmosNodeServer* server,
+    const char* id,
+    const char* sdp)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!id) return false;
+
+    return impl->activate_rtp_connection_async(id, sdp);
+}
+
+NVNMOS_API
+bool nmos_run_once(
+    NvNmosNodeServer* server,
+    unsigned int timeout)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+
+    try
+    {
+        return impl->run_once(std::chrono::milliseconds(timeout));
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_API
+bool nmos_get_poll_fds(
+    NvNmosNodeServer* server,
+    int* fds,
+    unsigned int* num_fds,
+    int* timeout)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!num_fds || !timeout) return false;
+    if (!fds && 0 != *num_fds) return false;
+
+    return impl->get_poll_fds(fds, *num_fds, *timeout);
+}
+
+NVNMOS_API
+bool nmos_data_plane_alive(
+    NvNmosNodeServer* server)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+
+    impl->data_plane_alive();
+    return true;
+}
+
+NVNMOS_API
+bool nmos_link_state_event(
+    NvNmosNodeServer* server,
+    const char* interface_name,
+    bool up)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!interface_name) return false;
+
+    return impl->link_state_event(interface_name, up);
+}
+
+NVNMOS_API
+bool nmos_find_receivers_by_sender(
+    NvNmosNodeServer* server,
+    const char* sender_id,
+    nmos_receiver_enumeration_callback callback,
+    void* context)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!sender_id || !callback) return false;
+
+    std::vector<std::string> ids;
+    try
+    {
+        ids = impl->find_receivers_by_sender(sender_id);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    // the callbacks are made without holding the model lock
+    for (const auto& id : ids)
+    {
+        callback(server, id.c_str(), context);
+    }
+    return true;
+}
+
+NVNMOS_API
+bool nmos_find_receivers_by_group(
+    NvNmosNodeServer* server,
+    const char* group,
+    nmos_receiver_enumeration_callback callback,
+    void* context)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!group || !callback) return false;
+
+    std::vector<std::string> ids;
+    try
+    {
+        ids = impl->find_receivers_by_group(group);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    // the callbacks are made without holding the model lock
+    for (const auto& id : ids)
+    {
+        callback(server, id.c_str(), context);
+    }
+    return true;
+}
+
+NVNMOS_API
+bool nmos_promote_node_server(
+    NvNmosNodeServer* server)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+
+    try
+    {
+        return impl->promote();
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_API
+bool nmos_resync_change_feed(
+    NvNmosNodeServer* server)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+
+    return impl->resync_change_feed();
+}
+
+NVNMOS_API
+bool nmos_get_state_digest(
+    NvNmosNodeServer* server,
+    unsigned char* digest)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!digest) return false;
+
+    try
+    {
+        impl->get_state_digest(digest);
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_API
+bool nmos_get_metrics(
+    NvNmosNodeServer* server,
+    char* buffer,
+    unsigned int* size)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!size) return false;
+    if (!buffer && 0 != *size) return false;
+
+    try
+    {
+        const auto metrics = utility::us2s(impl->get_metrics().serialize());
+        const auto capacity = *size;
+        *size = (unsigned int)metrics.size() + 1;
+        if (capacity < *size) return false;
+        std::copy(metrics.c_str(), metrics.c_str() + *size, buffer);
         return true;
     }
     catch (...)
@@ -536,3 +1735,17 @@ bool nmos_connection_rtp_activate(
         return false;
     }
 }
+
+NVNMOS_API
+bool nmos_get_startup_times(
+    NvNmosNodeServer* server,
+    NvNmosStartupTimes* times)
+{
+    if (!server) return false;
+    auto impl = (nvnmos::server*)server->impl;
+    if (!impl) return false;
+    if (!times) return false;
+
+    impl->get_startup_times(*times);
+    return true;
+}
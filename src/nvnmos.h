@@ -51,6 +51,13 @@
  * - <a href="https://specs.amwa.tv/bcp-004-01/">AMWA BCP-004-01 NMOS Receiver Capabilities</a> v1.0
  * - Session Description Protocol conforming to SMPTE ST 2110-20 and -30
  *
+ * For orchestrator probes, the Connection API port also serves /healthz,
+ * which responds whenever the server is listening, and /readyz, which
+ * responds with 503 Service Unavailable while the data plane deadline
+ * is missed, see @ref NvNmosNodeConfig::data_plane_timeout, or, when
+ * a Registration API address is configured, while the Node is not
+ * registered. Neither waits for requests to other APIs to complete.
+ *
  * @ingroup NvNmosApi
  * @{
  */
@@ -85,6 +92,7 @@
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -93,10 +101,45 @@ extern "C"
 
 typedef struct _NvNmosNodeServer NvNmosNodeServer;
 
+/**
+ * Defines the results of the NvNmos library functions with the '_ex'
+ * suffix, which distinguish the expected failures so that they can be
+ * handled cheaply.
+ */
+typedef enum _NvNmosStatus
+{
+    /** The function succeeded. */
+    NVNMOS_STATUS_OK = 0,
+    /** An unexpected error occurred. See the log messages. */
+    NVNMOS_STATUS_ERROR,
+    /** An argument is invalid, e.g. a null pointer, or a configured
+        port is outside the RTP port range. */
+    NVNMOS_STATUS_INVALID_ARGUMENT,
+    /** No sender or receiver has the specified unique identifier. */
+    NVNMOS_STATUS_NOT_FOUND,
+    /** A sender or receiver with the same unique identifier already
+        exists. */
+    NVNMOS_STATUS_DUPLICATE_ID,
+    /** The media type of the Session Description Protocol data is not
+        supported. */
+    NVNMOS_STATUS_UNSUPPORTED_FORMAT,
+    /** No network interface corresponds to a connection address in the
+        Session Description Protocol data. */
+    NVNMOS_STATUS_NO_INTERFACE,
+    /** The Session Description Protocol data could not be parsed. */
+    NVNMOS_STATUS_INVALID_SDP
+} NvNmosStatus;
+
 /**
  * Type for a callback from NvNmos library when an IS-05 Connection API
  * activation occurs.
  *
+ * The callback is made while the Node's resources are locked for
+ * writing, so it must not call functions which change or read them,
+ * e.g. @ref nmos_connection_rtp_activate, which would deadlock, other
+ * than @ref nmos_find_receivers_by_sender and
+ * @ref nmos_find_receivers_by_group.
+ *
  * @param[in] server A pointer to the server issuing the callback.
  * @param[in] id     The unique identifier for the sender or receiver
  *                   to be activated or deactivated.
@@ -116,13 +159,91 @@ typedef struct _NvNmosNodeServer NvNmosNodeServer;
  *                   For a sender, the 'x-nvnmos-src-port' media-level
  *                   attribute is used to specify the source port
  *                   from which the stream is transmitted.
- * @return Whether the activation could be applied.
+ * @return Whether the activation could be applied. If not, the IS-05
+ *         Connection API /active endpoint is rolled back to the last
+ *         activation which was applied, so that it reflects the state
+ *         of the sender or receiver, and the activation may be retried,
+ *         see @ref NvNmosNodeConfig::activation_retries.
  */
 typedef bool (* nmos_connection_rtp_activation_callback)(
     NvNmosNodeServer *server,
     const char *id,
     const char *sdp);
 
+/**
+ * Callback to be notified when an activation submitted using
+ * @ref nmos_connection_rtp_activate_async has been applied.
+ *
+ * @param[in] server  A pointer to the server issuing the callback.
+ * @param[in] id      The unique identifier for the sender or receiver.
+ *                    When several activations for the same sender or
+ *                    receiver are queued together, only the latest is
+ *                    applied and reported.
+ * @param[in] success Whether the activation has been successfully
+ *                    applied.
+ */
+typedef void (* nmos_connection_rtp_activation_completed_callback)(
+    NvNmosNodeServer *server,
+    const char *id,
+    bool success);
+
+/**
+ * Callback to be notified when the network link of a leg of a sender
+ * or receiver goes down or comes up again.
+ *
+ * @param[in] server A pointer to the server issuing the callback.
+ * @param[in] id     The unique identifier for the sender or receiver.
+ * @param[in] leg    The index of the affected leg, e.g. 0 for the
+ *                   primary and 1 for the secondary leg of a SMPTE
+ *                   ST 2022-7 sender or receiver.
+ * @param[in] up     Whether the link is now up.
+ */
+typedef void (* nmos_link_state_callback)(
+    NvNmosNodeServer *server,
+    const char *id,
+    unsigned int leg,
+    bool up);
+
+/**
+ * Callback to be notified of each change to the NMOS resources of the
+ * Node, so that an external mirror, e.g. a web user interface backend,
+ * can stay current without polling the Node API and Connection API.
+ *
+ * Each change is a JSON object with a "seq" number, which increases by
+ * one with each change, and an "op":
+ *  - "resync", after which the mirror should discard its state, followed
+ *    by an "insert" for every resource;
+ *  - "insert", with the resource's "data";
+ *  - "modify", with a JSON merge "patch" as per RFC 7386, so a member
+ *    whose value becomes null is removed;
+ *  - "erase".
+ *
+ * Except for "resync", the resource is identified by the "api", either
+ * "node" or "connection", its "type", e.g. "sender", and its "id".
+ *
+ * @param[in] server A pointer to the server issuing the callback.
+ * @param[in] change The change, serialized as JSON.
+ */
+typedef void (* nmos_change_feed_callback)(
+    NvNmosNodeServer *server,
+    const char *change);
+
+/**
+ * Type for a callback from NvNmos library for each receiver found by
+ * @ref nmos_find_receivers_by_sender or @ref nmos_find_receivers_by_group.
+ *
+ * @param[in] server  A pointer to the server issuing the callback.
+ * @param[in] id      The unique identifier for the receiver.
+ * @param[in] context The context pointer passed to the find function.
+ */
+typedef void (* nmos_receiver_enumeration_callback)(
+    NvNmosNodeServer *server,
+    const char *id,
+    void *context);
+
+/** The size in bytes of the digest from @ref nmos_get_state_digest. */
+#define NVNMOS_STATE_DIGEST_SIZE 32
+
 /**
  * Defines some common severity/logging levels for log messages from
  * the NvNmos library.
@@ -161,8 +282,48 @@ typedef void (* nmos_logging_callback)(
     int level,
     const char *message);
 
+/**
+ * Type for a callback from NvNmos library to complete the IS-04 resource
+ * data of a sender or receiver of a custom format, from its Session
+ * Description Protocol data.
+ *
+ * The callback is made while the sender or receiver is being added,
+ * with the Node's resources locked for writing, so it must not call
+ * back into the library, which would deadlock.
+ *
+ * If the patch doesn't fit in the buffer, the callback should set
+ * @p size to the size required, including the terminator, and the
+ * callback is then made once more with a buffer of that size. If the
+ * patch still doesn't fit, or isn't null-terminated, the SDP data is
+ * not accepted.
+ *
+ * @param[in]     server A pointer to the server issuing the callback.
+ * @param[in]     type   The resource type, "source", "flow" or
+ *                       "receiver".
+ * @param[in]     sdp    The Session Description Protocol data of the
+ *                       sender or receiver.
+ * @param[out]    patch  A buffer for a null-terminated JSON Merge Patch
+ *                       (RFC 7396) to apply to the resource data, e.g.
+ *                       {"grain_rate": {"numerator": 50, "denominator": 1}}.
+ *                       May be left empty in which case the minimal
+ *                       resource data is used.
+ * @param[in,out] size   The size of the @p patch buffer, which may
+ *                       receive the size required.
+ * @return Whether the SDP data is acceptable.
+ */
+typedef bool (* nmos_format_resource_callback)(
+    NvNmosNodeServer *server,
+    const char *type,
+    const char *sdp,
+    char *patch,
+    unsigned int *size);
+
 typedef struct _NvNmosAssetConfig NvNmosAssetConfig;
+typedef struct _NvNmosDiscoveryConfig NvNmosDiscoveryConfig;
+typedef struct _NvNmosFormatConfig NvNmosFormatConfig;
+typedef struct _NvNmosPtpStatusConfig NvNmosPtpStatusConfig;
 typedef struct _NvNmosReceiverConfig NvNmosReceiverConfig;
+typedef struct _NvNmosReplicationConfig NvNmosReplicationConfig;
 typedef struct _NvNmosSenderConfig NvNmosSenderConfig;
 
 /**
@@ -218,6 +379,137 @@ typedef struct _NvNmosNodeConfig
     const char **log_categories;
     /** Holds the number of #log_categories. May be zero. */
     unsigned int num_log_categories;
+
+    /* The following members have been added since the first version of
+       this structure, and are appended so that the members above keep
+       their offsets. */
+
+    /** Holds DNS Service Discovery settings. May be null in which case
+        the Node API is advertised, and the Registration API is discovered,
+        in the domain determined from the #host_name. */
+    NvNmosDiscoveryConfig* discovery;
+
+    /** Holds the custom formats, in addition to the built-in ones, i.e.
+        "video/raw", "audio/L24", "audio/L16", "video/smpte291" and
+        "video/SMPTE2022-6". The array's size must be equal to
+        #num_formats. May be null. */
+    NvNmosFormatConfig *formats;
+    /** Holds the number of #formats. May be zero. */
+    unsigned int num_formats;
+
+    /** Holds the number of times an activation which could not be applied
+        is retried, after its rollback. If a retry succeeds, the IS-05
+        Connection API /active endpoint is updated to that activation,
+        unless the sender or receiver has been activated again since.
+        May be zero in which case failed activations are not retried. */
+    unsigned int activation_retries;
+    /** Holds the interval in milliseconds before the first retry, which
+        is doubled after each further attempt. May be zero in which case
+        the default, 100, is used. */
+    unsigned int activation_retry_interval;
+
+    /** Holds whether the library's own periodic work, i.e. applying
+        queued activations, retrying failed activations, monitoring the
+        data plane liveness, the network interfaces' link state and the
+        PTP status, publishing the change feed, accounting for the
+        registration requests, and publishing or applying the
+        replication stream,
+        is driven by the application's event loop using
+        @ref nmos_run_once and @ref nmos_get_poll_fds rather than by
+        internal threads.
+        The threads of the underlying NMOS implementation remain, i.e.
+        the HTTP listeners, the scheduled IS-05 activations, the
+        registration and heartbeats, and the DNS-SD advertisement and
+        browsing, as does the HTTP and WebSocket thread pool, which is
+        shared by the whole process, see
+        @ref NvNmosNodeConfig::http_threads.
+        Cannot be used with @ref NvNmosDiscoveryConfig::query_api,
+        whose cache is maintained by its own thread. */
+    bool external_event_loop;
+    /** Holds the number of threads used to handle HTTP and WebSocket
+        requests. This is shared by the whole process and can only be set
+        before it is first used. May be zero in which case the default
+        is used. */
+    unsigned int http_threads;
+
+    /** Holds the number of activations which may be queued using
+        @ref nmos_connection_rtp_activate_async. The storage for each
+        is preallocated. May be zero in which case the asynchronous
+        activation is disabled. */
+    unsigned int activation_queue_size;
+    /** Holds the maximum size in bytes of the Session Description
+        Protocol data of each queued activation. May be zero in which
+        case the default, 16384, is used. */
+    unsigned int activation_queue_sdp_size;
+    /** Holds the callback for handling the completion of a queued
+        activation. May be null. */
+    nmos_connection_rtp_activation_completed_callback rtp_connection_activation_completed;
+
+    /** Holds the deadline in milliseconds within which the data plane
+        must call @ref nmos_data_plane_alive again. If the deadline is
+        missed, the senders and receivers are advertised as inactive
+        until the data plane is alive again. May be zero in which case
+        the data plane liveness is not monitored. */
+    unsigned int data_plane_timeout;
+
+    /** Holds whether to defer rendering each sender's transport file
+        until it is first requested, rather than on every activation.
+        This makes the activation of many senders at once cheaper. */
+    bool lazy_transport_files;
+
+    /** Holds whether to monitor the link state of the network interfaces,
+        e.g. using netlink on Linux, so that the link state of each leg of
+        the senders and receivers is advertised in their
+        "urn:x-nvnmos:link-state" tag, and the node's interfaces are
+        updated as soon as their addresses change. An interface whose
+        link is down remains in the node. */
+    bool monitor_links;
+    /** Holds the callback for handling a change of the link state of
+        a leg of a sender or receiver. Only used if #monitor_links is
+        set. May be null. */
+    nmos_link_state_callback link_state_changed;
+    /** Holds whether the link state events are pushed by the application
+        via @ref nmos_link_state_event, e.g. for testing, rather than
+        received from the operating system. Only used if #monitor_links
+        is set. */
+    bool application_link_events;
+
+    /** Holds settings for monitoring the PTP status directly. May be null
+        in which case the node clock is derived from the 'ts-refclk'
+        attributes of the senders' Session Description Protocol data. */
+    NvNmosPtpStatusConfig* ptp_status;
+
+    /** Holds the lowest UDP port number that may be requested for the
+        source or destination port of a sender, or the destination port of
+        a receiver, via the IS-05 Connection API. May be zero in which case
+        there is no minimum, unless #rtp_port_max is set. */
+    unsigned int rtp_port_min;
+    /** Holds the highest UDP port number that may be requested via the
+        IS-05 Connection API. May be zero in which case there is no
+        maximum, unless #rtp_port_min is set. The configured ports of the
+        senders and receivers must be in the range. */
+    unsigned int rtp_port_max;
+    /** Holds whether only source-specific multicast addresses, i.e.
+        232.0.0.0/8 or ff3x::/32, may be requested for the destination
+        address of a sender, or the multicast address of a receiver,
+        via the IS-05 Connection API. */
+    bool ssm_only;
+
+    /** Holds settings for replicating the node's state to a hot-standby
+        server on the same host, or for running as that standby. May be
+        null in which case there is no replication. */
+    NvNmosReplicationConfig* replication;
+
+    /** Holds the callback for handling each change to the Node's
+        resources. May be null. The feed starts with a "resync" and can
+        be resynchronized using @ref nmos_resync_change_feed. */
+    nmos_change_feed_callback change_feed;
+
+    /** Holds whether to account for the Registration API requests caused
+        by each operation, which are reported in the "registry" metrics
+        by @ref nmos_get_metrics. This has a cost on every change to the
+        Node's resources, so is disabled by default. */
+    bool registry_accounting;
 } NvNmosNodeConfig;
 
 /**
@@ -240,6 +532,137 @@ typedef struct _NvNmosAssetConfig
     unsigned int num_functions;
 } NvNmosAssetConfig;
 
+/**
+ * Defines DNS Service Discovery (DNS-SD) settings for an
+ * @ref NvNmosNodeServer.
+ *
+ * In large deployments, the multicast DNS traffic due to every node
+ * advertising and browsing can be avoided by disabling the Node API
+ * advertisement and either using unicast DNS-SD or specifying the
+ * Registration API directly.
+ *
+ * The structure should be zero initialized.
+ */
+typedef struct _NvNmosDiscoveryConfig
+{
+    /** Holds the domain in which to discover the Registration API, e.g.
+        "example.com." to use unicast DNS-SD only, or "local." to use
+        multicast DNS (mDNS). May be null in which case the domain is
+        determined from the @ref NvNmosNodeConfig::host_name. */
+    const char *domain;
+    /** Holds whether to disable the DNS-SD advertisement of the Node API.
+        The Node API is then only discoverable via a Registry. */
+    bool disable_node_advertisement;
+    /** Holds the host name or IP address of the Registration API, e.g.
+        "registry.example.com". May be null in which case the
+        Registration API is discovered via DNS-SD. Otherwise, DNS-SD
+        browsing is disabled. */
+    const char *registry_address;
+    /** Holds the port number of the Registration API, e.g. 80. May be
+        zero in which case the default port is used. */
+    unsigned int registry_port;
+    /** Holds the minimum interval in seconds between DNS-SD browsing
+        attempts while no Registration API is available. May be zero in
+        which case the default is used. */
+    unsigned int backoff_min;
+    /** Holds the maximum interval in seconds between DNS-SD browsing
+        attempts while no Registration API is available. May be zero in
+        which case the default is used. */
+    unsigned int backoff_max;
+    /** Holds the base URL of a Query API, e.g.
+        "http://registry.example.com/x-nmos/query/v1.3". May be null in
+        which case remote senders are not cached. Otherwise, a WebSocket
+        subscription is used to maintain a cache of the remote senders'
+        transport files, so that a receiver which is activated with a
+        sender_id but no transport file can be configured immediately.
+        Must be null if @ref NvNmosNodeConfig::external_event_loop is
+        set. */
+    const char *query_api;
+} NvNmosDiscoveryConfig;
+
+/**
+ * Defines a custom format of the senders and receivers in an
+ * @ref NvNmosNodeServer, identified by the media type in their Session
+ * Description Protocol data.
+ *
+ * The IS-04 resources are created with minimal data for the format,
+ * which is completed by the #make_resource callback. Specifying a
+ * built-in media type replaces the built-in handling.
+ */
+typedef struct _NvNmosFormatConfig
+{
+    /** Holds the media type, e.g. "video/jxsv". Must not be null. */
+    const char *media_type;
+    /** Holds the IS-04 format, i.e. "urn:x-nmos:format:video",
+        "urn:x-nmos:format:audio", "urn:x-nmos:format:data" or
+        "urn:x-nmos:format:mux". Must not be null. */
+    const char *format;
+    /** Holds the callback for completing the resource data. May be null
+        in which case the minimal resource data is used. */
+    nmos_format_resource_callback make_resource;
+} NvNmosFormatConfig;
+
+/**
+ * Defines settings for monitoring the status of the local PTP instance,
+ * so that the node clock's grandmaster, traceability and lock state
+ * are kept up-to-date.
+ * The structure should be zero initialized.
+ */
+typedef struct _NvNmosPtpStatusConfig
+{
+    /** Holds the path of the UNIX domain socket of the linuxptp ptp4l
+        instance, e.g. "/var/run/ptp4l", which is queried using PTP
+        management messages like 'pmc -u'. Alternatively, "file:" and the
+        path of a JSON file, e.g. {"gmid": "ac-de-48-23-45-67-01-9f",
+        "domain": 0, "locked": true, "traceable": false}, which can be
+        written by other tools. Must not be null. */
+    const char *path;
+    /** Holds the PTP domain number of the ptp4l instance. */
+    unsigned int domain;
+    /** Holds the polling interval in milliseconds. The node clock and
+        the senders' transport files are only updated when the status
+        changes. May be zero in which case the default is used. */
+    unsigned int interval;
+} NvNmosPtpStatusConfig;
+
+/**
+ * Defines settings for hot-standby replication between two NMOS Node
+ * servers with the same configuration on the same host.
+ *
+ * The primary publishes each change made by the application, and the
+ * latest state of the IS-05 Connection API and node resources however
+ * they were changed, e.g. by a controller. The standby applies these
+ * to its own model, so that it can take over with the same resources
+ * and active connections, without opening its APIs or registering
+ * until it is promoted.
+ *
+ * The structure should be zero initialized.
+ */
+typedef struct _NvNmosReplicationConfig
+{
+    /** Holds the path of the UNIX domain socket on which the primary
+        publishes its state, e.g. "/run/nvnmos-replication.sock".
+        Must not be null. The primary also holds a lock on a file with
+        the same path and the suffix ".lock", so that the standby can
+        tell whether it is still alive, and a second primary cannot
+        replace its socket. */
+    const char *socket_path;
+    /** Holds whether this server is the standby rather than the primary.
+        The senders and receivers are replicated from the primary, so the
+        application need not add them to the standby; any that it does
+        add which already exist are reported as
+        @ref NVNMOS_STATUS_DUPLICATE_ID. Callbacks are not made until the
+        standby has been promoted. */
+    bool standby;
+    /** Holds whether the standby is promoted automatically when the
+        primary has been lost, i.e. it can no longer be connected to and
+        no longer holds its lock. A standby which is disconnected for any
+        other reason, e.g. because it could not keep up, reconnects for a
+        fresh snapshot instead. Otherwise, it must be promoted using
+        @ref nmos_promote_node_server. */
+    bool auto_promote;
+} NvNmosReplicationConfig;
+
 /**
  * Defines configuration settings used to create receivers in an
  * @ref NvNmosNodeServer.
@@ -279,6 +702,40 @@ typedef struct _NvNmosSenderConfig
     const char *sdp;
 } NvNmosSenderConfig;
 
+/**
+ * Defines the times at which the phases of starting an
+ * @ref NvNmosNodeServer completed, so that the time until the Node is
+ * visible in the Registry can be broken down.
+ *
+ * Except for #start, each holds the time in nanoseconds after #start,
+ * or -1 if the phase has not (yet) completed.
+ */
+typedef struct _NvNmosStartupTimes
+{
+    /** Holds the time at which @ref create_nmos_node_server was called,
+        in nanoseconds of the monotonic clock, i.e. CLOCK_MONOTONIC on
+        Linux, so that it can be related to the start of the process. */
+    int64_t start;
+    /** Holds the time at which the settings had been constructed from
+        the configuration. */
+    int64_t settings;
+    /** Holds the time at which the server and its APIs had been set up. */
+    int64_t server;
+    /** Holds the time at which the node and device resources had been
+        created. */
+    int64_t init;
+    /** Holds the time at which the configured senders and receivers had
+        been added. */
+    int64_t resources;
+    /** Holds the time at which the API ports had been opened. For a
+        standby server, this is when it was promoted. */
+    int64_t open;
+    /** Holds the time at which the Node first started registered
+        operation, including the DNS-SD discovery of the Registration
+        API, if required. */
+    int64_t registered;
+} NvNmosStartupTimes;
+
 /**
  * Holds the implementation details of a running NvNmos server.
  * The structure should be zero initialized, with the possible
@@ -304,6 +761,9 @@ typedef struct _NvNmosNodeServer
  *
  * The server should be deinitialized using @ref destroy_nmos_node_server.
  *
+ * A standby server, see @ref NvNmosNodeConfig::replication, is not
+ * started until it is promoted.
+ *
  * @param[in] config Pointer to the configuration settings.
  * @param[in] server Pointer to the server to be initialized.
  * @return Whether the server has been created and successfully started.
@@ -341,6 +801,18 @@ bool add_nmos_receiver_to_node_server(
     NvNmosNodeServer *server,
     const NvNmosReceiverConfig* config);
 
+/**
+ * Like @ref add_nmos_receiver_to_node_server, but indicates the reason
+ * for failure.
+ *
+ * @return @ref NVNMOS_STATUS_OK if the receiver has been successfully
+ *         added.
+ */
+NVNMOS_API
+NvNmosStatus add_nmos_receiver_to_node_server_ex(
+    NvNmosNodeServer *server,
+    const NvNmosReceiverConfig* config);
+
 /**
  * Remove an NMOS Receiver from an NMOS Node server.
  *
@@ -356,6 +828,18 @@ bool remove_nmos_receiver_from_node_server(
     NvNmosNodeServer *server,
     const char* id);
 
+/**
+ * Like @ref remove_nmos_receiver_from_node_server, but indicates the
+ * reason for failure.
+ *
+ * @return @ref NVNMOS_STATUS_OK if the receiver has been successfully
+ *         removed.
+ */
+NVNMOS_API
+NvNmosStatus remove_nmos_receiver_from_node_server_ex(
+    NvNmosNodeServer *server,
+    const char* id);
+
 /**
  * Add an NMOS Sender to an NMOS Node server according to the
  * specified configuration settings.
@@ -371,6 +855,18 @@ bool add_nmos_sender_to_node_server(
     NvNmosNodeServer *server,
     const NvNmosSenderConfig* config);
 
+/**
+ * Like @ref add_nmos_sender_to_node_server, but indicates the reason
+ * for failure.
+ *
+ * @return @ref NVNMOS_STATUS_OK if the sender has been successfully
+ *         added.
+ */
+NVNMOS_API
+NvNmosStatus add_nmos_sender_to_node_server_ex(
+    NvNmosNodeServer *server,
+    const NvNmosSenderConfig* config);
+
 /**
  * Remove an NMOS Sender from an NMOS Node server.
  *
@@ -386,6 +882,79 @@ bool remove_nmos_sender_from_node_server(
     NvNmosNodeServer *server,
     const char* id);
 
+/**
+ * Like @ref remove_nmos_sender_from_node_server, but indicates the
+ * reason for failure.
+ *
+ * @return @ref NVNMOS_STATUS_OK if the sender has been successfully
+ *         removed.
+ */
+NVNMOS_API
+NvNmosStatus remove_nmos_sender_from_node_server_ex(
+    NvNmosNodeServer *server,
+    const char* id);
+
+/**
+ * Add NMOS Receivers and NMOS Senders to an NMOS Node server according
+ * to the specified configuration settings, in a single update.
+ *
+ * This is faster than adding each receiver and sender individually.
+ * If an error occurs, the receivers and senders that have already been
+ * added are not removed.
+ *
+ * @param[in] server        Pointer to the server to update.
+ * @param[in] receivers     Pointer to the configuration settings for the
+ *                          receivers. The array's size must be equal to
+ *                          @p num_receivers. May be null if
+ *                          @p num_receivers is zero.
+ * @param[in] num_receivers The number of @p receivers. May be zero.
+ * @param[in] senders       Pointer to the configuration settings for the
+ *                          senders. The array's size must be equal to
+ *                          @p num_senders. May be null if
+ *                          @p num_senders is zero.
+ * @param[in] num_senders   The number of @p senders. May be zero.
+ * @return Whether the receivers and senders have been successfully added.
+ */
+NVNMOS_API
+bool add_nmos_receivers_and_senders_to_node_server(
+    NvNmosNodeServer *server,
+    const NvNmosReceiverConfig *receivers,
+    unsigned int num_receivers,
+    const NvNmosSenderConfig *senders,
+    unsigned int num_senders);
+
+/**
+ * Like @ref add_nmos_receivers_and_senders_to_node_server, but indicates
+ * the reason for failure of the first receiver or sender which could
+ * not be added.
+ *
+ * @return @ref NVNMOS_STATUS_OK if the receivers and senders have been
+ *         successfully added.
+ */
+NVNMOS_API
+NvNmosStatus add_nmos_receivers_and_senders_to_node_server_ex(
+    NvNmosNodeServer *server,
+    const NvNmosReceiverConfig *receivers,
+    unsigned int num_receivers,
+    const NvNmosSenderConfig *senders,
+    unsigned int num_senders);
+
+/**
+ * Remove all NMOS Receivers and NMOS Senders from an NMOS Node server,
+ * in a single update.
+ *
+ * The node and device, the API ports and the registration of the node
+ * are unaffected, so this is much faster than destroying and creating
+ * the server again. New receivers and senders may be added immediately,
+ * e.g. using @ref add_nmos_receivers_and_senders_to_node_server.
+ *
+ * @param[in] server Pointer to the server to update.
+ * @return Whether the receivers and senders have been successfully removed.
+ */
+NVNMOS_API
+bool reset_nmos_node_server(
+    NvNmosNodeServer *server);
+
 /**
  * Update the configuration settings of a sender or receiver.
  *
@@ -418,6 +987,312 @@ bool nmos_connection_rtp_activate(
     const char *id,
     const char *sdp);
 
+/**
+ * Like @ref nmos_connection_rtp_activate, but indicates the reason for
+ * failure.
+ *
+ * @return @ref NVNMOS_STATUS_OK if the update has been successfully
+ *         applied.
+ */
+NVNMOS_API
+NvNmosStatus nmos_connection_rtp_activate_ex(
+    NvNmosNodeServer *server,
+    const char *id,
+    const char *sdp);
+
+/**
+ * Update the configuration settings of a sender or receiver
+ * asynchronously, e.g. from a real-time thread.
+ *
+ * The request is copied into a preallocated queue without taking any
+ * locks or allocating memory, and the call returns immediately.
+ * The queued activations are applied in order by a library thread,
+ * within about a millisecond. Only the latest of several queued
+ * activations for the same sender or receiver is applied.
+ * The completion is reported via
+ * @ref NvNmosNodeConfig::rtp_connection_activation_completed.
+ *
+ * @param[in] server A pointer to the server to be updated.
+ * @param[in] id     The unique identifier for the sender or receiver,
+ *                   as for @ref nmos_connection_rtp_activate.
+ * @param[in] sdp    The updated Session Description Protocol data,
+ *                   as for @ref nmos_connection_rtp_activate, or a null
+ *                   pointer when the sender or receiver is being
+ *                   deactivated.
+ * @return Whether the activation has been queued. It is not queued if
+ *         @ref NvNmosNodeConfig::activation_queue_size is zero, the
+ *         queue is full, or the data is larger than
+ *         @ref NvNmosNodeConfig::activation_queue_sdp_size.
+ */
+NVNMOS_API
+bool nmos_connection_rtp_activate_async(
+    NvNmosNodeServer *server,
+    const char *id,
+    const char *sdp);
+
+/**
+ * Run the library's periodic work from the application's event loop.
+ *
+ * The server must have been configured with
+ * @ref NvNmosNodeConfig::external_event_loop set. Work that is due,
+ * or whose file descriptor from @ref nmos_get_poll_fds is readable, is
+ * run on the calling thread. If none is, the call first waits up to the
+ * timeout for some to become so.
+ * This must not be called concurrently for the same server.
+ *
+ * @param[in] server  Pointer to the server.
+ * @param[in] timeout The maximum time to wait in milliseconds. May be
+ *                    zero, e.g. when the application's own poller has
+ *                    just indicated that a file descriptor is readable.
+ * @return Whether the work has been successfully run.
+ */
+NVNMOS_API
+bool nmos_run_once(
+    NvNmosNodeServer *server,
+    unsigned int timeout);
+
+/**
+ * Get the file descriptors and timeout with which to integrate the
+ * library's periodic work into the application's poller.
+ *
+ * The application should call @ref nmos_run_once with a zero timeout
+ * when any of the file descriptors is readable, or the timeout expires.
+ * The results change after each call to @ref nmos_run_once.
+ *
+ * @param[in]     server  Pointer to the server.
+ * @param[out]    fds     Pointer to an array to receive the file
+ *                        descriptors. May be null if @p num_fds is zero.
+ * @param[in,out] num_fds The size of the @p fds array, which receives
+ *                        the number of file descriptors. If the array
+ *                        is too small, the call fails but the required
+ *                        size is still returned.
+ * @param[out]    timeout Receives the time in milliseconds until some
+ *                        work is due, or -1 if none is scheduled.
+ * @return Whether the file descriptors and timeout have been returned.
+ */
+NVNMOS_API
+bool nmos_get_poll_fds(
+    NvNmosNodeServer *server,
+    int *fds,
+    unsigned int *num_fds,
+    int *timeout);
+
+/**
+ * Indicate that the data plane is alive.
+ *
+ * When the server has been configured with a non-zero
+ * @ref NvNmosNodeConfig::data_plane_timeout, this must be called
+ * repeatedly within that deadline, otherwise the senders and receivers
+ * are advertised as inactive. The call is cheap enough to make for
+ * every frame.
+ *
+ * @param[in] server Pointer to the server.
+ * @return Whether the indication has been successfully recorded.
+ */
+NVNMOS_API
+bool nmos_data_plane_alive(
+    NvNmosNodeServer *server);
+
+/**
+ * Indicate that the network link of an interface has gone down or come up
+ * again.
+ *
+ * The server must have been configured with
+ * @ref NvNmosNodeConfig::monitor_links and
+ * @ref NvNmosNodeConfig::application_link_events. The event is applied
+ * asynchronously, in the same way as one received from the operating
+ * system, so the @ref NvNmosNodeConfig::link_state_changed callback is
+ * called for each affected leg of the senders and receivers.
+ *
+ * @param[in] server         Pointer to the server.
+ * @param[in] interface_name The name of the network interface, e.g. "eth0".
+ * @param[in] up             Whether the link is now up.
+ * @return Whether the event has been successfully recorded.
+ */
+NVNMOS_API
+bool nmos_link_state_event(
+    NvNmosNodeServer *server,
+    const char *interface_name,
+    bool up);
+
+/**
+ * Resynchronize the change feed, e.g. when the external mirror has
+ * restarted or missed changes.
+ *
+ * The server must have been configured with a
+ * @ref NvNmosNodeConfig::change_feed callback. A "resync" is delivered
+ * before any further changes.
+ *
+ * @param[in] server Pointer to the server.
+ * @return Whether the resynchronization has been requested.
+ */
+NVNMOS_API
+bool nmos_resync_change_feed(
+    NvNmosNodeServer *server);
+
+/**
+ * Get a digest of the state of the NMOS Node, which changes whenever
+ * any of its resources changes, so that a monitoring system only needs
+ * to get the resources themselves when it does.
+ *
+ * The same digest is available from the custom endpoint
+ * /x-nvnmos/state on the Connection API port, which also supports
+ * conditional requests using the 'If-None-Match' header.
+ *
+ * @param[in]  server Pointer to the server.
+ * @param[out] digest Pointer to an array of
+ *                    @ref NVNMOS_STATE_DIGEST_SIZE bytes to receive
+ *                    the digest.
+ * @return Whether the digest has been returned.
+ */
+NVNMOS_API
+bool nmos_get_state_digest(
+    NvNmosNodeServer *server,
+    unsigned char *digest);
+
+/**
+ * Get the metrics of the NMOS Node server, serialized as JSON.
+ *
+ * The "http" metrics hold, for each HTTP method, route template, e.g.
+ * "/x-nmos/node/{version}/senders/{id}", and response status class,
+ * e.g. "2xx", the count of requests, the "sum" of their latency in
+ * seconds, and the counts of requests in each latency bucket, whose
+ * upper bounds are the "bucket_bounds", with a final bucket for
+ * anything slower. Requests to any other path, and any requests that
+ * are not found, are counted together as method "*" and route "*".
+ *
+ * The "registry" metrics, only if @ref NvNmosNodeConfig::registry_accounting
+ * is set, hold, for each operation, e.g. "add_sender", the number of
+ * "operations", and the number of Registration API "post" and "delete"
+ * requests and their "bytes" caused by them, in total and for each
+ * resource "types". The requests are derived from the changes to the
+ * Node's resources made during each operation, whether or not the Node
+ * is registered. Changes made at other times, e.g. by a Controller, are
+ * attributed to "other". The changes are attributed by time rather than
+ * by thread, so a change made while operations on several threads are
+ * in progress is attributed to whichever began first, and an activation
+ * applied from the queue of @ref nmos_connection_rtp_activate_async is
+ * attributed to whichever operation is in progress, if any.
+ *
+ * The "sdp_cache" metrics hold the number of "hits" and "misses" of
+ * the cache of parsed transport files staged via the IS-05 Connection
+ * API, and its current "size" and "capacity".
+ *
+ * The same metrics are available from the custom endpoint
+ * /x-nvnmos/metrics on the Connection API port.
+ *
+ * @param[in]     server Pointer to the server.
+ * @param[out]    buffer Pointer to a buffer to receive the
+ *                       null-terminated JSON. May be null if @p size
+ *                       is zero.
+ * @param[in,out] size   The size of the @p buffer, which receives the
+ *                       size required, including the terminator. If the
+ *                       buffer is too small, the call fails but the
+ *                       required size is still returned.
+ * @return Whether the metrics have been returned.
+ */
+NVNMOS_API
+bool nmos_get_metrics(
+    NvNmosNodeServer *server,
+    char *buffer,
+    unsigned int *size);
+
+/**
+ * Get the times at which the phases of starting the NMOS Node server
+ * completed. The same times are logged when the API ports have been
+ * opened, and when the Node first starts registered operation.
+ *
+ * @param[in]  server Pointer to the server.
+ * @param[out] times  Pointer to receive the times.
+ * @return Whether the times have been returned.
+ */
+NVNMOS_API
+bool nmos_get_startup_times(
+    NvNmosNodeServer *server,
+    NvNmosStartupTimes *times);
+
+/**
+ * Find the receivers which are currently active and connected to the
+ * specified sender, according to their IS-05 Connection API /active
+ * endpoints, e.g. to react when that sender changes or fails.
+ *
+ * The receivers are found from an index which is updated as each
+ * receiver's /active endpoint is changed, however it was changed, so
+ * the cost of a call grows only with the number of receivers found,
+ * plus a lookup that is logarithmic in the number of senders or groups.
+ * The index has its own lock, and the Node's resources are not locked,
+ * so this may also be called from a callback which is made while they
+ * are, e.g. @ref nmos_connection_rtp_activation_callback, in which case
+ * the activation being applied is not yet reflected. The callback is
+ * made for each receiver after the index has been released, so it may
+ * call back into the library.
+ *
+ * @param[in] server    Pointer to the server.
+ * @param[in] sender_id The IS-04 resource id of the sender, which is
+ *                      normally a remote sender.
+ * @param[in] callback  The callback to make for each receiver.
+ * @param[in] context   A pointer passed to each callback. May be null.
+ * @return Whether the receivers have been found, which is also true
+ *         if there are none.
+ */
+NVNMOS_API
+bool nmos_find_receivers_by_sender(
+    NvNmosNodeServer *server,
+    const char *sender_id,
+    nmos_receiver_enumeration_callback callback,
+    void *context);
+
+/**
+ * Find the receivers which are currently active and have joined the
+ * specified multicast group on any enabled leg, according to their
+ * IS-05 Connection API /active endpoints.
+ *
+ * The receivers are found in the same way as by
+ * @ref nmos_find_receivers_by_sender.
+ *
+ * @param[in] server   Pointer to the server.
+ * @param[in] group    The multicast address, e.g. "232.1.2.3", in the
+ *                     same form as the 'multicast_ip' transport
+ *                     parameter.
+ * @param[in] callback The callback to make for each receiver.
+ * @param[in] context  A pointer passed to each callback. May be null.
+ * @return Whether the receivers have been found, which is also true
+ *         if there are none.
+ */
+NVNMOS_API
+bool nmos_find_receivers_by_group(
+    NvNmosNodeServer *server,
+    const char *group,
+    nmos_receiver_enumeration_callback callback,
+    void *context);
+
+/**
+ * Promote a standby NMOS Node server to be the primary.
+ *
+ * The replicated state is taken over as is, the APIs are opened and
+ * registration is resumed. The server then publishes its own state
+ * for a new standby.
+ *
+ * Before the APIs are opened, the activation callback,
+ * @ref NvNmosNodeConfig::rtp_connection_activated, is made for each
+ * replicated sender and receiver which is active, so that the
+ * application can configure its data plane to match. If it fails,
+ * the activation is rolled back, and retried, in the same way as an
+ * IS-05 Connection API activation.
+ *
+ * The application must not add or remove senders or receivers
+ * concurrently with this call. If the server has been configured with
+ * @ref NvNmosNodeConfig::external_event_loop, it must not be called
+ * concurrently with @ref nmos_run_once either, since until then that
+ * applies the replication stream.
+ *
+ * @param[in] server Pointer to the server.
+ * @return Whether the server is now the primary.
+ */
+NVNMOS_API
+bool nmos_promote_node_server(
+    NvNmosNodeServer *server);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_activation_queue.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace nvnmos
+{
+    activation_queue::activation_queue(size_t size, size_t max_sdp_size, size_t max_id_size)
+        : max_sdp_size(max_sdp_size)
+        , max_id_size(max_id_size)
+        , enqueue_pos(0)
+        , dequeue_pos(0)
+#ifdef __linux__
+        , fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+#else
+        , fd(-1)
+#endif
+        , signalled(false)
+    {
+        size_t capacity = 2;
+        while (capacity < size) capacity <<= 1;
+        mask = capacity - 1;
+
+        cells.reset(new cell[capacity]);
+        for (size_t i = 0; i != capacity; ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+            // reserve the storage up front, so that copying a request into the cell never allocates
+            cells[i].id.reserve(max_id_size);
+            cells[i].sdp.reserve(max_sdp_size);
+        }
+    }
+
+    activation_queue::~activation_queue()
+    {
+#ifdef __linux__
+        if (-1 != fd) close(fd);
+#endif
+    }
+
+    // copy the request into the queue, returning false if it is full or the request is too large
+    // a null sdp, like an empty one, indicates the sender or receiver is being deactivated
+    bool activation_queue::push(const char* id, const char* sdp)
+    {
+        const auto id_size = std::strlen(id);
+        const auto sdp_size = 0 != sdp ? std::strlen(sdp) : 0;
+        if (max_id_size < id_size || max_sdp_size < sdp_size) return false;
+
+        cell* c;
+        auto pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            c = &cells[pos & mask];
+            const auto seq = c->sequence.load(std::memory_order_acquire);
+            const auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (0 == diff)
+            {
+                // the cell is free, so try to claim it
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (0 > diff)
+            {
+                // the queue is full
+                return false;
+            }
+            else
+            {
+                // another producer claimed the cell first
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        c->id.assign(id, id_size);
+        c->sdp.assign(0 != sdp ? sdp : "", sdp_size);
+        c->sequence.store(pos + 1, std::memory_order_release);
+
+        // wake the consumer, unless a previous push has already done so since it last waited
+        // writing to a non-blocking eventfd doesn't block, so this is still safe for a real-time thread
+#ifdef __linux__
+        if (-1 != fd && !signalled.exchange(true, std::memory_order_acq_rel))
+        {
+            const std::uint64_t one = 1;
+            (void)write(fd, &one, sizeof(one));
+        }
+#endif
+        return true;
+    }
+
+    // copy the oldest request out of the queue, returning false if it is empty
+    bool activation_queue::pop(std::string& id, std::string& sdp)
+    {
+        cell* c;
+        auto pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            c = &cells[pos & mask];
+            const auto seq = c->sequence.load(std::memory_order_acquire);
+            const auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+            if (0 == diff)
+            {
+                // the cell is full, so try to claim it
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (0 > diff)
+            {
+                // the queue is empty
+                return false;
+            }
+            else
+            {
+                // another consumer claimed the cell first
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        id.assign(c->id);
+        sdp.assign(c->sdp);
+        c->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // wait up to the specified timeout for requests to be submitted, returning false if the timeout expires
+    // the consumer must then pop all the requests, since the next push may not signal again until it has
+    bool activation_queue::wait_for(std::chrono::milliseconds timeout)
+    {
+#ifdef __linux__
+        if (-1 != fd)
+        {
+            if (!signalled.load(std::memory_order_acquire))
+            {
+                pollfd pfd{ fd, POLLIN, 0 };
+                if (0 >= poll(&pfd, 1, (int)timeout.count())) return false;
+            }
+
+            // reset the eventfd before clearing the flag, so that a push after this is signalled again
+            std::uint64_t count;
+            (void)read(fd, &count, sizeof(count));
+            return signalled.exchange(false, std::memory_order_acq_rel);
+        }
+#endif
+        // without an eventfd, the queue positions are polled, which doesn't need any lock
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;)
+        {
+            if (enqueue_pos.load(std::memory_order_acquire) != dequeue_pos.load(std::memory_order_acquire)) return true;
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
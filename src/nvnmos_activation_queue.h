@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_ACTIVATION_QUEUE_H
+#define NVNMOS_ACTIVATION_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace nvnmos
+{
+    // Bounded multi-producer multi-consumer queue of 'internal' activations, into which a real-time thread can submit
+    // an activation without taking a lock or allocating memory, since the storage for each request is preallocated
+    // See https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+    class activation_queue
+    {
+    public:
+        // the size is rounded up to a power of two; requests whose id or SDP data exceed the maximum sizes are rejected
+        activation_queue(size_t size, size_t max_sdp_size, size_t max_id_size = 256);
+        ~activation_queue();
+
+        // copy the request into the queue, returning false if it is full or the request is too large
+        // a null sdp, like an empty one, indicates the sender or receiver is being deactivated
+        bool push(const char* id, const char* sdp);
+
+        // copy the oldest request out of the queue, returning false if it is empty
+        bool pop(std::string& id, std::string& sdp);
+
+        // wait up to the specified timeout for requests to be submitted, returning false if the timeout expires
+        // the consumer must then pop all the requests, since the next push may not signal again until it has
+        bool wait_for(std::chrono::milliseconds timeout);
+
+        // get a file descriptor which is readable when requests have been submitted, or -1 if there isn't one
+        // in which case the queue must be polled; once readable, the consumer must call wait_for with a zero timeout
+        int poll_fd() const { return fd; }
+
+    private:
+        struct cell
+        {
+            std::atomic<size_t> sequence;
+            std::string id;
+            std::string sdp;
+        };
+
+        const size_t max_sdp_size;
+        const size_t max_id_size;
+        size_t mask;
+        std::unique_ptr<cell[]> cells;
+
+        // producers and consumers each update their own position, so keep them in separate cache lines
+        alignas(64) std::atomic<size_t> enqueue_pos;
+        alignas(64) std::atomic<size_t> dequeue_pos;
+
+        // an eventfd, which is only written when the consumer may be waiting, so most pushes don't make a system call
+        int fd;
+        std::atomic<bool> signalled;
+    };
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This checks the activation queue, i.e. that requests from concurrent producers all arrive, in order for each producer,
+// that requests are rejected when the queue is full or they are too large, and that the consumer is woken after draining it
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "nvnmos_activation_queue.h"
+
+namespace
+{
+    bool check(bool condition, const char* description)
+    {
+        if (!condition) std::fprintf(stderr, "Failed: %s\n", description);
+        return condition;
+    }
+
+    bool test_full()
+    {
+        nvnmos::activation_queue queue(4, 64);
+
+        bool success = true;
+        for (int i = 0; i < 4; ++i)
+        {
+            success = check(queue.push(("receiver-" + std::to_string(i)).c_str(), "v=0\r\n"), "push while not full") && success;
+        }
+        success = check(!queue.push("receiver-4", "v=0\r\n"), "push is rejected when full") && success;
+
+        // once a request has been popped, there is room for another
+        std::string id, sdp;
+        success = check(queue.pop(id, sdp) && "receiver-0" == id, "pop the oldest request") && success;
+        success = check(queue.push("receiver-4", "v=0\r\n"), "push after pop") && success;
+        return success;
+    }
+
+    bool test_oversize()
+    {
+        nvnmos::activation_queue queue(4, 8, 16);
+
+        bool success = true;
+        success = check(queue.push("receiver-0", "01234567"), "push at the maximum SDP size") && success;
+        success = check(!queue.push("receiver-0", "012345678"), "push over the maximum SDP size is rejected") && success;
+        success = check(queue.push("0123456789abcdef", ""), "push at the maximum id size") && success;
+        success = check(!queue.push("0123456789abcdefg", ""), "push over the maximum id size is rejected") && success;
+
+        // a rejected request doesn't take a cell
+        std::string id, sdp;
+        success = check(queue.pop(id, sdp) && "receiver-0" == id && "01234567" == sdp, "pop the first accepted request") && success;
+        success = check(queue.pop(id, sdp) && "0123456789abcdef" == id, "pop the second accepted request") && success;
+        success = check(!queue.pop(id, sdp), "pop when empty") && success;
+        return success;
+    }
+
+    bool test_null_sdp()
+    {
+        nvnmos::activation_queue queue(4, 64);
+
+        std::string id, sdp = "stale";
+        bool success = true;
+        success = check(queue.push("sender-0", nullptr), "push with null SDP data") && success;
+        success = check(queue.pop(id, sdp) && "sender-0" == id && sdp.empty(), "null SDP data is popped as empty") && success;
+        return success;
+    }
+
+    bool test_producers()
+    {
+        const int producers = 4;
+        const int requests = 10000;
+        nvnmos::activation_queue queue(16, 64);
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.push_back(std::thread([&queue, p, requests]
+            {
+                const auto id = "sender-" + std::to_string(p);
+                for (int i = 0; i < requests; ++i)
+                {
+                    const auto sdp = std::to_string(i);
+                    // the queue is much smaller than the number of requests, so the producers must wait for the consumer
+                    while (!queue.push(id.c_str(), sdp.c_str())) std::this_thread::yield();
+                }
+            }));
+        }
+
+        // each producer's requests arrive in the order they were pushed
+        std::vector<int> next(producers, 0);
+        int received = 0;
+        bool success = true;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (received < producers * requests && std::chrono::steady_clock::now() < deadline)
+        {
+            queue.wait_for(std::chrono::milliseconds(100));
+
+            std::string id, sdp;
+            while (queue.pop(id, sdp))
+            {
+                const auto p = std::stoi(id.substr(id.find('-') + 1));
+                success = check(0 <= p && p < producers && std::to_string(next[p]) == sdp, "requests from each producer arrive in order") && success;
+                if (0 <= p && p < producers) ++next[p];
+                ++received;
+            }
+        }
+
+        for (auto& thread : threads) thread.join();
+
+        success = check(producers * requests == received, "all requests arrive") && success;
+        return success;
+    }
+
+    bool test_wake_up()
+    {
+        nvnmos::activation_queue queue(4, 64);
+
+        bool success = true;
+        success = check(!queue.wait_for(std::chrono::milliseconds::zero()), "no wake-up before any push") && success;
+
+        success = check(queue.push("receiver-0", "v=0\r\n") && queue.wait_for(std::chrono::milliseconds(1000)), "wake-up after the first push") && success;
+
+        std::string id, sdp;
+        while (queue.pop(id, sdp)) {}
+
+        // after the consumer has drained the queue, the next push must wake it again, even from another thread
+        std::thread producer([&queue]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            queue.push("receiver-1", "v=0\r\n");
+        });
+        success = check(queue.wait_for(std::chrono::milliseconds(5000)), "wake-up after draining the queue") && success;
+        producer.join();
+        success = check(queue.pop(id, sdp) && "receiver-1" == id, "pop after wake-up") && success;
+        return success;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool success = true;
+    success = test_full() && success;
+    success = test_oversize() && success;
+    success = test_null_sdp() && success;
+    success = test_producers() && success;
+    success = test_wake_up() && success;
+
+    std::fprintf(stderr, "%s\n", success ? "Passed" : "Failed");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This checks the activation rollback, i.e. that the last accepted /active endpoint is only restored for the same connection resource,
+// that retries are replaced, taken when due and forgotten, and that the retry task backs off and then abandons a failing activation,
+// or abandons it immediately when the connection resource has been removed or updated since
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "nmos/connection_resources.h"
+#include "nmos/model.h"
+#include "nmos/version.h"
+#include "nvnmos_connection_index.h"
+#include "nvnmos_impl.h"
+#include "nvnmos_sdp_store.h"
+#include "nvnmos_transportfile.h"
+
+namespace
+{
+    bool check(bool condition, const char* description)
+    {
+        if (!condition) std::fprintf(stderr, "Failed: %s\n", description);
+        return condition;
+    }
+
+    // the abandoned retries are logged, but that isn't checked
+    class quiet_gate : public slog::base_gate
+    {
+    public:
+        virtual bool pertinent(slog::severity level) const { return false; }
+        virtual void log(const slog::log_message& message) const {}
+    };
+
+    nvnmos::activation_rollback::retry make_retry(const utility::string_t& id, nvnmos::activation_rollback::clock::time_point due)
+    {
+        nvnmos::activation_rollback::retry retry;
+        retry.id = id;
+        retry.type = nmos::types::receiver.name;
+        retry.internal_id = utility::us2s(id);
+        retry.sdp = "v=0\r\n";
+        retry.attempts = 0;
+        retry.due = due;
+        return retry;
+    }
+
+    bool test_last_accepted()
+    {
+        nvnmos::activation_rollback rollback;
+        const auto endpoint_active = web::json::value_of({ { U("master_enable"), true } });
+
+        bool success = true;
+        success = check(rollback.last_accepted(U("receiver-0"), U("1:0")).is_null(), "nothing accepted yet") && success;
+
+        rollback.accept(U("receiver-0"), U("1:0"), endpoint_active);
+        success = check(endpoint_active == rollback.last_accepted(U("receiver-0"), U("1:0")), "last accepted for the same creation time") && success;
+        // a receiver which has been removed and added again with the same id mustn't be rolled back to the old /active endpoint
+        success = check(rollback.last_accepted(U("receiver-0"), U("2:0")).is_null(), "nothing accepted for another creation time") && success;
+
+        rollback.forget(U("receiver-0"));
+        success = check(rollback.last_accepted(U("receiver-0"), U("1:0")).is_null(), "nothing accepted after forget") && success;
+
+        rollback.accept(U("receiver-0"), U("1:0"), endpoint_active);
+        rollback.clear();
+        success = check(rollback.last_accepted(U("receiver-0"), U("1:0")).is_null(), "nothing accepted after clear") && success;
+        return success;
+    }
+
+    bool test_retries()
+    {
+        typedef nvnmos::activation_rollback::clock clock;
+        nvnmos::activation_rollback rollback;
+        const auto now = clock::now();
+
+        bool success = true;
+        success = check((clock::time_point::max)() == rollback.next_due(), "no retry due before any is scheduled") && success;
+
+        rollback.schedule(make_retry(U("receiver-0"), now + std::chrono::seconds(2)));
+        rollback.schedule(make_retry(U("receiver-1"), now + std::chrono::seconds(1)));
+        success = check(now + std::chrono::seconds(1) == rollback.next_due(), "next due is the earliest retry") && success;
+
+        // a new retry for the same connection resource replaces the pending one
+        auto replacement = make_retry(U("receiver-1"), now + std::chrono::seconds(3));
+        replacement.attempts = 1;
+        rollback.schedule(replacement);
+        success = check(now + std::chrono::seconds(2) == rollback.next_due(), "schedule replaces the pending retry") && success;
+
+        success = check(rollback.take_due(now).empty(), "nothing taken before it is due") && success;
+
+        auto due = rollback.take_due(now + std::chrono::seconds(2));
+        success = check(1 == due.size() && U("receiver-0") == due.front().id, "take the retry which is due") && success;
+        success = check(now + std::chrono::seconds(3) == rollback.next_due(), "the retry which is due is removed") && success;
+
+        due = rollback.take_due(now + std::chrono::seconds(3));
+        success = check(1 == due.size() && U("receiver-1") == due.front().id && 1 == due.front().attempts, "take the replacement retry") && success;
+        success = check((clock::time_point::max)() == rollback.next_due(), "no retry due after all are taken") && success;
+
+        // forgetting a connection resource also forgets its pending retry, but not any others
+        rollback.schedule(make_retry(U("receiver-0"), now));
+        rollback.schedule(make_retry(U("receiver-1"), now + std::chrono::seconds(1)));
+        rollback.forget(U("receiver-0"));
+        success = check(now + std::chrono::seconds(1) == rollback.next_due(), "forget removes the pending retry") && success;
+
+        rollback.clear();
+        success = check((clock::time_point::max)() == rollback.next_due(), "clear removes all retries") && success;
+        return success;
+    }
+
+    bool test_retry_task()
+    {
+        typedef nvnmos::activation_rollback::clock clock;
+
+        nmos::node_model model;
+        model.settings = web::json::value::object();
+        model.settings[nvnmos::fields::activation_retries] = 2;
+        model.settings[nvnmos::fields::activation_retry_interval] = 1;
+
+        const auto id = U("receiver-0");
+        auto resource = nmos::make_connection_rtp_receiver(id, false);
+        resource.data[nmos::fields::endpoint_active][nmos::fields::master_enable] = true;
+        const auto updated = nmos::make_version(nmos::insert_resource(model.connection_resources, std::move(resource)).first->updated);
+
+        nvnmos::activation_rollback rollback;
+        nvnmos::connection_index connections;
+        nvnmos::sdp_store sdps;
+        nvnmos::transportfile_store transportfiles;
+        nvnmos::data_plane_liveness liveness;
+        quiet_gate gate;
+
+        int attempts = 0;
+        auto task = nvnmos::make_node_implementation_activation_retry_task(model, rollback, connections, [&attempts](const std::string&, const std::string&)
+        {
+            ++attempts;
+            return false;
+        }, sdps, transportfiles, liveness, gate);
+
+        bool success = true;
+
+        // a retry for a connection resource which has been removed, or which has been updated since it was rolled back, is abandoned
+        auto removed = make_retry(U("receiver-1"), clock::now());
+        removed.updated = updated;
+        rollback.schedule(removed);
+        auto superseded = make_retry(id, clock::now());
+        superseded.updated = U("0:0");
+        rollback.schedule(superseded);
+        task();
+        success = check(0 == attempts, "superseded retries aren't attempted") && success;
+        success = check((clock::time_point::max)() == rollback.next_due(), "superseded retries are abandoned") && success;
+
+        // a failing retry is rescheduled with a backoff, until the maximum number of attempts
+        auto failing = make_retry(id, clock::now());
+        failing.updated = updated;
+        rollback.schedule(failing);
+        auto before = clock::now();
+        task();
+        success = check(1 == attempts, "the first attempt is made when due") && success;
+        success = check(before + std::chrono::milliseconds(2) <= rollback.next_due() && (clock::time_point::max)() != rollback.next_due(), "the second attempt is backed off") && success;
+
+        std::this_thread::sleep_until(rollback.next_due());
+        task();
+        success = check(2 == attempts, "the second attempt is made when due") && success;
+        success = check((clock::time_point::max)() == rollback.next_due(), "the activation is abandoned after the maximum attempts") && success;
+        return success;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool success = true;
+    success = test_last_accepted() && success;
+    success = test_retries() && success;
+    success = test_retry_task() && success;
+
+    std::fprintf(stderr, "%s\n", success ? "Passed" : "Failed");
+    return success ? 0 : 1;
+}
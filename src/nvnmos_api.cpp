@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_api.h"
+
+#include "nmos/api_utils.h"
+#include "nmos/media_type.h"
+#include "nmos/model.h"
+#include "nmos/slog.h"
+#include "nvnmos_impl.h"
+#include "nvnmos_state_digest.h"
+#include "nvnmos_transportfile.h"
+
+namespace nvnmos
+{
+    // The custom (non-NMOS) endpoints, which are mounted at /x-nvnmos on the Connection API port
+    web::http::experimental::listener::api_router make_nvnmos_api(nmos::node_model& model, transportfile_store& transportfiles, state_digest& digest, metrics_provider get_metrics, slog::base_gate& gate)
+    {
+        using namespace web::http::experimental::listener::api_router_using_declarations;
+
+        api_router nvnmos_api;
+
+        // a sender's /transportfile redirects here when lazy_transport_files is enabled
+        nvnmos_api.support(U("/transportfile/") + nmos::patterns::resourceId.pattern + U("/?"), methods::GET, [&model, &transportfiles, &gate](http_request req, http_response res, const string_t&, const route_parameters& parameters)
+        {
+            const auto id = parameters.at(nmos::patterns::resourceId.name);
+
+            {
+                auto lock = model.read_lock();
+                if (model.node_resources.end() == nmos::find_resource(model.node_resources, { id, nmos::types::sender }))
+                {
+                    // the sender has been removed, which should already have forgotten it
+                    transportfiles.erase(id);
+                }
+            }
+
+            // render the transport file, if required, without holding the model lock
+            const auto transportfile = transportfiles.get(id);
+            if (!transportfile.empty())
+            {
+                set_reply(res, status_codes::OK, transportfile, nmos::media_types::application_sdp.name);
+            }
+            else
+            {
+                set_reply(res, status_codes::NotFound);
+            }
+
+            return pplx::task_from_result(true);
+        });
+
+        // a digest of the node's state, so that monitoring systems only need to fetch the resources when it changes
+        nvnmos_api.support(U("/state/?"), methods::GET, [&model, &digest](http_request req, http_response res, const string_t&, const route_parameters&)
+        {
+            web::json::value state;
+            {
+                auto lock = model.read_lock();
+                state = digest.get_json(model);
+            }
+
+            const auto etag = U("\"") + state.at(U("digest")).as_string() + U("\"");
+            res.headers().add(web::http::header_names::etag, etag);
+
+            if (req.headers().has(web::http::header_names::if_none_match) && etag == req.headers()[web::http::header_names::if_none_match])
+            {
+                set_reply(res, status_codes::NotModified);
+            }
+            else
+            {
+                set_reply(res, status_codes::OK, state);
+            }
+
+            return pplx::task_from_result(true);
+        });
+
+        // counters and histograms, which don't require the model lock
+        nvnmos_api.support(U("/metrics/?"), methods::GET, [get_metrics](http_request req, http_response res, const string_t&, const route_parameters&)
+        {
+            set_reply(res, status_codes::OK, get_metrics());
+            return pplx::task_from_result(true);
+        });
+
+        return nvnmos_api;
+    }
+
+    // The /healthz and /readyz endpoints for orchestrator probes, which are mounted at the root of the Connection API port
+    // and only read atomics, so that they never wait for the model lock
+    web::http::experimental::listener::api_router make_nvnmos_health_api(const node_health& health, const data_plane_liveness& liveness, bool registration_required, std::chrono::milliseconds data_plane_timeout)
+    {
+        using namespace web::http::experimental::listener::api_router_using_declarations;
+
+        api_router health_api;
+
+        auto make_health = [&health, &liveness, data_plane_timeout](bool& ready)
+        {
+            typedef std::chrono::duration<double> seconds;
+            const auto now = node_health::clock::now();
+
+            const bool listening = health.listening;
+            const bool registered = health.registered;
+            const bool data_plane_expired = liveness.expired;
+
+            auto result = web::json::value_of({
+                { U("listening"), listening },
+                { U("registered"), registered },
+                { U("registration_age"), seconds(now - health.registration_changed_time()).count() }
+            }, true);
+            if (0 != data_plane_timeout.count())
+            {
+                result[U("data_plane_expired")] = web::json::value::boolean(data_plane_expired);
+                result[U("data_plane_age")] = web::json::value::number(seconds(now - liveness.last_alive_time()).count());
+            }
+
+            ready = listening && !data_plane_expired;
+            return result;
+        };
+
+        // the server is live if it can respond at all
+        health_api.support(U("/healthz/?"), methods::GET, [make_health](http_request req, http_response res, const string_t&, const route_parameters&)
+        {
+            bool ready;
+            set_reply(res, status_codes::OK, make_health(ready));
+            return pplx::task_from_result(true);
+        });
+
+        health_api.support(U("/readyz/?"), methods::GET, [make_health, &health, registration_required](http_request req, http_response res, const string_t&, const route_parameters&)
+        {
+            bool ready;
+            auto result = make_health(ready);
+            ready = ready && (!registration_required || health.registered);
+            set_reply(res, ready ? status_codes::OK : status_codes::ServiceUnavailable, result);
+            return pplx::task_from_result(true);
+        });
+
+        return health_api;
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_API_H
+#define NVNMOS_API_H
+
+#include <chrono>
+#include "cpprest/api_router.h"
+#include "nvnmos_metrics.h"
+
+namespace slog
+{
+    class base_gate;
+}
+
+namespace nmos
+{
+    struct node_model;
+}
+
+namespace nvnmos
+{
+    struct data_plane_liveness;
+    struct node_health;
+    class state_digest;
+    class transportfile_store;
+
+    // The custom (non-NMOS) endpoints, which are mounted at /x-nvnmos on the Connection API port
+    web::http::experimental::listener::api_router make_nvnmos_api(nmos::node_model& model, transportfile_store& transportfiles, state_digest& digest, metrics_provider get_metrics, slog::base_gate& gate);
+
+    // The /healthz and /readyz endpoints for orchestrator probes, which are mounted at the root of the Connection API port
+    // and only read atomics, so that they never wait for the model lock
+    // When registration is required, the node is only ready while it is in registered operation
+    // When the data plane timeout is non-zero, the node is only ready while the data plane is alive
+    web::http::experimental::listener::api_router make_nvnmos_health_api(const node_health& health, const data_plane_liveness& liveness, bool registration_required, std::chrono::milliseconds data_plane_timeout);
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_change_detector.h"
+
+#include <vector>
+
+namespace nvnmos
+{
+    // check whether there may be changes to detect
+    bool change_detector::pending(const nmos::resources& resources) const
+    {
+        // a resource which is erased permanently, or forgotten, doesn't update the most recent update time, but does change the count
+        return most_recent_update_ < nmos::most_recent_update(resources)
+            || ids.size() != resources.size();
+    }
+
+    // visit the resources which have been inserted or modified since the last call, in the order they were changed,
+    // and then the ids of those which have since been removed
+    void change_detector::detect(const nmos::resources& resources, const changed_resource_handler& changed, const removed_resource_handler& removed)
+    {
+        // the index by update time has the most recently updated resources first
+        auto& by_updated = resources.get<nmos::tags::updated>();
+        const auto unchanged = by_updated.lower_bound(most_recent_update_);
+
+        if (by_updated.begin() != unchanged)
+        {
+            std::vector<const nmos::resource*> changes;
+            for (auto it = by_updated.begin(); unchanged != it; ++it)
+            {
+                changes.push_back(&*it);
+            }
+            most_recent_update_ = changes.front()->updated;
+
+            for (auto it = changes.rbegin(); changes.rend() != it; ++it)
+            {
+                ids.insert((*it)->id);
+                changed(**it);
+            }
+        }
+
+        // each resource which is still present has now been visited at least once, so any other ids have been removed
+        if (ids.size() == resources.size()) return;
+
+        for (auto it = ids.begin(); ids.end() != it;)
+        {
+            if (resources.end() != resources.find(*it)) { ++it; continue; }
+
+            const auto id = *it;
+            it = ids.erase(it);
+            removed(id);
+        }
+    }
+
+    // forget the resources which have been visited, so that every resource is visited by the next call
+    void change_detector::reset()
+    {
+        most_recent_update_ = nmos::tai_min();
+        ids.clear();
+    }
+}
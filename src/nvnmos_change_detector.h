@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_CHANGE_DETECTOR_H
+#define NVNMOS_CHANGE_DETECTOR_H
+
+#include <functional>
+#include <unordered_set>
+#include "nmos/resources.h"
+
+namespace nvnmos
+{
+    typedef std::function<void(const nmos::resource& resource)> changed_resource_handler;
+    typedef std::function<void(const nmos::id& id)> removed_resource_handler;
+
+    // Detects the changes to a container of resources since they were last detected, using the index of the resources
+    // by update time, so that only the resources which have changed are visited however many there are
+    // Each detector has a single consumer, e.g. the thread or task publishing the changes, which must hold the model lock
+    class change_detector
+    {
+    public:
+        // check whether there may be changes to detect
+        bool pending(const nmos::resources& resources) const;
+
+        // visit the resources which have been inserted or modified since the last call, in the order they were changed,
+        // including those which have been erased but not yet forgotten, i.e. have no data, and then the ids of those which
+        // have since been forgotten, or erased permanently
+        void detect(const nmos::resources& resources, const changed_resource_handler& changed, const removed_resource_handler& removed);
+
+        // forget the resources which have been visited, so that every resource is visited by the next call
+        void reset();
+
+        // the update time of the most recently changed resource which has been visited
+        const nmos::tai& most_recent_update() const { return most_recent_update_; }
+
+    private:
+        nmos::tai most_recent_update_ = nmos::tai_min();
+        // the ids of the resources which have been visited, to find those which have been removed
+        std::unordered_set<nmos::id> ids;
+    };
+}
+
+#endif
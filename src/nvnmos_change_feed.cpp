@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_change_feed.h"
+
+#include <vector>
+#include "nmos/model.h"
+#include "nmos/resources.h"
+#include "nmos/slog.h"
+
+namespace nvnmos
+{
+    // This makes a JSON merge patch, as per RFC 7386, which transforms the source value into the target value
+    // (since a null member in a patch removes that member, a member whose value becomes null is removed)
+    web::json::value make_merge_patch(const web::json::value& source, const web::json::value& target)
+    {
+        if (!source.is_object() || !target.is_object()) return target;
+
+        auto patch = web::json::value::object();
+        for (const auto& field : source.as_object())
+        {
+            if (!target.has_field(field.first)) patch[field.first] = web::json::value::null();
+        }
+        for (const auto& field : target.as_object())
+        {
+            if (!source.has_field(field.first))
+            {
+                patch[field.first] = field.second;
+            }
+            else
+            {
+                const auto& value = source.at(field.first);
+                if (value != field.second) patch[field.first] = make_merge_patch(value, field.second);
+            }
+        }
+        return patch;
+    }
+
+    namespace details
+    {
+        web::json::value make_change(uint64_t seq, const utility::string_t& op)
+        {
+            return web::json::value_of({
+                { change_feed_fields::seq, web::json::value::number(seq) },
+                { change_feed_fields::op, op }
+            }, true);
+        }
+
+        web::json::value make_change(uint64_t seq, const utility::string_t& op, const utility::string_t& api, const nmos::resource& resource)
+        {
+            auto change = make_change(seq, op);
+            change[change_feed_fields::api] = web::json::value::string(api);
+            change[change_feed_fields::type] = web::json::value::string(resource.type.name);
+            change[change_feed_fields::id] = web::json::value::string(resource.id);
+            return change;
+        }
+    }
+
+    // check whether there may be changes to publish, while holding the model lock
+    bool change_feed::pending(const nmos::node_model& model) const
+    {
+        return resync_requested
+            || node_changes.pending(model.node_resources)
+            || connection_changes.pending(model.connection_resources);
+    }
+
+    // publish any changes, calling the handler for each without holding the model lock
+    void change_feed::publish(nmos::node_model& model, slog::base_gate& gate)
+    {
+        std::vector<web::json::value> changes;
+        {
+            auto lock = model.read_lock();
+
+            if (resync_requested.exchange(false))
+            {
+                slog::log<slog::severities::info>(gate, SLOG_FLF) << "Resynchronizing change feed";
+                published.clear();
+                node_changes.reset();
+                connection_changes.reset();
+                changes.push_back(details::make_change(++seq, change_feed_ops::resync));
+            }
+
+            auto erase = [&](std::map<std::pair<utility::string_t, utility::string_t>, published_resource>::iterator found)
+            {
+                auto change = details::make_change(++seq, change_feed_ops::erase);
+                change[change_feed_fields::api] = web::json::value::string(found->first.first);
+                change[change_feed_fields::type] = web::json::value::string(found->second.type);
+                change[change_feed_fields::id] = web::json::value::string(found->first.second);
+                changes.push_back(std::move(change));
+                published.erase(found);
+            };
+
+            auto diff = [&](change_detector& detector, const nmos::resources& resources, const utility::string_t& api)
+            {
+                detector.detect(resources, [&](const nmos::resource& resource)
+                {
+                    const auto key = std::make_pair(api, resource.id);
+                    auto found = published.find(key);
+
+                    // a resource without data has been erased, but not yet forgotten
+                    if (!resource.has_data())
+                    {
+                        if (published.end() != found) erase(found);
+                    }
+                    else if (published.end() == found)
+                    {
+                        auto change = details::make_change(++seq, change_feed_ops::insert, api, resource);
+                        change[change_feed_fields::data] = resource.data;
+                        changes.push_back(std::move(change));
+                        published.insert({ key, { resource.type.name, resource.data } });
+                    }
+                    else
+                    {
+                        auto patch = make_merge_patch(found->second.data, resource.data);
+                        found->second = { resource.type.name, resource.data };
+                        // e.g. only the version changed, which is already in the data, or the update was a no-op
+                        if (patch.is_object() && 0 == patch.size()) return;
+
+                        auto change = details::make_change(++seq, change_feed_ops::modify, api, resource);
+                        change[change_feed_fields::patch] = std::move(patch);
+                        changes.push_back(std::move(change));
+                    }
+                }, [&](const nmos::id& id)
+                {
+                    auto found = published.find(std::make_pair(api, id));
+                    if (published.end() != found) erase(found);
+                });
+            };
+            diff(node_changes, model.node_resources, U("node"));
+            diff(connection_changes, model.connection_resources, U("connection"));
+        }
+
+        for (const auto& change : changes)
+        {
+            changed(utility::us2s(change.serialize()));
+        }
+    }
+
+    // This publishes the changes as soon as they are made, until the server is shut down
+    void change_feed_thread(nmos::node_model& model, change_feed& feed, slog::base_gate& gate)
+    {
+        auto lock = model.read_lock();
+        for (;;)
+        {
+            model.wait(lock, [&] { return model.shutdown || feed.pending(model); });
+            if (model.shutdown) break;
+
+            lock.unlock();
+            feed.publish(model, gate);
+            lock.lock();
+        }
+    }
+
+    // This makes a task which publishes the changes periodically, for use by the application's event loop
+    node_implementation_task make_change_feed_task(nmos::node_model& model, change_feed& feed, slog::base_gate& gate)
+    {
+        // the event loop isn't woken when the model is notified, so changes are published with this latency
+        const std::chrono::milliseconds interval(50);
+
+        return [&model, &feed, &gate, interval]
+        {
+            bool pending;
+            {
+                auto lock = model.read_lock();
+                pending = feed.pending(model);
+            }
+            if (pending) feed.publish(model, gate);
+            return node_implementation_task_clock::now() + interval;
+        };
+    }
+}
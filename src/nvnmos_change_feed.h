@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_CHANGE_FEED_H
+#define NVNMOS_CHANGE_FEED_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include "cpprest/json_utils.h"
+#include "nvnmos_change_detector.h"
+#include "nvnmos_impl.h"
+
+namespace nvnmos
+{
+    // Change feed ops, serialized as one JSON object per change, with a sequence number which increases by one each time
+    // "resync" means that the mirror should discard its state, and is followed by "insert" (with the "data") of each resource
+    // "insert", "modify" (with a JSON merge "patch", as per RFC 7386) and "erase" identify the resource by "api", "type" and "id"
+    namespace change_feed_ops
+    {
+        const utility::string_t resync{ U("resync") };
+        const utility::string_t insert{ U("insert") };
+        const utility::string_t modify{ U("modify") };
+        const utility::string_t erase{ U("erase") };
+    }
+
+    namespace change_feed_fields
+    {
+        const web::json::field_as_integer seq{ U("seq") };
+        const web::json::field_as_string op{ U("op") };
+        const web::json::field_as_string api{ U("api") }; // "node" or "connection"
+        const web::json::field_as_string type{ U("type") };
+        const web::json::field_as_string id{ U("id") };
+        const web::json::field_as_value data{ U("data") };
+        const web::json::field_as_value patch{ U("patch") };
+    }
+
+    // This makes a JSON merge patch, as per RFC 7386, which transforms the source value into the target value
+    // (since a null member in a patch removes that member, a member whose value becomes null is removed)
+    web::json::value make_merge_patch(const web::json::value& source, const web::json::value& target);
+
+    typedef std::function<void(const std::string& change)> change_handler;
+
+    // Feed of the changes to the node's resources in the Node API and Connection API, which are found by comparing
+    // the data of each changed resource with the data last published, however it was changed
+    class change_feed
+    {
+    public:
+        explicit change_feed(change_handler changed) : changed(std::move(changed)) {}
+
+        // request that the feed is resynchronized, before any further changes are published
+        void resync() { resync_requested = true; }
+
+        // check whether there may be changes to publish, while holding the model lock
+        bool pending(const nmos::node_model& model) const;
+
+        // publish any changes, calling the handler for each without holding the model lock
+        void publish(nmos::node_model& model, slog::base_gate& gate);
+
+    private:
+        struct published_resource
+        {
+            utility::string_t type;
+            web::json::value data;
+        };
+
+        change_handler changed;
+        std::atomic<bool> resync_requested{ true };
+
+        // only accessed by the thread or task publishing the changes
+        std::map<std::pair<utility::string_t, utility::string_t>, published_resource> published; // by api and id
+        uint64_t seq = 0;
+        change_detector node_changes;
+        change_detector connection_changes;
+    };
+
+    // This publishes the changes as soon as they are made, until the server is shut down
+    void change_feed_thread(nmos::node_model& model, change_feed& feed, slog::base_gate& gate);
+
+    // This makes a task which publishes the changes periodically, for use by the application's event loop
+    node_implementation_task make_change_feed_task(nmos::node_model& model, change_feed& feed, slog::base_gate& gate);
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This checks the JSON merge patches made for the change feed, i.e. that each patch is minimal, and that applying it to
+// the source value, as per RFC 7386, results in the target value
+
+#include <cstdio>
+#include "cpprest/json_ops.h"
+#include "nvnmos_change_feed.h"
+
+namespace
+{
+    bool check_merge_patch(const utility::char_t* source_, const utility::char_t* target_, const utility::char_t* expected_, const char* description)
+    {
+        const auto source = web::json::value::parse(source_);
+        const auto target = web::json::value::parse(target_);
+        const auto expected = web::json::value::parse(expected_);
+
+        const auto patch = nvnmos::make_merge_patch(source, target);
+
+        auto patched = source;
+        web::json::merge_patch(patched, patch, true);
+
+        if (expected == patch && target == patched) return true;
+
+        std::fprintf(stderr, "Failed: %s, patch: %s, patched: %s\n", description, utility::us2s(patch.serialize()).c_str(), utility::us2s(patched.serialize()).c_str());
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool success = true;
+
+    success = check_merge_patch(U(R"({"a":1,"b":"x"})"), U(R"({"a":1,"b":"x"})"), U(R"({})"), "identical values") && success;
+    success = check_merge_patch(U(R"({"a":1})"), U(R"({"a":2})"), U(R"({"a":2})"), "modified member") && success;
+    success = check_merge_patch(U(R"({"a":1})"), U(R"({"a":1,"b":true})"), U(R"({"b":true})"), "added member") && success;
+    success = check_merge_patch(U(R"({"a":1,"b":true})"), U(R"({"a":1})"), U(R"({"b":null})"), "removed member") && success;
+    success = check_merge_patch(U(R"({"a":{"b":1,"c":2}})"), U(R"({"a":{"b":1,"c":3}})"), U(R"({"a":{"c":3}})"), "nested member") && success;
+    success = check_merge_patch(U(R"({"a":{"b":1}})"), U(R"({"a":{}})"), U(R"({"a":{"b":null}})"), "removed nested member") && success;
+    success = check_merge_patch(U(R"({"a":[1,2,3]})"), U(R"({"a":[1,2]})"), U(R"({"a":[1,2]})"), "arrays are replaced") && success;
+    success = check_merge_patch(U(R"({"a":{"b":1}})"), U(R"({"a":"b"})"), U(R"({"a":"b"})"), "object replaced by a string") && success;
+    success = check_merge_patch(U(R"({"a":"b"})"), U(R"({"a":{"b":1}})"), U(R"({"a":{"b":1}})"), "string replaced by an object") && success;
+    success = check_merge_patch(U(R"([1])"), U(R"({"a":1})"), U(R"({"a":1})"), "non-object source") && success;
+
+    std::fprintf(stderr, "%s\n", success ? "Passed" : "Failed");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,317 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_client.h"
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "nvnmos_ipc.h"
+
+namespace nvnmos
+{
+    class client
+    {
+    public:
+        client() {}
+        ~client()
+        {
+            if (nullptr != ring) ::munmap(ring, ring_size);
+            if (-1 != event_fd) ::close(event_fd);
+            if (-1 != socket) ::close(socket);
+        }
+
+        bool connect(const std::string& socket_path, const std::string& name)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (sizeof(address.sun_path) <= socket_path.size()) return false;
+            std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+
+            socket = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            if (-1 == socket) return false;
+            if (-1 == ::connect(socket, (sockaddr*)&address, sizeof(address))) return false;
+
+            if (!ipc::send_message(socket, make_request(ipc::request_type::hello, name))) return false;
+
+            std::string message;
+            int fds[2] = { -1, -1 };
+            size_t num_fds = 2;
+            const bool received = ipc::receive_message(socket, message, fds, &num_fds);
+            const int shm_fd = 0 < num_fds ? fds[0] : -1;
+            event_fd = 1 < num_fds ? fds[1] : -1;
+
+            bool result = received && sizeof(ipc::reply) == message.size() && NVNMOS_STATUS_OK == get_status(message) && 2 == num_fds;
+            if (result)
+            {
+                struct stat info;
+                result = 0 == ::fstat(shm_fd, &info) && sizeof(ipc::ring_header) <= (size_t)info.st_size;
+                if (result)
+                {
+                    ring_size = (size_t)info.st_size;
+                    auto mapping = ::mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+                    ring = MAP_FAILED != mapping ? (ipc::ring_header*)mapping : nullptr;
+                    result = nullptr != ring
+                        && ipc::version == ring->version
+                        && ipc::ring_size(ring->slot_count, ring->slot_size) <= ring_size
+                        && sizeof(ipc::event_header) <= ring->slot_size;
+                }
+            }
+            if (-1 != shm_fd) ::close(shm_fd);
+            if (!result) return false;
+
+            // reserve the storage up front, so that copying an event out of the ring never allocates
+            id.reserve(ring->slot_size);
+            sdp.reserve(ring->slot_size);
+            return true;
+        }
+
+        NvNmosStatus request(ipc::request_type type, const std::string& payload)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            std::string message;
+            if (!ipc::send_message(socket, make_request(type, payload))) return NVNMOS_STATUS_ERROR;
+            if (!ipc::receive_message(socket, message) || sizeof(ipc::reply) != message.size()) return NVNMOS_STATUS_ERROR;
+            return get_status(message);
+        }
+
+        int get_event_fd() const
+        {
+            return event_fd;
+        }
+
+        bool next_event(NvNmosClientEvent& event)
+        {
+            for (;;)
+            {
+                const auto tail = ring->tail.load(std::memory_order_relaxed);
+                if (ring->head.load(std::memory_order_acquire) == tail)
+                {
+                    // reset the eventfd, then check again so that an event written in the meantime is not missed
+                    uint64_t count;
+                    const auto drained = ::read(event_fd, &count, sizeof(count));
+                    (void)drained;
+                    if (ring->head.load(std::memory_order_acquire) == tail) return false;
+                }
+
+                const char* slot = ipc::ring_slot(ring, tail);
+                ipc::event_header header;
+                std::memcpy(&header, slot, sizeof(header));
+                const size_t data_size = ring->slot_size - sizeof(header);
+                const bool valid = header.id_size <= data_size && header.sdp_size <= data_size - header.id_size;
+                if (valid)
+                {
+                    id.assign(slot + sizeof(header), header.id_size);
+                    sdp.assign(slot + sizeof(header) + header.id_size, header.sdp_size);
+                }
+                ring->tail.store(tail + 1, std::memory_order_release);
+                // skip a malformed event
+                if (!valid) continue;
+
+                event.type = (NvNmosClientEventType)header.type;
+                event.id = id.c_str();
+                event.sdp = ipc::event_type::activation == header.type && !sdp.empty() ? sdp.c_str() : nullptr;
+                event.leg = header.leg;
+                event.up = 0 != header.up;
+                return true;
+            }
+        }
+
+        void data_plane_alive()
+        {
+            ring->alive.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void get_stats(NvNmosClientStats& stats) const
+        {
+            stats.events_written = ring->events_written.load(std::memory_order_relaxed);
+            stats.events_dropped = ring->events_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static std::string make_request(ipc::request_type type, const std::string& payload)
+        {
+            const ipc::request_header header{ ipc::version, type };
+            std::string message((const char*)&header, sizeof(header));
+            message.append(payload);
+            return message;
+        }
+
+        static NvNmosStatus get_status(const std::string& message)
+        {
+            ipc::reply reply;
+            std::memcpy(&reply, message.data(), sizeof(reply));
+            return (NvNmosStatus)reply.status;
+        }
+
+        int socket = -1;
+        int event_fd = -1;
+        ipc::ring_header* ring = nullptr;
+        size_t ring_size = 0;
+
+        // serializes requests, since each reply is read synchronously
+        std::mutex mutex;
+
+        // storage for the current event, owned by the single thread calling next_event
+        std::string id;
+        std::string sdp;
+    };
+}
+
+NVNMOS_CLIENT_API
+bool create_nmos_client(
+    const NvNmosClientConfig* config,
+    NvNmosClient* client)
+{
+    if (!config || !client) return false;
+    if (!config->name || !*config->name) return false;
+
+    try
+    {
+        std::unique_ptr<nvnmos::client> impl(new nvnmos::client());
+        if (!impl->connect(config->socket_path ? config->socket_path : nvnmos::ipc::default_socket_path, config->name)) return false;
+        client->impl = impl.release();
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+NVNMOS_CLIENT_API
+bool destroy_nmos_client(
+    NvNmosClient* client)
+{
+    if (!client) return false;
+    auto impl = (nvnmos::client*)client->impl;
+    if (!impl) return false;
+
+    client->impl = 0;
+    delete impl;
+    return true;
+}
+
+namespace
+{
+    NvNmosStatus client_request(NvNmosClient* client, nvnmos::ipc::request_type type, const char* payload)
+    {
+        if (!client) return NVNMOS_STATUS_INVALID_ARGUMENT;
+        auto impl = (nvnmos::client*)client->impl;
+        if (!impl) return NVNMOS_STATUS_INVALID_ARGUMENT;
+        if (!payload) return NVNMOS_STATUS_INVALID_ARGUMENT;
+
+        try
+        {
+            return impl->request(type, payload);
+        }
+        catch (...)
+        {
+            return NVNMOS_STATUS_ERROR;
+        }
+    }
+}
+
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_add_receiver(
+    NvNmosClient* client,
+    const NvNmosReceiverConfig* config)
+{
+    if (!config) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    return client_request(client, nvnmos::ipc::request_type::add_receiver, config->sdp);
+}
+
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_remove_receiver(
+    NvNmosClient* client,
+    const char* id)
+{
+    return client_request(client, nvnmos::ipc::request_type::remove_receiver, id);
+}
+
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_add_sender(
+    NvNmosClient* client,
+    const NvNmosSenderConfig* config)
+{
+    if (!config) return NVNMOS_STATUS_INVALID_ARGUMENT;
+    return client_request(client, nvnmos::ipc::request_type::add_sender, config->sdp);
+}
+
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_remove_sender(
+    NvNmosClient* client,
+    const char* id)
+{
+    return client_request(client, nvnmos::ipc::request_type::remove_sender, id);
+}
+
+NVNMOS_CLIENT_API
+int nmos_client_get_event_fd(
+    NvNmosClient* client)
+{
+    if (!client) return -1;
+    auto impl = (nvnmos::client*)client->impl;
+    if (!impl) return -1;
+
+    return impl->get_event_fd();
+}
+
+NVNMOS_CLIENT_API
+bool nmos_client_next_event(
+    NvNmosClient* client,
+    NvNmosClientEvent* event)
+{
+    if (!client) return false;
+    auto impl = (nvnmos::client*)client->impl;
+    if (!impl) return false;
+    if (!event) return false;
+
+    return impl->next_event(*event);
+}
+
+NVNMOS_CLIENT_API
+bool nmos_client_data_plane_alive(
+    NvNmosClient* client)
+{
+    if (!client) return false;
+    auto impl = (nvnmos::client*)client->impl;
+    if (!impl) return false;
+
+    impl->data_plane_alive();
+    return true;
+}
+
+NVNMOS_CLIENT_API
+bool nmos_client_get_stats(
+    NvNmosClient* client,
+    NvNmosClientStats* stats)
+{
+    if (!client) return false;
+    auto impl = (nvnmos::client*)client->impl;
+    if (!impl) return false;
+    if (!stats) return false;
+
+    impl->get_stats(*stats);
+    return true;
+}
@@ -0,0 +1,309 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file nvnmos_client.h
+ * <b>NVIDIA Networked Media Open Specifications (NMOS) Client API</b>
+ *
+ * @b Description: This file defines the API of the client library
+ * (nvnmos-client) for the NvNmos daemon (nvnmosd).
+ */
+
+/**
+ * @defgroup  nvnmos_client  NvNmos Daemon Client API
+ *
+ * Defines the API of the client library for the NvNmos daemon.
+ *
+ * The nvnmosd daemon owns a single NMOS Node, so that several data plane
+ * processes on the same host can appear as one Node. Each process uses
+ * this library to add its senders and receivers to the Node, and to
+ * receive IS-05 Connection API activations and link state changes for
+ * them.
+ *
+ * Requests are made over a UNIX domain socket. Events are delivered via
+ * a ring in shared memory, which can be polled without any system call,
+ * or waited for using the file descriptor from
+ * @ref nmos_client_get_event_fd.
+ *
+ * The senders and receivers are owned by the client's name rather than
+ * its connection, so they remain in the Node when the client process
+ * exits. When a client with the same name connects again, it receives
+ * the latest activation of each of them, and adding them again with
+ * the same Session Description Protocol data has no effect.
+ *
+ * This library does not depend on the NvNmos library itself.
+ *
+ * @ingroup NvNmosApi
+ * @{
+ */
+
+#ifndef NVNMOS_CLIENT_H
+#define NVNMOS_CLIENT_H
+
+#if defined(NVNMOS_CLIENT_EXPORTS)
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#define NVNMOS_CLIENT_API __declspec(dllexport)
+#elif defined(__GNUC__) && (__GNUC__ >= 4)
+#define NVNMOS_CLIENT_API __attribute__ ((visibility("default")))
+#else
+#define NVNMOS_CLIENT_API
+#endif
+
+#elif defined(NVNMOS_CLIENT_STATIC)
+
+#define NVNMOS_CLIENT_API
+
+#else
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#define NVNMOS_CLIENT_API __declspec(dllimport)
+#elif defined(__GNUC__) && (__GNUC__ >= 4)
+#define NVNMOS_CLIENT_API
+#else
+#define NVNMOS_CLIENT_API
+#endif
+
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "nvnmos.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Defines configuration settings used to create an @ref NvNmosClient.
+ * The structure should be zero initialized.
+ */
+typedef struct _NvNmosClientConfig
+{
+    /** Holds the path of the daemon's UNIX domain socket. May be null in
+        which case the default, "/run/nvnmosd.sock", is used. */
+    const char *socket_path;
+    /** Holds the client name, which must be unique among the clients
+        connected at the same time, and stable across restarts of the
+        client process. Must not be null. */
+    const char *name;
+} NvNmosClientConfig;
+
+/**
+ * Defines the types of event delivered to an @ref NvNmosClient.
+ */
+typedef enum _NvNmosClientEventType
+{
+    /** An IS-05 Connection API activation, like the
+        @ref nmos_connection_rtp_activation_callback. */
+    NVNMOS_CLIENT_EVENT_ACTIVATION = 1,
+    /** A change of the link state of a leg, like the
+        @ref nmos_link_state_callback. */
+    NVNMOS_CLIENT_EVENT_LINK_STATE
+} NvNmosClientEventType;
+
+/**
+ * Defines an event delivered to an @ref NvNmosClient.
+ * The pointers are valid until the next call to
+ * @ref nmos_client_next_event.
+ */
+typedef struct _NvNmosClientEvent
+{
+    /** Holds the type of the event. */
+    NvNmosClientEventType type;
+    /** Holds the unique identifier for the sender or receiver. */
+    const char *id;
+    /** Holds the updated Session Description Protocol data for an
+        activation, or a null pointer when the sender or receiver has
+        been deactivated. */
+    const char *sdp;
+    /** Holds the index of the affected leg for a link state change. */
+    unsigned int leg;
+    /** Holds whether the link is now up for a link state change. */
+    bool up;
+} NvNmosClientEvent;
+
+/**
+ * Defines statistics of the events delivered to an @ref NvNmosClient.
+ */
+typedef struct _NvNmosClientStats
+{
+    /** Holds the number of events written to the ring. */
+    uint64_t events_written;
+    /** Holds the number of events dropped because the ring was full
+        or the event was too large. */
+    uint64_t events_dropped;
+} NvNmosClientStats;
+
+/**
+ * Holds the implementation details of a connected client.
+ * The structure should be zero initialized, with the possible
+ * exception of the @p user_data member.
+ */
+typedef struct _NvNmosClient
+{
+    /**
+     * Holds a pointer to user data, not used by the client library.
+     */
+    void *user_data;
+    /**
+     * Holds an opaque pointer used by the client library.
+     */
+    void *impl;
+} NvNmosClient;
+
+/**
+ * Connect to the NvNmos daemon according to the specified
+ * configuration settings.
+ *
+ * The client should be disconnected using @ref destroy_nmos_client.
+ *
+ * @param[in] config Pointer to the configuration settings.
+ * @param[in] client Pointer to the client to be initialized.
+ * @return Whether the client has been created and successfully connected.
+ */
+NVNMOS_CLIENT_API
+bool create_nmos_client(
+    const NvNmosClientConfig *config,
+    NvNmosClient *client);
+
+/**
+ * Disconnect from the NvNmos daemon and deinitialize the client.
+ * The client's senders and receivers remain in the Node.
+ *
+ * @param[in] client Pointer to the client to be deinitialized.
+ * @return Whether the client has been successfully deinitialized.
+ */
+NVNMOS_CLIENT_API
+bool destroy_nmos_client(
+    NvNmosClient *client);
+
+/**
+ * Add an NMOS Receiver to the daemon's Node, owned by this client.
+ *
+ * @param[in] client Pointer to the client.
+ * @param[in] config Pointer to the configuration settings.
+ * @return @ref NVNMOS_STATUS_OK if the receiver has been successfully
+ *         added, or was already owned by this client with the same
+ *         Session Description Protocol data.
+ */
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_add_receiver(
+    NvNmosClient *client,
+    const NvNmosReceiverConfig *config);
+
+/**
+ * Remove an NMOS Receiver owned by this client from the daemon's Node.
+ *
+ * @param[in] client Pointer to the client.
+ * @param[in] id     The unique identifier for the receiver.
+ * @return @ref NVNMOS_STATUS_OK if the receiver has been successfully
+ *         removed.
+ */
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_remove_receiver(
+    NvNmosClient *client,
+    const char *id);
+
+/**
+ * Add an NMOS Sender to the daemon's Node, owned by this client.
+ *
+ * @param[in] client Pointer to the client.
+ * @param[in] config Pointer to the configuration settings.
+ * @return @ref NVNMOS_STATUS_OK if the sender has been successfully
+ *         added, or was already owned by this client with the same
+ *         Session Description Protocol data.
+ */
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_add_sender(
+    NvNmosClient *client,
+    const NvNmosSenderConfig *config);
+
+/**
+ * Remove an NMOS Sender owned by this client from the daemon's Node.
+ *
+ * @param[in] client Pointer to the client.
+ * @param[in] id     The unique identifier for the sender.
+ * @return @ref NVNMOS_STATUS_OK if the sender has been successfully
+ *         removed.
+ */
+NVNMOS_CLIENT_API
+NvNmosStatus nmos_client_remove_sender(
+    NvNmosClient *client,
+    const char *id);
+
+/**
+ * Get the file descriptor which becomes readable when events may be
+ * available, for the application to poll.
+ *
+ * @param[in] client Pointer to the client.
+ * @return The file descriptor, or -1 on error.
+ */
+NVNMOS_CLIENT_API
+int nmos_client_get_event_fd(
+    NvNmosClient *client);
+
+/**
+ * Get the next event, without blocking.
+ *
+ * This does not make a system call unless there is no event, and
+ * may be called by a single thread at a time.
+ *
+ * @param[in]  client Pointer to the client.
+ * @param[out] event  Pointer to receive the event.
+ * @return Whether an event has been returned.
+ */
+NVNMOS_CLIENT_API
+bool nmos_client_next_event(
+    NvNmosClient *client,
+    NvNmosClientEvent *event);
+
+/**
+ * Indicate that the client's data plane is alive, for the daemon's
+ * data plane liveness monitoring. See
+ * @ref NvNmosNodeConfig::data_plane_timeout.
+ *
+ * This is a single atomic increment in shared memory, so may be
+ * called on a real-time thread.
+ *
+ * @param[in] client Pointer to the client.
+ * @return Whether the indication has been successfully recorded.
+ */
+NVNMOS_CLIENT_API
+bool nmos_client_data_plane_alive(
+    NvNmosClient *client);
+
+/**
+ * Get the statistics of the events delivered to the client.
+ *
+ * @param[in]  client Pointer to the client.
+ * @param[out] stats  Pointer to receive the statistics.
+ * @return Whether the statistics have been returned.
+ */
+NVNMOS_CLIENT_API
+bool nmos_client_get_stats(
+    NvNmosClient *client,
+    NvNmosClientStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @} */
@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_connection_index.h"
+
+#include "nmos/json_fields.h"
+#include "nvnmos_impl.h"
+
+namespace nvnmos
+{
+    // index the specified receiver from its /active endpoint after it has been changed, while holding the model lock
+    // a sender is ignored, and a receiver which has been removed is forgotten
+    void connection_index::update(const nmos::resources& node_resources, const nmos::resources& connection_resources, const nmos::id& id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto found = receivers.find(id);
+        if (receivers.end() != found) erase(found);
+
+        // a resource without data has been erased, but not yet forgotten
+        auto connection_receiver = nmos::find_resource(connection_resources, { id, nmos::types::receiver });
+        if (connection_resources.end() == connection_receiver || !connection_receiver->has_data()) return;
+
+        auto receiver = nmos::find_resource(node_resources, { id, nmos::types::receiver });
+        if (node_resources.end() == receiver) return;
+
+        indexed_receiver indexed;
+        indexed.internal_id = utility::us2s(node_implementation_get_internal_id(*receiver));
+
+        const auto& endpoint_active = nmos::fields::endpoint_active(connection_receiver->data);
+        if (nmos::fields::master_enable(endpoint_active))
+        {
+            const auto& sender_id_or_null = nmos::fields::sender_id(endpoint_active);
+            if (!sender_id_or_null.is_null()) indexed.sender_id = sender_id_or_null.as_string();
+
+            for (const auto& params : nmos::fields::transport_params(endpoint_active))
+            {
+                if (!nmos::fields::rtp_enabled(params)) continue;
+                const auto& multicast_ip_or_null = nmos::fields::multicast_ip(params);
+                if (multicast_ip_or_null.is_string()) indexed.groups.insert(multicast_ip_or_null.as_string());
+            }
+        }
+
+        insert(id, std::move(indexed));
+    }
+
+    // forget the specified receiver when it has been removed
+    void connection_index::erase(const nmos::id& id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = receivers.find(id);
+        if (receivers.end() != found) erase(found);
+    }
+
+    // forget all the receivers when they have all been removed
+    void connection_index::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        receivers.clear();
+        by_sender.clear();
+        by_group.clear();
+    }
+
+    // get the internal ids of the active receivers connected to the specified sender
+    std::vector<std::string> connection_index::find_receivers_by_sender(const utility::string_t& sender_id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return find(by_sender, sender_id);
+    }
+
+    // get the internal ids of the active receivers which have joined the specified multicast group, on any enabled leg
+    std::vector<std::string> connection_index::find_receivers_by_group(const utility::string_t& group) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return find(by_group, group);
+    }
+
+    void connection_index::insert(const utility::string_t& id, indexed_receiver receiver)
+    {
+        if (!receiver.sender_id.empty()) by_sender[receiver.sender_id].insert(id);
+        for (const auto& group : receiver.groups) by_group[group].insert(id);
+        receivers.insert({ id, std::move(receiver) });
+    }
+
+    void connection_index::erase(std::map<utility::string_t, indexed_receiver>::iterator receiver)
+    {
+        auto unindex = [&](receiver_ids& index, const utility::string_t& key)
+        {
+            auto found = index.find(key);
+            if (index.end() == found) return;
+            found->second.erase(receiver->first);
+            if (found->second.empty()) index.erase(found);
+        };
+
+        if (!receiver->second.sender_id.empty()) unindex(by_sender, receiver->second.sender_id);
+        for (const auto& group : receiver->second.groups) unindex(by_group, group);
+        receivers.erase(receiver);
+    }
+
+    std::vector<std::string> connection_index::find(const receiver_ids& index, const utility::string_t& key) const
+    {
+        std::vector<std::string> result;
+        auto found = index.find(key);
+        if (index.end() == found) return result;
+
+        result.reserve(found->second.size());
+        for (const auto& id : found->second)
+        {
+            result.push_back(receivers.at(id).internal_id);
+        }
+        return result;
+    }
+}
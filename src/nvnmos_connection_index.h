@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_CONNECTION_INDEX_H
+#define NVNMOS_CONNECTION_INDEX_H
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "cpprest/json_utils.h"
+#include "nmos/id.h"
+#include "nmos/resources.h"
+
+namespace nvnmos
+{
+    // Index of the node's receivers by the remote sender, and by the multicast group, of their IS-05 /active endpoints, so that
+    // the receivers affected by a change upstream are found without parsing every /active endpoint
+    // The index is updated incrementally wherever a receiver's /active endpoint is changed, i.e. by an activation, a rollback or
+    // replication, and wherever a receiver is removed, and has its own lock, so it can be searched without the model lock
+    class connection_index
+    {
+    public:
+        // index the specified receiver from its /active endpoint after it has been changed, while holding the model lock
+        // a sender is ignored, and a receiver which has been removed is forgotten
+        void update(const nmos::resources& node_resources, const nmos::resources& connection_resources, const nmos::id& id);
+
+        // forget the specified receiver when it has been removed
+        void erase(const nmos::id& id);
+
+        // forget all the receivers when they have all been removed
+        void clear();
+
+        // get the internal ids of the active receivers connected to the specified sender
+        std::vector<std::string> find_receivers_by_sender(const utility::string_t& sender_id) const;
+
+        // get the internal ids of the active receivers which have joined the specified multicast group, on any enabled leg
+        std::vector<std::string> find_receivers_by_group(const utility::string_t& group) const;
+
+    private:
+        typedef std::map<utility::string_t, std::set<utility::string_t>> receiver_ids; // by sender id or group
+
+        struct indexed_receiver
+        {
+            std::string internal_id;
+            utility::string_t sender_id; // empty if not connected
+            std::set<utility::string_t> groups;
+        };
+
+        void insert(const utility::string_t& id, indexed_receiver receiver);
+        void erase(std::map<utility::string_t, indexed_receiver>::iterator receiver);
+        std::vector<std::string> find(const receiver_ids& index, const utility::string_t& key) const;
+
+        mutable std::mutex mutex;
+        std::map<utility::string_t, indexed_receiver> receivers; // by receiver id
+        receiver_ids by_sender;
+        receiver_ids by_group;
+    };
+}
+
+#endif
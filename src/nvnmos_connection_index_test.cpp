@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This checks the connection index, i.e. that receivers are found by the sender and by the multicast groups of their /active endpoints,
+// only on enabled legs and only while active, and that they are unindexed when updated, removed or cleared
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "nmos/connection_resources.h"
+#include "nmos/is04_versions.h"
+#include "nmos/json_fields.h"
+#include "nvnmos_connection_index.h"
+
+namespace
+{
+    bool check(bool condition, const char* description)
+    {
+        if (!condition) std::fprintf(stderr, "Failed: %s\n", description);
+        return condition;
+    }
+
+    // a minimal receiver, with the internal id tag, see nvnmos::node_implementation_get_internal_id
+    nmos::resource make_receiver(const nmos::id& id, const utility::string_t& internal_id)
+    {
+        using web::json::value_of;
+
+        auto data = value_of({
+            { nmos::fields::id, id },
+            { nmos::fields::tags, value_of({
+                { U("urn:x-nvnmos:id"), value_of({ internal_id }) }
+            }) }
+        });
+        return nmos::resource(nmos::is04_versions::v1_3, nmos::types::receiver, std::move(data), false);
+    }
+
+    web::json::value make_transport_params(bool rtp_enabled, const utility::string_t& multicast_ip)
+    {
+        using web::json::value;
+        using web::json::value_of;
+
+        return value_of({
+            { nmos::fields::rtp_enabled, rtp_enabled },
+            { nmos::fields::multicast_ip, multicast_ip.empty() ? value::null() : value::string(multicast_ip) }
+        });
+    }
+
+    // add a receiver to the node and connection resources, and index it
+    void insert_receiver(nmos::resources& node_resources, nmos::resources& connection_resources, nvnmos::connection_index& connections, const nmos::id& id)
+    {
+        nmos::insert_resource(node_resources, make_receiver(id, id));
+        nmos::insert_resource(connection_resources, nmos::make_connection_rtp_receiver(id, true));
+        connections.update(node_resources, connection_resources, id);
+    }
+
+    // activate a receiver, and index it
+    void activate_receiver(nmos::resources& node_resources, nmos::resources& connection_resources, nvnmos::connection_index& connections, const nmos::id& id, bool master_enable, const utility::string_t& sender_id, const web::json::value& transport_params)
+    {
+        using web::json::value;
+        using web::json::value_of;
+
+        nmos::modify_resource(connection_resources, id, [&](nmos::resource& resource)
+        {
+            resource.data[nmos::fields::endpoint_active] = value_of({
+                { nmos::fields::master_enable, master_enable },
+                { nmos::fields::sender_id, sender_id.empty() ? value::null() : value::string(sender_id) },
+                { nmos::fields::transport_params, transport_params }
+            });
+        });
+        connections.update(node_resources, connection_resources, id);
+    }
+
+    bool equal(std::vector<std::string> actual, std::vector<std::string> expected)
+    {
+        std::sort(actual.begin(), actual.end());
+        std::sort(expected.begin(), expected.end());
+        return actual == expected;
+    }
+
+    bool test_find()
+    {
+        using web::json::value_of;
+
+        nmos::resources node_resources;
+        nmos::resources connection_resources;
+        nvnmos::connection_index connections;
+
+        insert_receiver(node_resources, connection_resources, connections, U("receiver-0"));
+        insert_receiver(node_resources, connection_resources, connections, U("receiver-1"));
+        insert_receiver(node_resources, connection_resources, connections, U("receiver-2"));
+
+        bool success = true;
+        success = check(connections.find_receivers_by_sender(U("sender-0")).empty(), "nothing found before activation") && success;
+
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-0"), true, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(true, U("233.252.1.0"))
+        }));
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-1"), true, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(false, U("233.252.1.1"))
+        }));
+        // an inactive receiver isn't connected to its staged sender
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-2"), false, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(true, U("233.252.1.0"))
+        }));
+
+        success = check(equal(connections.find_receivers_by_sender(U("sender-0")), { "receiver-0", "receiver-1" }), "find by sender") && success;
+        success = check(equal(connections.find_receivers_by_group(U("233.252.0.0")), { "receiver-0", "receiver-1" }), "find by group on the first leg") && success;
+        success = check(equal(connections.find_receivers_by_group(U("233.252.1.0")), { "receiver-0" }), "find by group on the second leg") && success;
+        success = check(connections.find_receivers_by_group(U("233.252.1.1")).empty(), "nothing found by group on a disabled leg") && success;
+        success = check(connections.find_receivers_by_sender(U("sender-1")).empty(), "nothing found for another sender") && success;
+        return success;
+    }
+
+    bool test_update()
+    {
+        using web::json::value_of;
+
+        nmos::resources node_resources;
+        nmos::resources connection_resources;
+        nvnmos::connection_index connections;
+
+        insert_receiver(node_resources, connection_resources, connections, U("receiver-0"));
+        insert_receiver(node_resources, connection_resources, connections, U("receiver-1"));
+
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-0"), true, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(true, U("233.252.1.0"))
+        }));
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-1"), true, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(true, U("233.252.1.0"))
+        }));
+
+        bool success = true;
+
+        // a receiver which is connected to another sender is unindexed from the old sender and groups
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-0"), true, U("sender-1"), value_of({
+            make_transport_params(true, U("233.252.0.1")),
+            make_transport_params(true, U(""))
+        }));
+        success = check(equal(connections.find_receivers_by_sender(U("sender-0")), { "receiver-1" }), "find by the old sender after update") && success;
+        success = check(equal(connections.find_receivers_by_sender(U("sender-1")), { "receiver-0" }), "find by the new sender after update") && success;
+        success = check(equal(connections.find_receivers_by_group(U("233.252.1.0")), { "receiver-1" }), "find by the old group after update") && success;
+        success = check(equal(connections.find_receivers_by_group(U("233.252.0.1")), { "receiver-0" }), "find by the new group after update") && success;
+
+        // a receiver which is deactivated is no longer connected
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-1"), false, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(true, U("233.252.1.0"))
+        }));
+        success = check(connections.find_receivers_by_sender(U("sender-0")).empty(), "nothing found by sender after deactivation") && success;
+        success = check(connections.find_receivers_by_group(U("233.252.1.0")).empty(), "nothing found by group after deactivation") && success;
+
+        // a receiver which has been removed is forgotten, either when updated or erased
+        nmos::erase_resource(connection_resources, U("receiver-0"));
+        connections.update(node_resources, connection_resources, U("receiver-0"));
+        success = check(connections.find_receivers_by_sender(U("sender-1")).empty(), "nothing found after update of a removed receiver") && success;
+
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-1"), true, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(true, U("233.252.1.0"))
+        }));
+        connections.erase(U("receiver-1"));
+        success = check(connections.find_receivers_by_sender(U("sender-0")).empty(), "nothing found by sender after erase") && success;
+        success = check(connections.find_receivers_by_group(U("233.252.0.0")).empty(), "nothing found by group after erase") && success;
+        return success;
+    }
+
+    bool test_clear()
+    {
+        using web::json::value_of;
+
+        nmos::resources node_resources;
+        nmos::resources connection_resources;
+        nvnmos::connection_index connections;
+
+        insert_receiver(node_resources, connection_resources, connections, U("receiver-0"));
+        activate_receiver(node_resources, connection_resources, connections, U("receiver-0"), true, U("sender-0"), value_of({
+            make_transport_params(true, U("233.252.0.0")),
+            make_transport_params(true, U("233.252.1.0"))
+        }));
+
+        connections.clear();
+
+        bool success = true;
+        success = check(connections.find_receivers_by_sender(U("sender-0")).empty(), "nothing found by sender after clear") && success;
+        success = check(connections.find_receivers_by_group(U("233.252.0.0")).empty(), "nothing found by group after clear") && success;
+        return success;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool success = true;
+    success = test_find() && success;
+    success = test_update() && success;
+    success = test_clear() && success;
+
+    std::fprintf(stderr, "%s\n", success ? "Passed" : "Failed");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_event_loop.h"
+
+#include <algorithm>
+#include <climits>
+#include <thread>
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+namespace nvnmos
+{
+    // add a task, with an optional file descriptor which becomes readable when the task should be run early
+    void event_loop::add(node_implementation_task task, int fd)
+    {
+        // each task is first run immediately
+        entries.push_back({ std::move(task), fd, {} });
+    }
+
+    // run the tasks which are due or whose file descriptors are readable, first waiting up to the specified timeout
+    // for one of them to become so if none are
+    void event_loop::run_once(std::chrono::milliseconds timeout)
+    {
+        std::vector<bool> ready(entries.size(), false);
+
+        const auto wait = (std::min)(timeout, next_timeout());
+#ifndef _WIN32
+        std::vector<pollfd> pfds;
+        std::vector<size_t> indices;
+        for (size_t i = 0; i != entries.size(); ++i)
+        {
+            if (-1 == entries[i].fd) continue;
+            pfds.push_back({ entries[i].fd, POLLIN, 0 });
+            indices.push_back(i);
+        }
+        if (!pfds.empty() || std::chrono::milliseconds::zero() < wait)
+        {
+            const auto wait_ms = (int)(std::min)(wait.count(), (std::chrono::milliseconds::rep)INT_MAX);
+            if (0 < ::poll(pfds.data(), (nfds_t)pfds.size(), wait_ms))
+            {
+                for (size_t p = 0; p != pfds.size(); ++p)
+                {
+                    if (0 != (pfds[p].revents & POLLIN)) ready[indices[p]] = true;
+                }
+            }
+        }
+#else
+        if (std::chrono::milliseconds::zero() < wait) std::this_thread::sleep_for(wait);
+#endif
+
+        const auto now = node_implementation_task_clock::now();
+        for (size_t i = 0; i != entries.size(); ++i)
+        {
+            auto& entry = entries[i];
+            if (ready[i] || entry.due <= now) entry.due = entry.task();
+        }
+    }
+
+    // get the file descriptors for the application to poll for readability
+    std::vector<int> event_loop::poll_fds() const
+    {
+        std::vector<int> fds;
+        for (const auto& entry : entries)
+        {
+            if (-1 != entry.fd) fds.push_back(entry.fd);
+        }
+        return fds;
+    }
+
+    // get the time until the next task is due, which is zero if one is due now
+    std::chrono::milliseconds event_loop::next_timeout() const
+    {
+        if (entries.empty()) return std::chrono::milliseconds::max();
+
+        const auto due = std::min_element(entries.begin(), entries.end(), [](const entry& lhs, const entry& rhs) { return lhs.due < rhs.due; })->due;
+        const auto now = node_implementation_task_clock::now();
+        if (due <= now) return std::chrono::milliseconds::zero();
+
+        // round up so that the task is due when the application's wait ends
+        return std::chrono::duration_cast<std::chrono::milliseconds>(due - now) + std::chrono::milliseconds(1);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_EVENT_LOOP_H
+#define NVNMOS_EVENT_LOOP_H
+
+#include <vector>
+#include "nvnmos_impl.h"
+
+namespace nvnmos
+{
+    // Runs the node implementation's tasks from the application's event loop, rather than from their own threads
+    // The member functions must not be called concurrently
+    class event_loop
+    {
+    public:
+        // add a task, with an optional file descriptor which becomes readable when the task should be run early
+        void add(node_implementation_task task, int fd = -1);
+
+        // run the tasks which are due or whose file descriptors are readable, first waiting up to the specified timeout
+        // for one of them to become so if none are
+        void run_once(std::chrono::milliseconds timeout);
+
+        // get the file descriptors for the application to poll for readability
+        std::vector<int> poll_fds() const;
+
+        // get the time until the next task is due, which is zero if one is due now
+        std::chrono::milliseconds next_timeout() const;
+
+    private:
+        struct entry
+        {
+            node_implementation_task task;
+            int fd;
+            node_implementation_task_clock::time_point due;
+        };
+
+        std::vector<entry> entries;
+    };
+}
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_format.h"
+
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/irange.hpp>
+#include "nmos/capabilities.h"
+#include "nmos/channels.h"
+#include "nmos/colorspace.h"
+#include "nmos/interlace_mode.h"
+#include "nmos/json_fields.h"
+#include "nmos/node_resources.h"
+#include "nmos/sdp_utils.h"
+#include "nmos/transfer_characteristic.h"
+#include "nmos/transport.h"
+#include "nvnmos_sdp_store.h"
+
+namespace nvnmos
+{
+    namespace impl
+    {
+        // video/raw
+        class video_raw_format_handler final : public format_handler
+        {
+        public:
+            bool make_source_and_flow(nmos::resource& source, nmos::resource& flow, const nmos::id& source_id, const nmos::id& flow_id, const nmos::id& device_id, const nmos::clock_name& clock, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                const auto video = nmos::get_video_raw_parameters(sdp.sdp_params);
+
+                source = nmos::make_video_source(source_id, device_id, clock, video.exactframerate, settings);
+                flow = nmos::make_raw_video_flow(
+                    flow_id, source_id, device_id,
+                    video.exactframerate,
+                    video.width, video.height, video.interlace ? nmos::interlace_modes::interlaced_tff : nmos::interlace_modes::progressive,
+                    nmos::colorspace{ video.colorimetry.name }, nmos::transfer_characteristic{ video.tcs.name }, video.sampling, video.depth,
+                    settings
+                );
+                return true;
+            }
+
+            bool make_receiver(nmos::resource& receiver, const nmos::id& receiver_id, const nmos::id& device_id, const std::vector<utility::string_t>& interface_names, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                using web::json::value;
+                using web::json::value_of;
+
+                const auto video = nmos::get_video_raw_parameters(sdp.sdp_params);
+
+                receiver = nmos::make_video_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, settings);
+                // add a constraint set; these should be completed fully!
+                const auto interlace_modes = video.interlace
+                    ? std::vector<utility::string_t>{ nmos::interlace_modes::interlaced_bff.name, nmos::interlace_modes::interlaced_tff.name, nmos::interlace_modes::interlaced_psf.name }
+                    : std::vector<utility::string_t>{ nmos::interlace_modes::progressive.name };
+                receiver.data[nmos::fields::caps][nmos::fields::constraint_sets] = value_of({
+                    value_of({
+                        { nmos::caps::format::grain_rate, nmos::make_caps_rational_constraint({ video.exactframerate }) },
+                        { nmos::caps::format::frame_width, nmos::make_caps_integer_constraint({ video.width }) },
+                        { nmos::caps::format::frame_height, nmos::make_caps_integer_constraint({ video.height }) },
+                        { nmos::caps::format::interlace_mode, nmos::make_caps_string_constraint(interlace_modes) },
+                        { nmos::caps::format::color_sampling, nmos::make_caps_string_constraint({ video.sampling.name }) }
+                    })
+                });
+                receiver.data[nmos::fields::version] = receiver.data[nmos::fields::caps][nmos::fields::version] = value(nmos::make_version());
+                return true;
+            }
+        };
+
+        // audio/L24 or audio/L16
+        class audio_L_format_handler final : public format_handler
+        {
+        public:
+            bool make_source_and_flow(nmos::resource& source, nmos::resource& flow, const nmos::id& source_id, const nmos::id& flow_id, const nmos::id& device_id, const nmos::clock_name& clock, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                const auto audio = nmos::get_audio_L_parameters(sdp.sdp_params);
+
+                // hm, if present, should parse audio.channel_order into the equivalent vector of nmos::channel
+                // but currently no nmos::parse_fmtp_channel_order
+                const auto channels = boost::copy_range<std::vector<nmos::channel>>(
+                    boost::irange(0, (int)audio.channel_count) | boost::adaptors::transformed([&](const int& index)
+                {
+                    return nmos::channel{ U(""), nmos::channel_symbols::Undefined(1 + index) };
+                }));
+
+                // hmm, should this take account of audio.packet_time?
+                const nmos::rational grain_rate = audio.sample_rate;
+
+                source = nmos::make_audio_source(source_id, device_id, clock, grain_rate, channels, settings);
+                flow = nmos::make_raw_audio_flow(flow_id, source_id, device_id, audio.sample_rate, audio.bit_depth, settings);
+                flow.data[nmos::fields::grain_rate] = nmos::make_rational(grain_rate);
+                return true;
+            }
+
+            bool make_receiver(nmos::resource& receiver, const nmos::id& receiver_id, const nmos::id& device_id, const std::vector<utility::string_t>& interface_names, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                using web::json::value;
+                using web::json::value_of;
+
+                const auto& sdp_params = sdp.sdp_params;
+                const auto audio = nmos::get_audio_L_parameters(sdp_params);
+
+                receiver = nmos::make_audio_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, audio.bit_depth, settings);
+                // add a constraint set; these should be completed fully!
+                receiver.data[nmos::fields::caps][nmos::fields::constraint_sets] = value_of({
+                    value_of({
+                        { nmos::caps::format::channel_count, nmos::make_caps_integer_constraint({ audio.channel_count }) },
+                        { nmos::caps::format::sample_rate, nmos::make_caps_rational_constraint({ audio.sample_rate }) },
+                        { nmos::caps::format::sample_depth, nmos::make_caps_integer_constraint({ audio.bit_depth }) },
+                        { 0 != sdp_params.packet_time ? nmos::caps::transport::packet_time.key : U(""), nmos::make_caps_number_constraint({ sdp_params.packet_time }) },
+                        { 0 != sdp_params.max_packet_time ? nmos::caps::transport::max_packet_time.key : U(""), nmos::make_caps_number_constraint({ sdp_params.max_packet_time }) }
+                    })
+                });
+                receiver.data[nmos::fields::version] = receiver.data[nmos::fields::caps][nmos::fields::version] = value(nmos::make_version());
+                return true;
+            }
+        };
+
+        // video/smpte291
+        class video_smpte291_format_handler final : public format_handler
+        {
+        public:
+            bool make_source_and_flow(nmos::resource& source, nmos::resource& flow, const nmos::id& source_id, const nmos::id& flow_id, const nmos::id& device_id, const nmos::clock_name& clock, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                const auto data = nmos::get_video_smpte291_parameters(sdp.sdp_params);
+
+                const nmos::rational grain_rate = data.exactframerate;
+
+                source = nmos::make_data_source(source_id, device_id, clock, grain_rate, settings);
+                flow = nmos::make_sdianc_data_flow(flow_id, source_id, device_id, data.did_sdids, settings);
+                flow.data[nmos::fields::grain_rate] = nmos::make_rational(grain_rate);
+                return true;
+            }
+
+            bool make_receiver(nmos::resource& receiver, const nmos::id& receiver_id, const nmos::id& device_id, const std::vector<utility::string_t>& interface_names, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                using web::json::value;
+                using web::json::value_of;
+
+                const auto data = nmos::get_video_smpte291_parameters(sdp.sdp_params);
+
+                receiver = nmos::make_sdianc_data_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, settings);
+                // add a constraint set; these should be completed fully!
+                if (data.exactframerate)
+                {
+                    receiver.data[nmos::fields::caps][nmos::fields::constraint_sets] = value_of({
+                        value_of({
+                            { nmos::caps::format::grain_rate, nmos::make_caps_rational_constraint({ data.exactframerate }) }
+                        })
+                    });
+                    receiver.data[nmos::fields::version] = receiver.data[nmos::fields::caps][nmos::fields::version] = value(nmos::make_version());
+                }
+                return true;
+            }
+        };
+
+        // video/SMPTE2022-6
+        class video_SMPTE2022_6_format_handler final : public format_handler
+        {
+        public:
+            bool make_source_and_flow(nmos::resource& source, nmos::resource& flow, const nmos::id& source_id, const nmos::id& flow_id, const nmos::id& device_id, const nmos::clock_name& clock, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                const auto mux = nmos::get_video_SMPTE2022_6_parameters(sdp.sdp_params);
+
+                // hmm, this should take account of sdp_params.framerate
+                const nmos::rational grain_rate = nmos::rates::rate50;
+
+                source = nmos::make_mux_source(source_id, device_id, clock, grain_rate, settings);
+                flow = nmos::make_mux_flow(flow_id, source_id, device_id, settings);
+                flow.data[nmos::fields::grain_rate] = nmos::make_rational(grain_rate);
+                return true;
+            }
+
+            bool make_receiver(nmos::resource& receiver, const nmos::id& receiver_id, const nmos::id& device_id, const std::vector<utility::string_t>& interface_names, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                const auto mux = nmos::get_video_SMPTE2022_6_parameters(sdp.sdp_params);
+
+                receiver = nmos::make_mux_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, settings);
+                // hmm, add a constraint set, e.g. taking account of sdp_params.framerate
+                return true;
+            }
+        };
+
+        // a custom format, whose resources are completed by the application
+        class custom_format_handler final : public format_handler
+        {
+        public:
+            custom_format_handler(const nmos::format& format, const nmos::media_type& media_type, format_resource_patcher patch_resource)
+                : format(format)
+                , media_type(media_type)
+                , patch_resource(std::move(patch_resource))
+            {}
+
+            bool make_source_and_flow(nmos::resource& source, nmos::resource& flow, const nmos::id& source_id, const nmos::id& flow_id, const nmos::id& device_id, const nmos::clock_name& clock, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                using web::json::value;
+
+                // the application can patch the grain rate, and any other format-specific properties
+                const nmos::rational grain_rate = nmos::rates::rate25;
+
+                if (nmos::formats::video == format) source = nmos::make_video_source(source_id, device_id, clock, grain_rate, settings);
+                else if (nmos::formats::audio == format) source = nmos::make_audio_source(source_id, device_id, clock, grain_rate, {}, settings);
+                else if (nmos::formats::data == format) source = nmos::make_data_source(source_id, device_id, clock, grain_rate, settings);
+                else source = nmos::make_mux_source(source_id, device_id, clock, grain_rate, settings);
+
+                // the mux flow has no format-specific properties, so it is a minimal flow once its format and media type are set
+                flow = nmos::make_mux_flow(flow_id, source_id, device_id, settings);
+                flow.data[nmos::fields::format] = value::string(format.name);
+                flow.data[nmos::fields::media_type] = value::string(media_type.name);
+                flow.data[nmos::fields::grain_rate] = nmos::make_rational(grain_rate);
+
+                return patch(source, sdp) && patch(flow, sdp);
+            }
+
+            bool make_receiver(nmos::resource& receiver, const nmos::id& receiver_id, const nmos::id& device_id, const std::vector<utility::string_t>& interface_names, const sdp_entry& sdp, const nmos::settings& settings) const override
+            {
+                using web::json::value;
+                using web::json::value_of;
+
+                // likewise, the mux receiver is a minimal receiver once its format and media types are set
+                receiver = nmos::make_mux_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, settings);
+                receiver.data[nmos::fields::format] = value::string(format.name);
+                receiver.data[nmos::fields::caps][nmos::fields::media_types] = value_of({ media_type.name });
+
+                return patch(receiver, sdp);
+            }
+
+        private:
+            bool patch(nmos::resource& resource, const sdp_entry& sdp) const
+            {
+                if (!patch_resource) return true;
+
+                web::json::value patch;
+                if (!patch_resource(resource.type.name, sdp.text, patch)) return false;
+                if (!patch.is_null()) web::json::merge_patch(resource.data, patch, true);
+                return true;
+            }
+
+            const nmos::format format;
+            const nmos::media_type media_type;
+            const format_resource_patcher patch_resource;
+        };
+    }
+
+    // construct a registry with the handlers for the built-in formats
+    format_registry::format_registry()
+    {
+        const auto audio_L = std::make_shared<impl::audio_L_format_handler>();
+
+        insert(nmos::media_types::video_raw, std::make_shared<impl::video_raw_format_handler>());
+        insert(nmos::media_types::audio_L(24), audio_L);
+        insert(nmos::media_types::audio_L(16), audio_L);
+        insert(nmos::media_types::video_smpte291, std::make_shared<impl::video_smpte291_format_handler>());
+        insert(nmos::media_types::video_SMPTE2022_6, std::make_shared<impl::video_SMPTE2022_6_format_handler>());
+    }
+
+    // insert the handler for the specified media type, replacing any existing handler
+    void format_registry::insert(const nmos::media_type& media_type, std::shared_ptr<const format_handler> handler)
+    {
+        handlers[media_type.name] = std::move(handler);
+    }
+
+    // get the handler for the specified media type, or null if it isn't supported
+    const format_handler* format_registry::find(const nmos::media_type& media_type) const
+    {
+        auto found = handlers.find(media_type.name);
+        return handlers.end() != found ? found->second.get() : nullptr;
+    }
+
+    // This makes a handler for a custom format, which makes minimal resources with the specified format and media type
+    // and then applies the patches from the callback, if any
+    std::shared_ptr<const format_handler> make_custom_format_handler(const nmos::format& format, const nmos::media_type& media_type, format_resource_patcher patch_resource)
+    {
+        return std::make_shared<impl::custom_format_handler>(format, media_type, std::move(patch_resource));
+    }
+}
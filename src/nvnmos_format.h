@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_FORMAT_H
+#define NVNMOS_FORMAT_H
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "nmos/clock_name.h"
+#include "nmos/format.h"
+#include "nmos/id.h"
+#include "nmos/media_type.h"
+#include "nmos/resource.h"
+#include "nmos/settings.h"
+
+namespace nvnmos
+{
+    struct sdp_entry;
+
+    // Handler for the format-specific parts of the resources of a sender or receiver whose SDP data has a particular media type
+    class format_handler
+    {
+    public:
+        virtual ~format_handler() {}
+
+        // make the source and flow for a sender, returning false if the SDP data doesn't have the required parameters
+        virtual bool make_source_and_flow(nmos::resource& source, nmos::resource& flow, const nmos::id& source_id, const nmos::id& flow_id, const nmos::id& device_id, const nmos::clock_name& clock, const sdp_entry& sdp, const nmos::settings& settings) const = 0;
+
+        // make a receiver, including its capabilities, returning false if the SDP data doesn't have the required parameters
+        virtual bool make_receiver(nmos::resource& receiver, const nmos::id& receiver_id, const nmos::id& device_id, const std::vector<utility::string_t>& interface_names, const sdp_entry& sdp, const nmos::settings& settings) const = 0;
+    };
+
+    // Registry of the format handlers, by media type
+    // Handlers are inserted before the registry is used, since it is then read concurrently without locking
+    class format_registry
+    {
+    public:
+        // construct a registry with the handlers for the built-in formats, i.e. video/raw, audio/L24, audio/L16, video/smpte291
+        // and video/SMPTE2022-6
+        format_registry();
+
+        // insert the handler for the specified media type, replacing any existing handler
+        void insert(const nmos::media_type& media_type, std::shared_ptr<const format_handler> handler);
+
+        // get the handler for the specified media type, or null if it isn't supported
+        const format_handler* find(const nmos::media_type& media_type) const;
+
+    private:
+        std::unordered_map<utility::string_t, std::shared_ptr<const format_handler>> handlers;
+    };
+
+    // This is an application callback to complete the data of the specified "source", "flow" or "receiver" of a custom format,
+    // from its SDP data, by returning a JSON merge patch. It returns false if the SDP data isn't acceptable.
+    typedef std::function<bool(const utility::string_t& type, const std::string& sdp, web::json::value& patch)> format_resource_patcher;
+
+    // This makes a handler for a custom format, which makes minimal resources with the specified format and media type
+    // and then applies the patches from the callback, if any
+    std::shared_ptr<const format_handler> make_custom_format_handler(const nmos::format& format, const nmos::media_type& media_type, format_resource_patcher patch_resource);
+}
+
+#endif
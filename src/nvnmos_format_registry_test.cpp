@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This checks the format registry, i.e. that the built-in formats are dispatched by media type, that unsupported media types aren't,
+// and that a custom format handler can be added, or replace a built-in one, and makes resources patched by the application callback
+
+#include <cstdio>
+#include <string>
+#include "nmos/format.h"
+#include "nmos/json_fields.h"
+#include "nmos/media_type.h"
+#include "nvnmos_format.h"
+#include "nvnmos_sdp_store.h"
+#include "nvnmos_test_fixture.h"
+
+namespace
+{
+    bool check(bool condition, const char* description)
+    {
+        if (!condition) std::fprintf(stderr, "Failed: %s\n", description);
+        return condition;
+    }
+
+    const nmos::media_type video_jxsv{ U("video/jxsv") };
+
+    // the receiver's media types, or null if it has none
+    web::json::value get_media_types(const nmos::resource& receiver)
+    {
+        const auto& caps = nmos::fields::caps(receiver.data);
+        return caps.has_field(nmos::fields::media_types) ? nmos::fields::media_types(caps) : web::json::value::null();
+    }
+
+    bool test_built_in()
+    {
+        const nvnmos::format_registry formats;
+
+        bool success = true;
+        success = check(nullptr != formats.find(nmos::media_types::video_raw), "video/raw is supported") && success;
+        success = check(nullptr != formats.find(nmos::media_types::audio_L(24)), "audio/L24 is supported") && success;
+        success = check(nullptr != formats.find(nmos::media_types::audio_L(16)), "audio/L16 is supported") && success;
+        success = check(nullptr != formats.find(nmos::media_types::video_smpte291), "video/smpte291 is supported") && success;
+        success = check(nullptr != formats.find(nmos::media_types::video_SMPTE2022_6), "video/SMPTE2022-6 is supported") && success;
+        success = check(formats.find(nmos::media_types::audio_L(24)) == formats.find(nmos::media_types::audio_L(16)), "audio/L24 and audio/L16 share a handler") && success;
+        success = check(formats.find(nmos::media_types::video_raw) != formats.find(nmos::media_types::video_smpte291), "video/raw and video/smpte291 have different handlers") && success;
+        success = check(nullptr == formats.find(video_jxsv), "video/jxsv isn't supported") && success;
+        success = check(nullptr == formats.find(nmos::media_types::audio_L(20)), "audio/L20 isn't supported") && success;
+
+        // the video/raw handler makes a receiver from the SDP data
+        const nvnmos::sdp_entry sdp(nvnmos::test::make_sdp("receiver-0", nvnmos::test::make_multicast_address(0), false));
+        const nmos::settings settings = web::json::value::object();
+        nmos::resource receiver;
+        const auto handler = formats.find(nmos::media_types::video_raw);
+        success = check(nullptr != handler && handler->make_receiver(receiver, U("receiver-0"), U("device-0"), { U("eth0") }, sdp, settings), "video/raw handler makes a receiver") && success;
+        success = check(nmos::formats::video.name == nmos::fields::format(receiver.data), "video/raw receiver has the video format") && success;
+        success = check(web::json::value_of({ nmos::media_types::video_raw.name }) == get_media_types(receiver), "video/raw receiver has the video/raw media type") && success;
+        return success;
+    }
+
+    bool test_custom()
+    {
+        nvnmos::format_registry formats;
+
+        utility::string_t patched_type;
+        std::string patched_sdp;
+        bool accept = true;
+        formats.insert(video_jxsv, nvnmos::make_custom_format_handler(nmos::formats::video, video_jxsv, [&](const utility::string_t& type, const std::string& sdp, web::json::value& patch)
+        {
+            patched_type = type;
+            patched_sdp = sdp;
+            patch = web::json::value_of({ { nmos::fields::label, U("patched") } });
+            return accept;
+        }));
+
+        const auto handler = formats.find(video_jxsv);
+
+        bool success = true;
+        success = check(nullptr != handler, "video/jxsv is supported after insert") && success;
+        success = check(nullptr != formats.find(nmos::media_types::video_raw), "video/raw is still supported after insert") && success;
+        if (nullptr == handler) return success;
+
+        const nvnmos::sdp_entry sdp(nvnmos::test::make_sdp("receiver-0", nvnmos::test::make_multicast_address(0), false));
+        const nmos::settings settings = web::json::value::object();
+
+        nmos::resource receiver;
+        success = check(handler->make_receiver(receiver, U("receiver-0"), U("device-0"), { U("eth0") }, sdp, settings), "custom handler makes a receiver") && success;
+        success = check(nmos::formats::video.name == nmos::fields::format(receiver.data), "custom receiver has the custom format") && success;
+        success = check(web::json::value_of({ video_jxsv.name }) == get_media_types(receiver), "custom receiver has the custom media type") && success;
+        success = check(U("patched") == nmos::fields::label(receiver.data), "custom receiver is patched") && success;
+        success = check(nmos::types::receiver.name == patched_type && sdp.text == patched_sdp, "callback has the resource type and SDP data") && success;
+
+        nmos::resource source, flow;
+        success = check(handler->make_source_and_flow(source, flow, U("source-0"), U("flow-0"), U("device-0"), nmos::clock_names::clk0, sdp, settings), "custom handler makes a source and flow") && success;
+        success = check(video_jxsv.name == nmos::fields::media_type(flow.data), "custom flow has the custom media type") && success;
+        success = check(U("patched") == nmos::fields::label(source.data) && U("patched") == nmos::fields::label(flow.data), "custom source and flow are patched") && success;
+        success = check(nmos::types::flow.name == patched_type, "callback has the last resource type") && success;
+
+        accept = false;
+        success = check(!handler->make_receiver(receiver, U("receiver-0"), U("device-0"), { U("eth0") }, sdp, settings), "custom receiver is rejected by the callback") && success;
+        return success;
+    }
+
+    bool test_replace()
+    {
+        nvnmos::format_registry formats;
+
+        // a handler without a callback makes minimal resources
+        const auto custom = nvnmos::make_custom_format_handler(nmos::formats::video, nmos::media_types::video_raw, {});
+        formats.insert(nmos::media_types::video_raw, custom);
+
+        bool success = true;
+        success = check(custom.get() == formats.find(nmos::media_types::video_raw), "insert replaces the built-in handler") && success;
+        success = check(nullptr != formats.find(nmos::media_types::video_smpte291), "other built-in handlers aren't replaced") && success;
+
+        const nvnmos::sdp_entry sdp(nvnmos::test::make_sdp("receiver-0", nvnmos::test::make_multicast_address(0), false));
+        nmos::resource receiver;
+        success = check(custom->make_receiver(receiver, U("receiver-0"), U("device-0"), { U("eth0") }, sdp, web::json::value::object()), "replacement handler makes a receiver without a callback") && success;
+        return success;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool success = true;
+    success = test_built_in() && success;
+    success = test_custom() && success;
+    success = test_replace() && success;
+
+    std::fprintf(stderr, "%s\n", success ? "Passed" : "Failed");
+    return success ? 0 : 1;
+}
@@ -25,6 +25,7 @@
 
 #include "nvnmos_impl.h"
 
+#include <sstream>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/asio/ip/address_v4.hpp>
 #include <boost/range/adaptor/filtered.hpp>
@@ -33,55 +34,47 @@
 #include <boost/range/algorithm/find_if.hpp>
 #include <boost/range/irange.hpp>
 #include "cpprest/host_utils.h"
+#include "mdns/service_advertiser.h"
+#include "mdns/service_discovery.h"
 #include "nmos/activation_mode.h"
 #include "nmos/activation_utils.h"
 #include "nmos/capabilities.h"
-#include "nmos/channels.h"
 #include "nmos/clock_name.h"
 #include "nmos/clock_ref_type.h"
-#include "nmos/colorspace.h"
 #include "nmos/connection_resources.h"
 #include "nmos/group_hint.h"
-#include "nmos/interlace_mode.h"
 #include "nmos/media_type.h"
 #include "nmos/model.h"
+#include "nmos/node_behaviour.h"
 #include "nmos/node_interfaces.h"
 #include "nmos/node_resource.h"
 #include "nmos/node_resources.h"
 #include "nmos/node_server.h"
 #include "nmos/sdp_utils.h"
+#include "nmos/server.h"
 #include "nmos/slog.h"
 #include "nmos/system_resources.h"
-#include "nmos/transfer_characteristic.h"
 #include "nmos/transport.h"
 #include "sdp/sdp.h"
+#include "nvnmos_activation_queue.h"
+#include "nvnmos_connection_index.h"
+#include "nvnmos_format.h"
+#include "nvnmos_link_events.h"
+#include "nvnmos_ptp_status.h"
+#include "nvnmos_sdp_store.h"
+#include "nvnmos_transportfile.h"
 
 namespace nvnmos
 {
     namespace fields
     {
         const web::json::field_as_value_or internal_id_tag{ U("urn:x-nvnmos:id"), web::json::value::array() };
+        const web::json::field_as_value_or link_state_tag{ U("urn:x-nvnmos:link-state"), web::json::value::array() }; // "up" or "down" for each leg
     }
 
     // node implementation details
     namespace impl
     {
-        // supported formats
-        enum class format
-        {
-            // video/raw
-            video,
-            // audio/L24 or audio/L16
-            audio,
-            // video/smpte291
-            data,
-            // video/SMPTE2022-6
-            mux
-        };
-
-        // identify supported format from media type
-        format get_format(const nmos::media_type& media_type);
-
         // like nmos::make_session_description for 'internal' use
         // with support for the custom SDP attributes in nvnmos::attributes for senders as well as receivers
         web::json::value make_session_description(const nmos::type& type, const utility::string_t& internal_id, const utility::string_t& group_hint, const utility::string_t& session_info, const nmos::sdp_parameters& sdp_params, const web::json::value& transport_params);
@@ -112,11 +105,19 @@ namespace nvnmos
         // generate a repeatable source-specific multicast address for each leg of a sender
         utility::string_t make_source_specific_multicast_address_v4(const nmos::id& id, int leg);
 
+        // set the IS-05 constraints of each leg of a sender or receiver from the configured transport parameters and settings
+        // returning false if the configured transport parameters don't satisfy them
+        bool set_endpoint_constraints(web::json::value& constraints, const nmos::type& type, const web::json::value& transport_params, const nmos::settings& settings, slog::base_gate& gate);
+
         // set the internal id for the sender or receiver as a resource tag
         void set_internal_id(nmos::resource& resource, const utility::string_t& internal_id);
         // get the internal id for the sender or receiver from a resource tag
         utility::string_t get_internal_id(const nmos::resource& resource);
 
+        // set the link state of each leg of the sender or receiver as a resource tag, from the last known link state of its interfaces
+        // returning whether it has changed
+        bool set_link_state(nmos::resource& resource, const web::json::value& link_states);
+
         // set the group hint for the sender or receiver as a resource tag
         void set_group_hint(nmos::resource& resource, const utility::string_t& group_hint);
         // get the group hint for the sender or receiver from a resource tag
@@ -133,6 +134,24 @@ namespace nvnmos
 
         // modify node resource if necessary to include all of the specified interfaces that currently have interface_bindings in any senders or receivers
         void update_node_interfaces(nmos::resources& node_resources, const nmos::id& node_id, const std::vector<web::hosts::experimental::host_interface>& host_interfaces);
+
+        // modify a sender's or receiver's subscription to be inactive, or to match its IS-05 /active endpoint
+        void update_subscription(nmos::resources& node_resources, const nmos::resource& connection_resource, bool expired, const nmos::tai& at);
+
+        // modify senders' and receivers' subscriptions to be inactive, or to match their IS-05 /active endpoints
+        void update_data_plane_subscriptions(nmos::resources& node_resources, const nmos::resources& connection_resources, bool expired);
+
+        // DNS-SD advertiser implementation that does not advertise anything, used when the Node API advertisement is disabled
+        class null_service_advertiser_impl : public mdns::details::service_advertiser_impl
+        {
+        public:
+            pplx::task<void> open() { return pplx::task_from_result(); }
+            pplx::task<void> close() { return pplx::task_from_result(); }
+
+            pplx::task<bool> register_address(const std::string& host_name, const std::string& ip_address, const std::string& domain) { return pplx::task_from_result(true); }
+            pplx::task<bool> register_service(const std::string& name, const std::string& type, std::uint16_t port, const std::string& domain, const std::string& host_name, const mdns::txt_records& records) { return pplx::task_from_result(true); }
+            pplx::task<bool> update_record(const std::string& name, const std::string& type, const std::string& domain, const mdns::txt_records& records) { return pplx::task_from_result(true); }
+        };
     }
 
     // forward declarations
@@ -169,15 +188,27 @@ namespace nvnmos
         settings[nvnmos::fields::clocks] = value::object();
         settings[nvnmos::fields::senders] = value::object();
         settings[nvnmos::fields::receivers] = value::object();
+        settings[nvnmos::fields::link_states] = value::object();
     }
 
-    void node_implementation_add_sender_(nmos::resources& node_resources, nmos::resources& connection_resources, const std::string& sdp_, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, nmos::settings& settings, slog::base_gate& gate)
+    node_implementation_status node_implementation_add_sender_(nmos::resources& node_resources, nmos::resources& connection_resources, sdp_store& sdps, const format_registry& formats, const std::string& sdp_, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, nmos::settings& settings, slog::base_gate& gate)
     {
         using web::json::value;
         using web::json::value_of;
 
-        const auto sdp = sdp::parse_session_description(sdp_);
-        const auto sdp_params = nmos::get_session_description_sdp_parameters(sdp);
+        // share the parsed SDP data with any other sender or receiver configured with identical SDP data
+        std::shared_ptr<const sdp_entry> entry;
+        try
+        {
+            entry = sdps.find_or_parse(sdp_);
+        }
+        catch (const std::exception& e)
+        {
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Invalid SDP data for sender: " << e.what();
+            return node_implementation_status::invalid_sdp;
+        }
+        const auto& sdp = entry->session_description;
+        const auto& sdp_params = entry->sdp_params;
         const auto ts_refclks = impl::get_session_description_ts_refclks(sdp);
         const auto transport_params = impl::get_session_description_transport_params(nmos::types::sender, sdp);
         const auto internal_id = impl::get_session_description_internal_id(sdp);
@@ -194,9 +225,22 @@ namespace nvnmos
 
         // for now, only manage a single clock
         const auto clock = nmos::clock_names::clk0;
-        const auto format = impl::get_format(nmos::get_media_type(sdp_params));
-        const auto interface_names = boost::copy_range<std::vector<utility::string_t>>(
-            transport_params.as_array() | boost::adaptors::transformed([&](const value& transport_param)
+
+        if (node_resources.end() != nmos::find_resource(node_resources, { sender_id, nmos::types::sender }))
+        {
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Duplicate sender with internal id: " << internal_id;
+            return node_implementation_status::duplicate_id;
+        }
+
+        const auto format = formats.find(nmos::get_media_type(sdp_params));
+        if (!format)
+        {
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Unsupported media type: " << nmos::get_media_type(sdp_params).name << " for: " << internal_id;
+            return node_implementation_status::unsupported_format;
+        }
+
+        std::vector<utility::string_t> interface_names;
+        for (const auto& transport_param : transport_params.as_array())
         {
             const auto& address = nmos::fields::source_ip(transport_param).as_string();
             const auto interface = impl::find_interface(host_interfaces, address);
@@ -204,79 +248,26 @@ namespace nvnmos
             {
                 slog::log<slog::severities::severe>(gate, SLOG_FLF)
                     << "No network interface corresponding to the connection address: " << address << " for: " << internal_id;
-                throw node_implementation_exception();
+                return node_implementation_status::no_interface;
             }
-            return interface->name;
-        }));
+            interface_names.push_back(interface->name);
+        }
 
         nmos::resource source;
         nmos::resource flow;
-
-        if (impl::format::video == format)
-        {
-            const auto video = nmos::get_video_raw_parameters(sdp_params);
-
-            source = nmos::make_video_source(source_id, device_id, clock, video.exactframerate, settings);
-            flow = nmos::make_raw_video_flow(
-                flow_id, source_id, device_id,
-                video.exactframerate,
-                video.width, video.height, video.interlace ? nmos::interlace_modes::interlaced_tff : nmos::interlace_modes::progressive,
-                nmos::colorspace{ video.colorimetry.name }, nmos::transfer_characteristic{ video.tcs.name }, video.sampling, video.depth,
-                settings
-            );
-        }
-        else if (impl::format::audio == format)
-        {
-            const auto audio = nmos::get_audio_L_parameters(sdp_params);
-
-            // hm, if present, should parse audio.channel_order into the equivalent vector of nmos::channel
-            // but currently no nmos::parse_fmtp_channel_order
-            const auto channels = boost::copy_range<std::vector<nmos::channel>>(
-                boost::irange(0, (int)audio.channel_count) | boost::adaptors::transformed([&](const int& index)
-            {
-                return nmos::channel{ U(""), nmos::channel_symbols::Undefined(1 + index) };
-            }));
-
-            // hmm, should this take account of audio.packet_time?
-            const nmos::rational grain_rate = audio.sample_rate;
-
-            source = nmos::make_audio_source(source_id, device_id, clock, grain_rate, channels, settings);
-            flow = nmos::make_raw_audio_flow(flow_id, source_id, device_id, audio.sample_rate, audio.bit_depth, settings);
-            flow.data[nmos::fields::grain_rate] = nmos::make_rational(grain_rate);
-        }
-        else if (impl::format::data == format)
-        {
-            const auto data = nmos::get_video_smpte291_parameters(sdp_params);
-
-            const nmos::rational grain_rate = data.exactframerate;
-
-            source = nmos::make_data_source(source_id, device_id, clock, grain_rate, settings);
-            flow = nmos::make_sdianc_data_flow(flow_id, source_id, device_id, data.did_sdids, settings);
-            flow.data[nmos::fields::grain_rate] = nmos::make_rational(grain_rate);
-        }
-        else if (impl::format::mux == format)
+        if (!format->make_source_and_flow(source, flow, source_id, flow_id, device_id, clock, *entry, settings))
         {
-            const auto mux = nmos::get_video_SMPTE2022_6_parameters(sdp_params);
-
-            // hmm, this should take account of sdp_params.framerate
-            const nmos::rational grain_rate = nmos::rates::rate50;
-
-            source = nmos::make_mux_source(source_id, device_id, clock, grain_rate, settings);
-            flow = nmos::make_mux_flow(flow_id, source_id, device_id, settings);
-            flow.data[nmos::fields::grain_rate] = nmos::make_rational(grain_rate);
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "SDP data not accepted for media type: " << nmos::get_media_type(sdp_params).name << " for: " << internal_id;
+            return node_implementation_status::invalid_sdp;
         }
 
         const auto manifest_href = nmos::experimental::make_manifest_api_manifest(sender_id, settings);
         auto sender = nmos::make_sender(sender_id, flow_id, nmos::transports::rtp, device_id, manifest_href.to_string(), interface_names, settings);
 
         auto connection_sender = nmos::make_connection_rtp_sender(sender_id, transport_params.size() > 1);
-        // add some constraints; these should be completed fully!
-        auto& constraints = connection_sender.data[nmos::fields::endpoint_constraints];
-        for (int leg = 0; leg < (int)constraints.size(); ++leg)
+        if (!impl::set_endpoint_constraints(connection_sender.data[nmos::fields::endpoint_constraints], nmos::types::sender, transport_params, settings, gate))
         {
-            constraints[leg][nmos::fields::source_ip] = value_of({
-                { nmos::fields::constraint_enum, value_of({ nmos::fields::source_ip(transport_params.at(leg)) }) }
-            });
+            return node_implementation_status::invalid_argument;
         }
 
         const auto resolve_auto = make_node_implementation_auto_resolver();
@@ -289,6 +280,8 @@ namespace nvnmos
         impl::set_internal_id(sender, internal_id);
         // set the group hint as a resource tag
         if (!group_hint.empty()) impl::set_group_hint(sender, group_hint);
+        // set the link state of each leg as a resource tag
+        if (nvnmos::fields::link_monitor(settings)) impl::set_link_state(sender, nvnmos::fields::link_states(settings));
 
         if (!insert_resource(node_resources, std::move(source)).second) throw node_implementation_exception();
         if (!insert_resource(node_resources, std::move(flow)).second) throw node_implementation_exception();
@@ -307,28 +300,44 @@ namespace nvnmos
 
         impl::update_node_interfaces(node_resources, node_id, host_interfaces);
 
-        // update node's clocks
+        // update node's clocks, unless the PTP status is being monitored directly
 
-        auto& clock_settings = nvnmos::fields::clocks(settings)[clock.name];
-        auto ptp_domain = nmos::fields::ptp_domain_number(clock_settings);
-        impl::update_node_clock(node_resources, node_id, impl::make_node_clock(clock, ts_refclks, ptp_domain));
+        if (nvnmos::fields::ptp_status(settings).empty())
+        {
+            auto& clock_settings = nvnmos::fields::clocks(settings)[clock.name];
+            auto ptp_domain = nmos::fields::ptp_domain_number(clock_settings);
+            impl::update_node_clock(node_resources, node_id, impl::make_node_clock(clock, ts_refclks, ptp_domain));
 
-        clock_settings[nmos::fields::ptp_domain_number] = ptp_domain;
+            clock_settings[nmos::fields::ptp_domain_number] = ptp_domain;
+        }
 
         // insert into settings
 
         nvnmos::fields::senders(settings)[sender_id] = value_of({
-            { nvnmos::fields::sdp, utility::s2us(sdp_) }
+            { nvnmos::fields::sdp_key, sdps.acquire(std::move(entry)) }
         });
+
+        return node_implementation_status::ok;
     }
 
-    void node_implementation_add_receiver_(nmos::resources& node_resources, nmos::resources& connection_resources, const std::string& sdp_, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, nmos::settings& settings, slog::base_gate& gate)
+    node_implementation_status node_implementation_add_receiver_(nmos::resources& node_resources, nmos::resources& connection_resources, sdp_store& sdps, const format_registry& formats, const std::string& sdp_, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, nmos::settings& settings, slog::base_gate& gate)
     {
         using web::json::value;
         using web::json::value_of;
 
-        const auto sdp = sdp::parse_session_description(sdp_);
-        const auto sdp_params = nmos::get_session_description_sdp_parameters(sdp);
+        // share the parsed SDP data with any other sender or receiver configured with identical SDP data
+        std::shared_ptr<const sdp_entry> entry;
+        try
+        {
+            entry = sdps.find_or_parse(sdp_);
+        }
+        catch (const std::exception& e)
+        {
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Invalid SDP data for receiver: " << e.what();
+            return node_implementation_status::invalid_sdp;
+        }
+        const auto& sdp = entry->session_description;
+        const auto& sdp_params = entry->sdp_params;
         const auto transport_params = impl::get_session_description_transport_params(nmos::types::receiver, sdp);
         const auto internal_id = impl::get_session_description_internal_id(sdp);
         // hm, could check the internal id is unique across all senders and receivers
@@ -339,9 +348,22 @@ namespace nvnmos
         const auto node_id = impl::make_id(seed_id, nmos::types::node);
         const auto device_id = impl::make_id(seed_id, nmos::types::device);
         const auto receiver_id = impl::make_id(seed_id, nmos::types::receiver, internal_id);
-        const auto format = impl::get_format(nmos::get_media_type(sdp_params));
-        const auto interface_names = boost::copy_range<std::vector<utility::string_t>>(
-            transport_params.as_array() | boost::adaptors::transformed([&](const value& transport_param)
+
+        if (node_resources.end() != nmos::find_resource(node_resources, { receiver_id, nmos::types::receiver }))
+        {
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Duplicate receiver with internal id: " << internal_id;
+            return node_implementation_status::duplicate_id;
+        }
+
+        const auto format = formats.find(nmos::get_media_type(sdp_params));
+        if (!format)
+        {
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Unsupported media type: " << nmos::get_media_type(sdp_params).name << " for: " << internal_id;
+            return node_implementation_status::unsupported_format;
+        }
+
+        std::vector<utility::string_t> interface_names;
+        for (const auto& transport_param : transport_params.as_array())
         {
             const auto& address = nmos::fields::interface_ip(transport_param).as_string();
             const auto interface = impl::find_interface(host_interfaces, address);
@@ -349,82 +371,22 @@ namespace nvnmos
             {
                 slog::log<slog::severities::severe>(gate, SLOG_FLF)
                     << "No network interface corresponding to the connection address: " << address << " for: " << internal_id;
-                throw node_implementation_exception();
+                return node_implementation_status::no_interface;
             }
-            return interface->name;
-        }));
-
-        nmos::resource receiver;
-
-        if (impl::format::video == format)
-        {
-            const auto video = nmos::get_video_raw_parameters(sdp_params);
-
-            receiver = nmos::make_video_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, settings);
-            // add a constraint set; these should be completed fully!
-            const auto interlace_modes = video.interlace
-                ? std::vector<utility::string_t>{ nmos::interlace_modes::interlaced_bff.name, nmos::interlace_modes::interlaced_tff.name, nmos::interlace_modes::interlaced_psf.name }
-                : std::vector<utility::string_t>{ nmos::interlace_modes::progressive.name };
-            receiver.data[nmos::fields::caps][nmos::fields::constraint_sets] = value_of({
-                value_of({
-                    { nmos::caps::format::grain_rate, nmos::make_caps_rational_constraint({ video.exactframerate }) },
-                    { nmos::caps::format::frame_width, nmos::make_caps_integer_constraint({ video.width }) },
-                    { nmos::caps::format::frame_height, nmos::make_caps_integer_constraint({ video.height }) },
-                    { nmos::caps::format::interlace_mode, nmos::make_caps_string_constraint(interlace_modes) },
-                    { nmos::caps::format::color_sampling, nmos::make_caps_string_constraint({ video.sampling.name }) }
-                })
-            });
-            receiver.data[nmos::fields::version] = receiver.data[nmos::fields::caps][nmos::fields::version] = value(nmos::make_version());
-        }
-        else if (impl::format::audio == format)
-        {
-            const auto audio = nmos::get_audio_L_parameters(sdp_params);
-
-            receiver = nmos::make_audio_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, audio.bit_depth, settings);
-            // add a constraint set; these should be completed fully!
-            receiver.data[nmos::fields::caps][nmos::fields::constraint_sets] = value_of({
-                value_of({
-                    { nmos::caps::format::channel_count, nmos::make_caps_integer_constraint({ audio.channel_count }) },
-                    { nmos::caps::format::sample_rate, nmos::make_caps_rational_constraint({ audio.sample_rate }) },
-                    { nmos::caps::format::sample_depth, nmos::make_caps_integer_constraint({ audio.bit_depth }) },
-                    { 0 != sdp_params.packet_time ? nmos::caps::transport::packet_time.key : U(""), nmos::make_caps_number_constraint({ sdp_params.packet_time }) },
-                    { 0 != sdp_params.max_packet_time ? nmos::caps::transport::max_packet_time.key : U(""), nmos::make_caps_number_constraint({ sdp_params.max_packet_time }) }
-                })
-            });
-            receiver.data[nmos::fields::version] = receiver.data[nmos::fields::caps][nmos::fields::version] = value(nmos::make_version());
+            interface_names.push_back(interface->name);
         }
-        else if (impl::format::data == format)
-        {
-            const auto data = nmos::get_video_smpte291_parameters(sdp_params);
 
-            receiver = nmos::make_sdianc_data_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, settings);
-            // add a constraint set; these should be completed fully!
-            if (data.exactframerate)
-            {
-                receiver.data[nmos::fields::caps][nmos::fields::constraint_sets] = value_of({
-                    value_of({
-                        { nmos::caps::format::grain_rate, nmos::make_caps_rational_constraint({ data.exactframerate }) }
-                    })
-                });
-                receiver.data[nmos::fields::version] = receiver.data[nmos::fields::caps][nmos::fields::version] = value(nmos::make_version());
-            }
-        }
-        else if (impl::format::mux == format)
+        nmos::resource receiver;
+        if (!format->make_receiver(receiver, receiver_id, device_id, interface_names, *entry, settings))
         {
-            const auto mux = nmos::get_video_SMPTE2022_6_parameters(sdp_params);
-
-            receiver = nmos::make_mux_receiver(receiver_id, device_id, nmos::transports::rtp, interface_names, settings);
-            // hmm, add a constraint set, e.g. taking account of sdp_params.framerate
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "SDP data not accepted for media type: " << nmos::get_media_type(sdp_params).name << " for: " << internal_id;
+            return node_implementation_status::invalid_sdp;
         }
 
         auto connection_receiver = nmos::make_connection_rtp_receiver(receiver_id, transport_params.size() > 1);
-        // add some constraints; these should be completed fully!
-        auto& constraints = connection_receiver.data[nmos::fields::endpoint_constraints];
-        for (int leg = 0; leg < (int)constraints.size(); ++leg)
+        if (!impl::set_endpoint_constraints(connection_receiver.data[nmos::fields::endpoint_constraints], nmos::types::receiver, transport_params, settings, gate))
         {
-            constraints[leg][nmos::fields::interface_ip] = value_of({
-                { nmos::fields::constraint_enum, value_of({ nmos::fields::interface_ip(transport_params.at(leg)) }) }
-            });
+            return node_implementation_status::invalid_argument;
         }
 
         const auto resolve_auto = make_node_implementation_auto_resolver();
@@ -437,6 +399,8 @@ namespace nvnmos
         impl::set_internal_id(receiver, internal_id);
         // set the group hint as a resource tag
         if (!group_hint.empty()) impl::set_group_hint(receiver, group_hint);
+        // set the link state of each leg as a resource tag
+        if (nvnmos::fields::link_monitor(settings)) impl::set_link_state(receiver, nvnmos::fields::link_states(settings));
 
         if (!insert_resource(node_resources, std::move(receiver)).second) throw node_implementation_exception();
         if (!insert_resource(connection_resources, std::move(connection_receiver)).second) throw node_implementation_exception();
@@ -456,11 +420,13 @@ namespace nvnmos
         // insert into settings
 
         nvnmos::fields::receivers(settings)[receiver_id] = value_of({
-            { nvnmos::fields::sdp, utility::s2us(sdp_) }
+            { nvnmos::fields::sdp_key, sdps.acquire(std::move(entry)) }
         });
+
+        return node_implementation_status::ok;
     }
 
-    void node_implementation_remove_connection_(nmos::resources& node_resources, nmos::resources& connection_resources, const nmos::type& type, const utility::string_t& internal_id, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, nmos::settings& settings, slog::base_gate& gate)
+    node_implementation_status node_implementation_remove_connection_(nmos::resources& node_resources, nmos::resources& connection_resources, sdp_store& sdps, const nmos::type& type, const utility::string_t& internal_id, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, nmos::settings& settings, slog::base_gate& gate)
     {
         using web::json::value;
         using web::json::value_of;
@@ -528,14 +494,79 @@ namespace nvnmos
             auto& configs = nmos::types::sender == type ? nvnmos::fields::senders(settings) : nvnmos::fields::receivers(settings);
             if (configs.has_field(id))
             {
+                sdps.release(nvnmos::fields::sdp_key(configs.at(id)));
                 configs.erase(id);
             }
+
+            return node_implementation_status::ok;
         }
         else
         {
-            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Could not find " << type.name << " with internal id: " << internal_id;
-            throw node_implementation_exception();
+            // the status is returned to the caller, which may expect this, e.g. when removing a sender or receiver that may already have gone
+            slog::log<slog::severities::info>(gate, SLOG_FLF) << "Could not find " << type.name << " with internal id: " << internal_id;
+            return node_implementation_status::not_found;
+        }
+    }
+
+    void node_implementation_reset_(nmos::resources& node_resources, nmos::resources& connection_resources, sdp_store& sdps, transportfile_store& transportfiles, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, nmos::settings& settings, slog::base_gate& gate)
+    {
+        using web::json::value;
+
+        const auto seed_id = nmos::experimental::fields::seed_id(settings);
+        const auto node_id = impl::make_id(seed_id, nmos::types::node);
+        const auto device_id = impl::make_id(seed_id, nmos::types::device);
+
+        // erase connection resources
+
+        std::vector<nmos::id> ids;
+        for (const auto& connection_resource : connection_resources)
+        {
+            if (connection_resource.has_data()) ids.push_back(connection_resource.id);
+        }
+        for (const auto& id : ids)
+        {
+            nmos::erase_resource(connection_resources, id);
+        }
+
+        // erase node resources (senders and receivers before flows before sources)
+
+        ids.clear();
+        auto& by_type = node_resources.get<nmos::tags::type>();
+        for (const auto& type : { nmos::types::sender, nmos::types::receiver, nmos::types::flow, nmos::types::source })
+        {
+            const auto resources = by_type.equal_range(nmos::details::has_data(type));
+            for (auto resource = resources.first; resources.second != resource; ++resource)
+            {
+                ids.push_back(resource->id);
+            }
+        }
+        for (const auto& id : ids)
+        {
+            nmos::erase_resource(node_resources, id);
         }
+
+        slog::log<slog::severities::info>(gate, SLOG_FLF) << "Erased " << ids.size() << " sources, flows, senders and receivers";
+
+        // update device's deprecated senders and receivers arrays
+
+        nmos::modify_resource(node_resources, device_id, [&](nmos::resource& device)
+        {
+            device.data[nmos::fields::version] = value::string(nmos::make_version());
+            device.data[nmos::fields::senders] = value::array();
+            device.data[nmos::fields::receivers] = value::array();
+        });
+
+        // update node's interfaces
+
+        impl::update_node_interfaces(node_resources, node_id, host_interfaces);
+
+        // erase from settings, keeping the clock configs
+
+        settings[nvnmos::fields::senders] = value::object();
+        settings[nvnmos::fields::receivers] = value::object();
+
+        sdps.clear();
+        transportfiles.clear();
     }
 
     // This constructs and inserts a node resource and a device resource into the model, based on the model settings.
@@ -551,49 +582,112 @@ namespace nvnmos
     }
 
     // This constructs and inserts sources/flows/senders into the model, based on the specified SDP file.
-    void node_implementation_add_sender(nmos::node_model& model, const std::string& sdp, slog::base_gate& gate)
+    node_implementation_status node_implementation_add_sender(nmos::node_model& model, sdp_store& sdps, const format_registry& formats, const std::string& sdp, slog::base_gate& gate)
     {
         auto lock = model.write_lock(); // in order to update the resources
 
         const auto host_interfaces = web::hosts::experimental::host_interfaces();
 
-        node_implementation_add_sender_(model.node_resources, model.connection_resources, sdp, host_interfaces, model.settings, gate);
+        const auto status = node_implementation_add_sender_(model.node_resources, model.connection_resources, sdps, formats, sdp, host_interfaces, model.settings, gate);
+        if (node_implementation_status::ok != status) return status;
 
         model.notify();
+        return status;
     }
 
     // This constructs and inserts a receiver into the model, based on the specified SDP file.
-    void node_implementation_add_receiver(nmos::node_model& model, const std::string& sdp, slog::base_gate& gate)
+    node_implementation_status node_implementation_add_receiver(nmos::node_model& model, sdp_store& sdps, const format_registry& formats, const std::string& sdp, slog::base_gate& gate)
+    {
+        auto lock = model.write_lock(); // in order to update the resources
+
+        const auto host_interfaces = web::hosts::experimental::host_interfaces();
+
+        const auto status = node_implementation_add_receiver_(model.node_resources, model.connection_resources, sdps, formats, sdp, host_interfaces, model.settings, gate);
+        if (node_implementation_status::ok != status) return status;
+
+        model.notify();
+        return status;
+    }
+
+    // This constructs and inserts the receivers and senders into the model, based on the specified SDP files, in a single update.
+    node_implementation_status node_implementation_add_receivers_and_senders(nmos::node_model& model, sdp_store& sdps, const format_registry& formats, const std::vector<std::string>& receiver_sdps, const std::vector<std::string>& sender_sdps, slog::base_gate& gate)
     {
         auto lock = model.write_lock(); // in order to update the resources
 
         const auto host_interfaces = web::hosts::experimental::host_interfaces();
 
-        node_implementation_add_receiver_(model.node_resources, model.connection_resources, sdp, host_interfaces, model.settings, gate);
+        // if an error occurs, the receivers and senders already added are not removed, and the model is notified regardless
+        auto status = node_implementation_status::ok;
+        try
+        {
+            for (auto sdp = receiver_sdps.begin(); node_implementation_status::ok == status && receiver_sdps.end() != sdp; ++sdp)
+            {
+                status = node_implementation_add_receiver_(model.node_resources, model.connection_resources, sdps, formats, *sdp, host_interfaces, model.settings, gate);
+            }
+            for (auto sdp = sender_sdps.begin(); node_implementation_status::ok == status && sender_sdps.end() != sdp; ++sdp)
+            {
+                status = node_implementation_add_sender_(model.node_resources, model.connection_resources, sdps, formats, *sdp, host_interfaces, model.settings, gate);
+            }
+        }
+        catch (...)
+        {
+            model.notify();
+            throw;
+        }
 
         model.notify();
+        return status;
     }
 
     // This removes sources/flows/senders from the model corresponding to the specified id.
-    void node_implementation_remove_sender(nmos::node_model& model, const utility::string_t& internal_id, slog::base_gate& gate)
+    node_implementation_status node_implementation_remove_sender(nmos::node_model& model, sdp_store& sdps, transportfile_store& transportfiles, activation_rollback& rollback, const utility::string_t& internal_id, slog::base_gate& gate)
     {
         auto lock = model.write_lock(); // in order to update the resources
 
         const auto host_interfaces = web::hosts::experimental::host_interfaces();
 
-        node_implementation_remove_connection_(model.node_resources, model.connection_resources, nmos::types::sender, internal_id, host_interfaces, model.settings, gate);
+        const auto status = node_implementation_remove_connection_(model.node_resources, model.connection_resources, sdps, nmos::types::sender, internal_id, host_interfaces, model.settings, gate);
+        if (node_implementation_status::ok != status) return status;
+
+        // the transport file inputs also hold a reference to the SDP data, so forget them too
+        const auto seed_id = nmos::experimental::fields::seed_id(model.settings);
+        const auto id = impl::make_id(seed_id, nmos::types::sender, internal_id);
+        transportfiles.erase(id);
+        rollback.forget(id);
 
         model.notify();
+        return status;
     }
 
     // This removes the receiver from the model corresponding to the specified id.
-    void node_implementation_remove_receiver(nmos::node_model& model, const utility::string_t& internal_id, slog::base_gate& gate)
+    node_implementation_status node_implementation_remove_receiver(nmos::node_model& model, sdp_store& sdps, activation_rollback& rollback, connection_index& connections, const utility::string_t& internal_id, slog::base_gate& gate)
     {
         auto lock = model.write_lock(); // in order to update the resources
 
         const auto host_interfaces = web::hosts::experimental::host_interfaces();
 
-        node_implementation_remove_connection_(model.node_resources, model.connection_resources, nmos::types::receiver, internal_id, host_interfaces, model.settings, gate);
+        const auto status = node_implementation_remove_connection_(model.node_resources, model.connection_resources, sdps, nmos::types::receiver, internal_id, host_interfaces, model.settings, gate);
+        if (node_implementation_status::ok != status) return status;
+
+        const auto seed_id = nmos::experimental::fields::seed_id(model.settings);
+        const auto id = impl::make_id(seed_id, nmos::types::receiver, internal_id);
+        rollback.forget(id);
+        connections.erase(id);
+
+        model.notify();
+        return status;
+    }
+
+    // This removes all sources/flows/senders and receivers from the model in a single update, leaving the node and device.
+    void node_implementation_reset(nmos::node_model& model, sdp_store& sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, slog::base_gate& gate)
+    {
+        auto lock = model.write_lock(); // in order to update the resources
+
+        const auto host_interfaces = web::hosts::experimental::host_interfaces();
+
+        node_implementation_reset_(model.node_resources, model.connection_resources, sdps, transportfiles, host_interfaces, model.settings, gate);
+        rollback.clear();
+        connections.clear();
 
         model.notify();
     }
@@ -623,11 +717,113 @@ namespace nvnmos
         };
     }
 
+    const char* startup_times::phase_name(phase which)
+    {
+        static const char* names[num_phases] = { "settings", "server", "init", "resources", "open", "registered" };
+        return names[which];
+    }
+
+    // summarize the phases which have completed, e.g. "settings 1.2 ms, server 3.4 ms"
+    std::string startup_times::summary() const
+    {
+        std::ostringstream result;
+        result.setf(std::ios::fixed);
+        result.precision(1);
+        for (int phase = 0; phase < num_phases; ++phase)
+        {
+            const auto time = elapsed[phase].load();
+            if (0 > time) continue;
+            if (0 != result.tellp()) result << ", ";
+            result << phase_name((startup_times::phase)phase) << " " << std::chrono::duration<double, std::milli>(clock::duration(time)).count() << " ms";
+        }
+        return result.str();
+    }
+
+    // record the /active endpoint accepted by the application for the specified connection resource
+    void activation_rollback::accept(const utility::string_t& id, const utility::string_t& created, const web::json::value& endpoint_active)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        accepted[id] = { created, endpoint_active };
+    }
+
+    // get the /active endpoint last accepted by the application, or null if there isn't one
+    web::json::value activation_rollback::last_accepted(const utility::string_t& id, const utility::string_t& created) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = accepted.find(id);
+        return accepted.end() != found && created == found->second.first ? found->second.second : web::json::value::null();
+    }
+
+    // forget the /active endpoint and any pending retry for a connection resource which has been removed
+    void activation_rollback::forget(const utility::string_t& id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        accepted.erase(id);
+        auto pending = boost::range::find_if(retries, [&](const retry& other) { return id == other.id; });
+        if (retries.end() != pending) retries.erase(pending);
+    }
+
+    // forget everything, when all the connection resources have been removed
+    void activation_rollback::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        accepted.clear();
+        retries.clear();
+    }
+
+    // schedule a retry, replacing any pending retry for the same connection resource
+    void activation_rollback::schedule(retry next)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto pending = boost::range::find_if(retries, [&](const retry& other) { return next.id == other.id; });
+        if (retries.end() != pending) retries.erase(pending);
+        retries.push_back(std::move(next));
+    }
+
+    // remove and return the retries which are due
+    std::vector<activation_rollback::retry> activation_rollback::take_due(clock::time_point now)
+    {
+        std::vector<retry> due;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto pending = retries.begin(); retries.end() != pending;)
+        {
+            if (pending->due <= now)
+            {
+                due.push_back(std::move(*pending));
+                pending = retries.erase(pending);
+            }
+            else
+            {
+                ++pending;
+            }
+        }
+        return due;
+    }
+
+    // get the time the next retry is due, or clock::time_point::max() if there are none
+    activation_rollback::clock::time_point activation_rollback::next_due() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto next = (clock::time_point::max)();
+        for (const auto& pending : retries)
+        {
+            if (pending.due < next) next = pending.due;
+        }
+        return next;
+    }
+
     // Registration API node behaviour callback to perform application-specific operations when the current Registration API changes
-    nmos::registration_handler make_node_implementation_registration_handler(slog::base_gate& gate)
+    nmos::registration_handler make_node_implementation_registration_handler(node_health& health, startup_times& startup, slog::base_gate& gate)
     {
         return [&](const web::uri& registration_uri)
         {
+            health.set_registered(!registration_uri.is_empty());
+
+            if (!registration_uri.is_empty() && startup.complete(startup_times::registered))
+            {
+                slog::log<slog::severities::info>(gate, SLOG_FLF) << "Startup times: " << startup.summary();
+            }
+
             if (!registration_uri.is_empty())
             {
                 slog::log<slog::severities::info>(gate, SLOG_FLF) << "Started registered operation with Registration API at: " << registration_uri.to_string();
@@ -693,12 +889,13 @@ namespace nvnmos
     }
 
     // Connection API activation callback to update senders' /transportfile endpoint - captures node_resources and settings by reference!
-    nmos::connection_sender_transportfile_setter make_node_implementation_transportfile_setter(const nmos::resources& node_resources, const nmos::settings& settings)
+    nmos::connection_sender_transportfile_setter make_node_implementation_transportfile_setter(const nmos::resources& node_resources, const sdp_store& sdps, transportfile_store& transportfiles, const nmos::settings& settings)
     {
         using web::json::value;
+        using web::json::value_of;
 
         // as part of activation, the sender /transportfile should be updated based on the active transport parameters
-        return [&node_resources, &settings](const nmos::resource& sender, const nmos::resource& connection_sender, value& endpoint_transportfile)
+        return [&node_resources, &sdps, &transportfiles, &settings](const nmos::resource& sender, const nmos::resource& connection_sender, value& endpoint_transportfile)
         {
             auto& configs = nvnmos::fields::senders(settings);
             auto config = configs.as_object().find(sender.id);
@@ -707,11 +904,9 @@ namespace nvnmos
 
             if (configs.as_object().end() != config && is_rtp)
             {
-                const auto& sdp_data = nvnmos::fields::sdp(config->second);
-
-                const auto parsed_sdp = sdp::parse_session_description(utility::us2s(sdp_data));
-
-                auto sdp_params = nmos::get_session_description_sdp_parameters(parsed_sdp);
+                transportfile_inputs inputs;
+                inputs.sdp = sdps.find(nvnmos::fields::sdp_key(config->second));
+                if (!inputs.sdp) throw node_implementation_exception();
 
                 // update ts-refclk based on current clock
                 {
@@ -729,31 +924,101 @@ namespace nvnmos
                     const auto clock = nmos::clock_name(clock_or_null.as_string());
                     const auto ptp_domain = nmos::fields::ptp_domain_number(web::json::field_as_value_or{ clock.name, {} }(nvnmos::fields::clocks(settings)));
 
-                    sdp_params.ts_refclk = nmos::details::make_ts_refclk(node->data, source->data, sender.data, ptp_domain);
+                    inputs.ts_refclk = nmos::details::make_ts_refclk(node->data, source->data, sender.data, ptp_domain);
                 }
 
                 // update session version since the resulting /transportfile isn't necessarily identical to the original SDP data
-                sdp_params.origin.session_version = sdp::ntp_now() >> 32;
+                inputs.session_version = sdp::ntp_now() >> 32;
 
-                auto& transport_params = nmos::fields::transport_params(nmos::fields::endpoint_active(connection_sender.data));
+                inputs.transport_params = nmos::fields::transport_params(nmos::fields::endpoint_active(connection_sender.data));
 
-                // use nmos::make_session_description rather than impl::make_session_description for /transportfile
-                // because e.g. the custom SDP attributes in nvnmos::attributes are only for 'internal' use
-                auto session_description = nmos::make_session_description(sdp_params, transport_params);
-                auto sdp = utility::s2us(sdp::make_session_description(session_description));
-                endpoint_transportfile = nmos::make_connection_rtp_sender_transportfile(sdp);
+                if (nvnmos::fields::lazy_transport_files(settings))
+                {
+                    // defer rendering the SDP data until the /transportfile is first requested, via a redirect to the nvnmos API
+                    // cf. nmos::make_connection_rtp_sender_transportfile
+                    transportfiles.set(sender.id, std::move(inputs));
+                    endpoint_transportfile = value_of({
+                        { nmos::fields::transportfile_data, value::null() },
+                        { nmos::fields::transportfile_type, nmos::media_types::application_sdp.name },
+                        { U("href"), U("/x-nvnmos/transportfile/") + sender.id }
+                    });
+                }
+                else
+                {
+                    endpoint_transportfile = nmos::make_connection_rtp_sender_transportfile(make_transportfile(inputs));
+                }
             }
         };
     }
 
+    // restore the /active endpoint of the specified sender or receiver, with a new version, and update its subscription and, for a sender,
+    // its /transportfile endpoint to match, returning the update time of the connection resource
+    // while the data plane deadline is missed, the subscription remains inactive
+    utility::string_t node_implementation_restore_active_(nmos::resources& node_resources, nmos::resources& connection_resources, const sdp_store& sdps, transportfile_store& transportfiles, connection_index& connections, const data_plane_liveness& liveness, const std::pair<nmos::id, nmos::type>& id_type, const web::json::value& endpoint_active, const nmos::settings& settings)
+    {
+        using web::json::value;
+
+        const auto set_transportfile = make_node_implementation_transportfile_setter(node_resources, sdps, transportfiles, settings);
+
+        auto resource = nmos::find_resource(node_resources, id_type);
+        auto connection_resource = nmos::find_resource(connection_resources, id_type);
+        if (node_resources.end() == resource || connection_resources.end() == connection_resource) throw node_implementation_exception();
+
+        const auto at = nmos::tai_now();
+
+        nmos::modify_resource(connection_resources, id_type.first, [&](nmos::resource& connection_resource)
+        {
+            connection_resource.data[nmos::fields::version] = value::string(nmos::make_version(at));
+            connection_resource.data[nmos::fields::endpoint_active] = endpoint_active;
+
+            if (nmos::types::sender == id_type.second)
+            {
+                set_transportfile(*resource, connection_resource, connection_resource.data[nmos::fields::endpoint_transportfile]);
+            }
+        });
+
+        impl::update_subscription(node_resources, *connection_resource, liveness.expired, at);
+
+        connections.update(node_resources, connection_resources, id_type.first);
+
+        return nmos::make_version(connection_resource->updated);
+    }
+
+    // make an /active endpoint for the specified connection resource which is inactive, for when the application has never accepted one
+    web::json::value make_inactive_endpoint_active(const nmos::resource& connection_resource)
+    {
+        using web::json::value;
+        using web::json::value_of;
+
+        auto endpoint_active = nmos::fields::endpoint_active(connection_resource.data);
+
+        endpoint_active[nmos::types::sender == connection_resource.type ? nmos::fields::receiver_id : nmos::fields::sender_id] = value::null();
+        endpoint_active[nmos::fields::master_enable] = value::boolean(false);
+        endpoint_active[nmos::fields::activation] = nmos::make_activation();
+
+        if (nmos::types::receiver == connection_resource.type)
+        {
+            endpoint_active[nmos::fields::transport_file] = value_of({
+                { nmos::fields::data, value::null() },
+                { nmos::fields::type, value::null() }
+            });
+        }
+
+        return endpoint_active;
+    }
+
     // Connection API activation callback to perform application-specific operations to complete activation
-    nmos::connection_activation_handler make_node_implementation_connection_activation_handler(rtp_connection_activation_handler rtp_connection_activated, nmos::settings& settings, slog::base_gate& gate)
+    // If the application fails to apply the activation, the /active endpoint is rolled back to the state it last accepted; since the
+    // callback is made with the model locked for writing, the failed activation is never visible to clients
+    nmos::connection_activation_handler make_node_implementation_connection_activation_handler(nmos::node_model& model, rtp_connection_activation_handler rtp_connection_activated, sender_transportfile_resolver resolve_sender_transportfile, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, slog::base_gate& gate)
     {
         using web::json::value;
         using web::json::value_from_elements;
 
-        return [&settings, rtp_connection_activated, &gate](const nmos::resource& resource, const nmos::resource& connection_resource)
+        return [&model, rtp_connection_activated, resolve_sender_transportfile, &sdps, &parsed_sdps, &transportfiles, &rollback, &connections, &liveness, &gate](const nmos::resource& resource, const nmos::resource& connection_resource)
         {
+            auto& settings = model.settings;
+
             const std::pair<nmos::id, nmos::type> id_type{ resource.id, resource.type };
             slog::log<slog::severities::info>(gate, SLOG_FLF) << "Activating " << id_type;
 
@@ -771,6 +1036,8 @@ namespace nvnmos
                 // determine the new state of the sender or receiver
                 const bool active = nmos::fields::master_enable(endpoint_active);
 
+                std::string sdp_data; // empty to deactivate the sender or receiver
+                auto status = node_implementation_status::ok;
                 if (active)
                 {
                     // get the active transport file from the sender's /transportfile endpoint or receiver's /active transport_file object
@@ -778,73 +1045,176 @@ namespace nvnmos
                         ? nmos::fields::endpoint_transportfile(connection_resource.data)
                         : nmos::fields::transport_file(endpoint_active);
                     auto& transportfile_data_or_null = nmos::fields::transportfile_data(transportfile);
+                    const bool staged_transportfile = !transportfile_data_or_null.is_null() && !transportfile_data_or_null.as_string().empty();
 
-                    // if a transport file hasn't been staged to a receiver, or a sender hasn't been activated, assume default values
-                    // based on the original SDP data used to configure the receiver or sender
-                    const auto& transportfile_data = !transportfile_data_or_null.is_null() && !transportfile_data_or_null.as_string().empty()
-                        ? transportfile_data_or_null.as_string()
-                        : nvnmos::fields::sdp(config->second);
-
-                    // activate the sender or receiver with the effective SDP file for the /active transport_params
+                    // if lazy_transport_files is enabled, a sender's /transportfile may not have been rendered yet
+                    const auto lazy_transportfile_data = !staged_transportfile && nmos::types::sender == id_type.second
+                        ? transportfiles.get(resource.id)
+                        : utility::string_t{};
 
-                    auto& transport_params = nmos::fields::transport_params(endpoint_active);
+                    // if a receiver has been connected to a sender by id without a transport file, look up the sender's transport file
+                    // from the Query API cache, if enabled, rather than waiting for a client to fetch and stage it
+                    utility::string_t resolved_transportfile_data;
+                    if (!staged_transportfile && nmos::types::receiver == id_type.second && resolve_sender_transportfile)
+                    {
+                        auto& sender_id_or_null = nmos::fields::sender_id(endpoint_active);
+                        if (!sender_id_or_null.is_null())
+                        {
+                            resolved_transportfile_data = resolve_sender_transportfile(sender_id_or_null.as_string());
+                            if (!resolved_transportfile_data.empty())
+                            {
+                                slog::log<slog::severities::info>(gate, SLOG_FLF) << "Resolved transport file from cache for remote sender: " << sender_id_or_null.as_string();
+                            }
+                        }
+                    }
 
-                    const auto parsed_sdp = sdp::parse_session_description(utility::us2s(transportfile_data));
-                    auto sdp_params = nmos::get_session_description_sdp_parameters(parsed_sdp);
+                    const auto& transportfile_data = staged_transportfile
+                        ? transportfile_data_or_null.as_string()
+                        : !lazy_transportfile_data.empty()
+                        ? lazy_transportfile_data
+                        : resolved_transportfile_data;
 
-                    if (transport_params.size() > 1)
+                    // if a transport file hasn't been staged to a receiver, or a sender hasn't been activated, assume default values
+                    // based on the original SDP data used to configure the receiver or sender, which has already been parsed
+                    const auto config_sdp = transportfile_data.empty() ? sdps.find(nvnmos::fields::sdp_key(config->second)) : std::shared_ptr<const sdp_entry>{};
+                    if (transportfile_data.empty() && !config_sdp)
+                    {
+                        slog::log<slog::severities::error>(gate, SLOG_FLF) << "Could not find a transport file for activation of " << id_type;
+                        status = node_implementation_status::not_found;
+                    }
+                    else
                     {
-                        // A single-legged SDP file applied to a two-legged Receiver, configures it to receive on the primary interface by default.
-                        // By setting rtp_enabled to false for the first leg and rtp_enabled to true, and setting all the other transport params
-                        // for the second leg, a client can configure the Receiver on the secondary interface (for example because that interface
-                        // is the one on the same network as the single-legged Sender).
-                        // It is therefore also possible for a client to apply a single-legged SDP file but set rtp_enabled to true on both legs.
-                        // This seems pretty pointless but can be accommodated by manipulating the sdp_params...
-                        sdp_params.group.semantics = sdp::group_semantics::duplication;
-                        if (sdp_params.group.media_stream_ids.size() < transport_params.size())
+                        try
                         {
-                            sdp_params.group.media_stream_ids = boost::copy_range<std::vector<utility::string_t>>(
-                                boost::irange(0, (int)transport_params.size()) | boost::adaptors::transformed([&](const int& index)
+                            // activate the sender or receiver with the effective SDP file for the /active transport_params
+
+                            // in a salvo, the same transport file is often staged to many receivers, so the results of parsing it are cached
+                            const auto effective_sdp = config_sdp ? config_sdp : parsed_sdps.find_or_parse(utility::us2s(transportfile_data));
+                            const auto& parsed_sdp = effective_sdp->session_description;
+                            auto sdp_params = effective_sdp->sdp_params;
+
+                            // when the transport file was resolved rather than staged, the /active transport_params weren't derived from it,
+                            // so take the addresses and ports from the resolved transport file, except for the locally resolved interface_ip
+                            // and rtp_enabled
+                            auto transport_params = nmos::fields::transport_params(endpoint_active);
+                            if (!resolved_transportfile_data.empty())
+                            {
+                                const auto resolved_transport_params = nmos::get_session_description_transport_params(parsed_sdp);
+                                for (size_t leg = 0; leg < transport_params.size() && leg < resolved_transport_params.size(); ++leg)
+                                {
+                                    auto params = resolved_transport_params.at(leg);
+                                    params[nmos::fields::interface_ip] = transport_params.at(leg).at(nmos::fields::interface_ip);
+                                    params[nmos::fields::rtp_enabled] = transport_params.at(leg).at(nmos::fields::rtp_enabled);
+                                    transport_params[leg] = params;
+                                }
+                            }
+
+                            if (transport_params.size() > 1)
+                            {
+                                // A single-legged SDP file applied to a two-legged Receiver, configures it to receive on the primary interface by default.
+                                // By setting rtp_enabled to false for the first leg and rtp_enabled to true, and setting all the other transport params
+                                // for the second leg, a client can configure the Receiver on the secondary interface (for example because that interface
+                                // is the one on the same network as the single-legged Sender).
+                                // It is therefore also possible for a client to apply a single-legged SDP file but set rtp_enabled to true on both legs.
+                                // This seems pretty pointless but can be accommodated by manipulating the sdp_params...
+                                sdp_params.group.semantics = sdp::group_semantics::duplication;
+                                if (sdp_params.group.media_stream_ids.size() < transport_params.size())
                                 {
-                                    return utility::ostringstreamed(index);
-                                })
-                            );
+                                    sdp_params.group.media_stream_ids = boost::copy_range<std::vector<utility::string_t>>(
+                                        boost::irange(0, (int)transport_params.size()) | boost::adaptors::transformed([&](const int& index)
+                                        {
+                                            return utility::ostringstreamed(index);
+                                        })
+                                    );
+                                }
+                                if (!sdp_params.ts_refclk.empty())
+                                {
+                                    // passing a "self referencing" value is OK
+                                    // see https://cplusplus.github.io/LWG/issue679
+                                    sdp_params.ts_refclk.resize(transport_params.size(), sdp_params.ts_refclk.front());
+                                }
+                            }
+
+                            // update session version since the resulting SDP data isn't necessarily identical to the original
+                            // sender's /transportfile (e.g. due to rtp_enabled) or receiver's /active transport_file object
+                            sdp_params.origin.session_version = sdp::ntp_now() >> 32;
+
+                            const auto group_hint = impl::get_group_hint(resource);
+                            const auto& session_info = nmos::fields::description(resource.data);
+                            const auto merged_sdp = impl::make_session_description(id_type.second, internal_id, group_hint, session_info, sdp_params, transport_params);
+                            sdp_data = sdp::make_session_description(merged_sdp);
                         }
-                        if (!sdp_params.ts_refclk.empty())
+                        catch (const std::exception& e)
                         {
-                            // passing a "self referencing" value is OK
-                            // see https://cplusplus.github.io/LWG/issue679
-                            sdp_params.ts_refclk.resize(transport_params.size(), sdp_params.ts_refclk.front());
+                            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Invalid transport file for activation of " << id_type << ": " << e.what();
+                            status = node_implementation_status::invalid_sdp;
                         }
                     }
+                }
 
-                    // update session version since the resulting SDP data isn't necessarily identical to the original
-                    // sender's /transportfile (e.g. due to rtp_enabled) or receiver's /active transport_file object
-                    sdp_params.origin.session_version = sdp::ntp_now() >> 32;
+                const auto created = nmos::make_version(connection_resource.created);
 
-                    const auto group_hint = impl::get_group_hint(resource);
-                    const auto& session_info = nmos::fields::description(resource.data);
-                    const auto merged_sdp = impl::make_session_description(id_type.second, internal_id, group_hint, session_info, sdp_params, transport_params);
-                    const auto sdp_data = sdp::make_session_description(merged_sdp);
+                // if the effective SDP data couldn't be made, the application isn't asked to activate the sender or receiver
+                if (node_implementation_status::ok == status && rtp_connection_activated(utility::us2s(internal_id), sdp_data))
+                {
+                    rollback.accept(connection_resource.id, created, endpoint_active);
 
-                    rtp_connection_activated(utility::us2s(internal_id), sdp_data);
+                    // the activation has already updated the subscription, but while the data plane deadline is missed, it remains inactive
+                    if (liveness.expired) impl::update_subscription(model.node_resources, connection_resource, true, nmos::tai_now());
                 }
                 else
                 {
-                    // deactivate sender or receiver
+                    // the data plane is still in the state last accepted by the application, so the /active endpoint is rolled back to match
+                    const auto failed_endpoint_active = endpoint_active;
+                    auto accepted_endpoint_active = rollback.last_accepted(connection_resource.id, created);
+                    if (accepted_endpoint_active.is_null()) accepted_endpoint_active = make_inactive_endpoint_active(connection_resource);
+
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Rolling back failed activation of " << id_type;
+                    const auto updated = node_implementation_restore_active_(model.node_resources, model.connection_resources, sdps, transportfiles, connections, liveness, id_type, accepted_endpoint_active, settings);
 
-                    rtp_connection_activated(utility::us2s(internal_id), {});
+                    // retrying is only worthwhile if the application failed to apply the activation
+                    if (node_implementation_status::ok == status && 0 != nvnmos::fields::activation_retries(settings))
+                    {
+                        activation_rollback::retry next;
+                        next.id = id_type.first;
+                        next.type = id_type.second.name;
+                        next.internal_id = utility::us2s(internal_id);
+                        next.sdp = sdp_data;
+                        next.endpoint_active = failed_endpoint_active;
+                        next.updated = updated;
+                        next.attempts = 0;
+                        next.due = activation_rollback::clock::now() + std::chrono::milliseconds(nvnmos::fields::activation_retry_interval(settings));
+                        rollback.schedule(std::move(next));
+                    }
                 }
             }
+
+            // the /active endpoint has been changed by the activation, or by the rollback
+            connections.update(model.node_resources, model.connection_resources, connection_resource.id);
         };
     }
 
-    void node_implementation_activate_rtp_connection_(nmos::resources& node_resources, nmos::resources& connection_resources, const utility::string_t& internal_id, const std::string& sdp, nmos::settings& settings, slog::base_gate& gate)
+    node_implementation_status node_implementation_activate_rtp_connection_(nmos::resources& node_resources, nmos::resources& connection_resources, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, const utility::string_t& internal_id, const std::string& sdp, nmos::settings& settings, slog::base_gate& gate)
     {
         using web::json::value;
         using web::json::value_of;
 
-        const auto set_transportfile = make_node_implementation_transportfile_setter(node_resources, settings);
+        // parse the SDP data before anything is modified, since an exception thrown by the modifier would erase the resource
+        std::shared_ptr<const sdp_entry> entry;
+        if (!sdp.empty())
+        {
+            try
+            {
+                entry = parsed_sdps.find_or_parse(sdp);
+            }
+            catch (const std::exception& e)
+            {
+                slog::log<slog::severities::error>(gate, SLOG_FLF) << "Invalid SDP data for internal id: " << internal_id << ": " << e.what();
+                return node_implementation_status::invalid_sdp;
+            }
+        }
+
+        const auto set_transportfile = make_node_implementation_transportfile_setter(node_resources, sdps, transportfiles, settings);
 
         // find sender or receiver with specified internal id
 
@@ -868,7 +1238,8 @@ namespace nvnmos
             const std::pair<nmos::id, nmos::type> id_type{ resource->id, resource->type };
             slog::log<slog::severities::info>(gate, SLOG_FLF) << "Updating " << id_type << " with internal id: " << internal_id;
 
-            if (nmos::types::sender == id_type.second && !sdp.empty())
+            // update node's clocks, unless the PTP status is being monitored directly
+            if (nmos::types::sender == id_type.second && entry && nvnmos::fields::ptp_status(settings).empty())
             {
                 auto source = impl::find_source_for_sender(node_resources, *resource);
                 if (node_resources.end() == source) throw node_implementation_exception();
@@ -876,9 +1247,7 @@ namespace nvnmos
                 if (clock_or_null.is_null()) throw node_implementation_exception();
                 const auto clock = nmos::clock_name(clock_or_null.as_string());
 
-                // hmm, the IS-05 update already calls sdp::parse_session_description(sdp) twice...
-                const auto parsed_sdp = sdp::parse_session_description(sdp);
-                const auto ts_refclks = impl::get_session_description_ts_refclks(parsed_sdp);
+                const auto ts_refclks = impl::get_session_description_ts_refclks(entry->session_description);
 
                 auto& clock_settings = nvnmos::fields::clocks(settings)[clock.name];
                 auto ptp_domain = nmos::fields::ptp_domain_number(clock_settings);
@@ -900,10 +1269,10 @@ namespace nvnmos
                 auto& active = connection_resource.data[nmos::fields::endpoint_active];
 
                 active[nmos::types::sender == connection_resource.type ? nmos::fields::receiver_id : nmos::fields::sender_id] = value::null();
-                active[nmos::fields::master_enable] = value::boolean(!sdp.empty());
+                active[nmos::fields::master_enable] = value::boolean(bool(entry));
                 active[nmos::fields::activation] = nmos::make_activation();
 
-                if (!sdp.empty())
+                if (entry)
                 {
                     if (nmos::types::receiver == connection_resource.type)
                     {
@@ -913,7 +1282,7 @@ namespace nvnmos
                         });
                     }
 
-                    active[nmos::fields::transport_params] = impl::get_session_description_transport_params(connection_resource.type, sdp::parse_session_description(sdp));
+                    active[nmos::fields::transport_params] = impl::get_session_description_transport_params(connection_resource.type, entry->session_description);
                 }
 
                 // Update an IS-05 sender's /transportfile endpoint
@@ -922,29 +1291,528 @@ namespace nvnmos
                 {
                     set_transportfile(*resource, connection_resource, connection_resource.data[nmos::fields::endpoint_transportfile]);
                 }
-            });
 
-            nmos::modify_resource(node_resources, id_type.first, [&](nmos::resource& resource)
-            {
-                nmos::set_resource_subscription(resource, !sdp.empty(), {}, activation_time);
+                // the application made this activation itself, so it is the state to roll back to if a later activation fails
+                rollback.accept(connection_resource.id, nmos::make_version(connection_resource.created), active);
             });
+
+            // while the data plane deadline is missed, the subscription remains inactive
+            auto connection_resource = nmos::find_resource(connection_resources, id_type);
+            if (connection_resources.end() == connection_resource) throw node_implementation_exception();
+            impl::update_subscription(node_resources, *connection_resource, liveness.expired, activation_time);
+
+            connections.update(node_resources, connection_resources, id_type.first);
+
+            return node_implementation_status::ok;
         }
         else
         {
-            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Could not find sender or receiver with internal id: " << internal_id;
+            // the status is returned to the caller, which may expect this, e.g. when activating a sender or receiver that may already have gone
+            slog::log<slog::severities::info>(gate, SLOG_FLF) << "Could not find sender or receiver with internal id: " << internal_id;
+            return node_implementation_status::not_found;
         }
     }
 
-    // This updates the transport parameters and transport file for the specified sender or receiver based on the specified SDP file.
-    // For now, the SDP file is not validated against the existing sender or receiver capabilities and constraints.
-    void node_implementation_activate_rtp_connection(nmos::node_model& model, const utility::string_t& internal_id, const std::string& sdp, slog::base_gate& gate)
+    // This makes the activation callback of the node implementation for each sender and receiver which is active, e.g. when a standby
+    // whose state has been replicated from the primary is promoted
+    void node_implementation_activate_active(nmos::node_model& model, const nmos::experimental::node_implementation& node_implementation, slog::base_gate& gate)
     {
-        auto lock = model.write_lock(); // in order to update the resources
+        auto lock = model.write_lock(); // in order to update the resources, as for an IS-05 Connection API activation
 
-        node_implementation_activate_rtp_connection_(model.node_resources, model.connection_resources, internal_id, sdp, model.settings, gate);
+        // the callback may roll back the /active endpoint, so the senders and receivers are found first
+        std::vector<std::pair<nmos::id, nmos::type>> active;
+        for (const auto& connection_resource : model.connection_resources)
+        {
+            if (nmos::types::sender != connection_resource.type && nmos::types::receiver != connection_resource.type) continue;
+            if (!nmos::fields::master_enable(nmos::fields::endpoint_active(connection_resource.data))) continue;
+            active.push_back({ connection_resource.id, connection_resource.type });
+        }
 
-        model.notify();
-    }
+        for (const auto& id_type : active)
+        {
+            auto resource = nmos::find_resource(model.node_resources, id_type);
+            auto connection_resource = nmos::find_resource(model.connection_resources, id_type);
+            if (model.node_resources.end() == resource || model.connection_resources.end() == connection_resource) continue;
+
+            slog::log<slog::severities::info>(gate, SLOG_FLF) << "Applying replicated activation of " << id_type;
+            node_implementation.connection_activated(*resource, *connection_resource);
+        }
+
+        model.notify();
+    }
+
+    // This updates the transport parameters and transport file for the specified sender or receiver based on the specified SDP file.
+    // For now, the SDP file is not validated against the existing sender or receiver capabilities and constraints.
+    node_implementation_status node_implementation_activate_rtp_connection(nmos::node_model& model, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, const utility::string_t& internal_id, const std::string& sdp, slog::base_gate& gate)
+    {
+        auto lock = model.write_lock(); // in order to update the resources
+
+        const auto status = node_implementation_activate_rtp_connection_(model.node_resources, model.connection_resources, sdps, parsed_sdps, transportfiles, rollback, connections, liveness, internal_id, sdp, model.settings, gate);
+        if (node_implementation_status::ok != status) return status;
+
+        model.notify();
+        return status;
+    }
+
+    // This makes a task which applies the activations submitted to the queue, in order
+    // Requests for the same sender or receiver which are queued together are coalesced, so only the latest is applied
+    node_implementation_task make_node_implementation_activation_queue_task(nmos::node_model& model, activation_queue& queue, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, activation_completion_handler activation_completed, slog::base_gate& gate)
+    {
+        auto lock = model.read_lock();
+        // when the queue's file descriptor indicates that requests have been submitted, the interval is only a fallback
+        const auto interval = -1 != queue.poll_fd()
+            ? std::chrono::milliseconds(100)
+            : std::chrono::milliseconds(nvnmos::fields::activation_queue_interval(model.settings));
+        lock.unlock();
+
+        // the producers don't notify the model, since that might block a real-time thread, so the queue is drained without the lock
+        // and the write lock is only taken when there are requests to apply
+        return [&model, &queue, &sdps, &parsed_sdps, &transportfiles, &rollback, &connections, &liveness, activation_completed, &gate, interval]
+        {
+            // reset the queue's file descriptor, if it is polled by the application's event loop
+            queue.wait_for(std::chrono::milliseconds::zero());
+
+            std::vector<std::pair<std::string, std::string>> requests;
+            std::string id, sdp;
+            while (queue.pop(id, sdp))
+            {
+                auto superseded = boost::range::find_if(requests, [&](const std::pair<std::string, std::string>& request) { return id == request.first; });
+                if (requests.end() != superseded) requests.erase(superseded);
+                requests.push_back({ id, sdp });
+            }
+            if (requests.empty()) return node_implementation_task_clock::now() + interval;
+
+            std::vector<std::pair<std::string, bool>> results;
+            {
+                auto lock = model.write_lock(); // in order to update the resources
+
+                for (const auto& request : requests)
+                {
+                    bool success = false;
+                    try
+                    {
+                        success = node_implementation_status::ok == node_implementation_activate_rtp_connection_(model.node_resources, model.connection_resources, sdps, parsed_sdps, transportfiles, rollback, connections, liveness, utility::s2us(request.first), request.second, model.settings, gate);
+                    }
+                    catch (const node_implementation_exception&)
+                    {
+                        // node implementation writes the log message
+                    }
+                    catch (const std::exception& e)
+                    {
+                        slog::log<slog::severities::error>(gate, SLOG_FLF) << "Activation error for internal id: " << request.first << ": " << e.what();
+                    }
+                    results.push_back({ request.first, success });
+                }
+
+                model.notify();
+            }
+
+            // report completion without holding the lock
+            if (activation_completed)
+            {
+                for (const auto& result : results)
+                {
+                    activation_completed(result.first, result.second);
+                }
+            }
+
+            return node_implementation_task_clock::now() + interval;
+        };
+    }
+
+    // This makes a task which retries the activations which the application failed to apply, with an exponential backoff
+    // If a retry is accepted, the /active endpoint is restored to that activation, unless the sender or receiver has since been updated
+    // The application callback is made with the model locked for writing, in the same way as for an IS-05 Connection API activation
+    node_implementation_task make_node_implementation_activation_retry_task(nmos::node_model& model, activation_rollback& rollback, connection_index& connections, rtp_connection_activation_handler rtp_connection_activated, const sdp_store& sdps, transportfile_store& transportfiles, const data_plane_liveness& liveness, slog::base_gate& gate)
+    {
+        auto lock = model.read_lock();
+        const std::chrono::milliseconds interval(nvnmos::fields::activation_retry_interval(model.settings));
+        const auto max_attempts = (unsigned int)nvnmos::fields::activation_retries(model.settings);
+        lock.unlock();
+
+        // a new retry is scheduled when an activation fails, which notifies, but with the application's event loop, there is only polling
+        return [&model, &rollback, &connections, rtp_connection_activated, &sdps, &transportfiles, &liveness, &gate, interval, max_attempts]
+        {
+            const auto now = activation_rollback::clock::now();
+
+            auto retries = rollback.take_due(now);
+            if (!retries.empty())
+            {
+                auto lock = model.write_lock(); // in order to update the resources
+
+                bool notify = false;
+                for (auto& retry : retries)
+                {
+                    const std::pair<nmos::id, nmos::type> id_type{ retry.id, nmos::type{ retry.type } };
+
+                    auto connection_resource = nmos::find_resource(model.connection_resources, id_type);
+                    if (model.connection_resources.end() == connection_resource || retry.updated != nmos::make_version(connection_resource->updated))
+                    {
+                        slog::log<slog::severities::info>(gate, SLOG_FLF) << "Abandoning retry of superseded activation of " << id_type;
+                        continue;
+                    }
+
+                    ++retry.attempts;
+                    if (rtp_connection_activated(retry.internal_id, retry.sdp))
+                    {
+                        slog::log<slog::severities::info>(gate, SLOG_FLF) << "Retry " << retry.attempts << " of activation of " << id_type << " succeeded";
+                        const auto created = nmos::make_version(connection_resource->created);
+                        node_implementation_restore_active_(model.node_resources, model.connection_resources, sdps, transportfiles, connections, liveness, id_type, retry.endpoint_active, model.settings);
+                        rollback.accept(retry.id, created, retry.endpoint_active);
+                        notify = true;
+                    }
+                    else if (retry.attempts < max_attempts)
+                    {
+                        retry.due = now + interval * (1 << (std::min)(retry.attempts, 10u));
+                        rollback.schedule(std::move(retry));
+                    }
+                    else
+                    {
+                        slog::log<slog::severities::error>(gate, SLOG_FLF) << "Abandoning activation of " << id_type << " after " << retry.attempts << " retries";
+                    }
+                }
+
+                if (notify) model.notify();
+            }
+
+            return (std::min)(rollback.next_due(), now + interval);
+        };
+    }
+
+    // This checks that the specified SDP file would be accepted by node_implementation_add_sender or node_implementation_add_receiver
+    // given the specified host interfaces and node settings, by adding it to a scratch model rather than modifying any existing one.
+    // If accepted, it sets the internal id and the transport params from the SDP file; errors are reported in the same way as when adding.
+    node_implementation_status node_implementation_validate_sdp(const nmos::type& type, const std::string& sdp, const format_registry& formats, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, const nmos::settings& settings_, utility::string_t& internal_id, web::json::value& transport_params, slog::base_gate& gate)
+    {
+        nmos::resources node_resources;
+        nmos::resources connection_resources;
+        sdp_store sdps;
+        auto settings = settings_;
+
+        node_implementation_init_(node_resources, host_interfaces, settings, gate);
+
+        auto status = node_implementation_status::invalid_argument;
+        if (nmos::types::sender == type)
+        {
+            status = node_implementation_add_sender_(node_resources, connection_resources, sdps, formats, sdp, host_interfaces, settings, gate);
+        }
+        else if (nmos::types::receiver == type)
+        {
+            status = node_implementation_add_receiver_(node_resources, connection_resources, sdps, formats, sdp, host_interfaces, settings, gate);
+        }
+        if (node_implementation_status::ok != status) return status;
+
+        const auto parsed_sdp = sdp::parse_session_description(sdp);
+        internal_id = impl::get_session_description_internal_id(parsed_sdp);
+        transport_params = impl::get_session_description_transport_params(type, parsed_sdp);
+        return status;
+    }
+
+    // This runs the specified task each time it is due, until the server is shut down
+    void node_implementation_task_thread(nmos::node_model& model, node_implementation_task task)
+    {
+        auto lock = model.read_lock();
+        while (!model.shutdown)
+        {
+            // run the task without holding the lock
+            lock.unlock();
+            const auto due = task();
+            lock.lock();
+
+            // the wait only ends early when the server is shut down; tasks which need to be woken by other events have their own threads
+            model.wait_until(lock, due, [&] { return model.shutdown; });
+        }
+    }
+
+    // This runs the activation queue task as soon as requests are submitted to the queue, rather than polling it, until the server is shut down
+    void node_implementation_activation_queue_thread(nmos::node_model& model, activation_queue& queue, node_implementation_task task)
+    {
+        for (;;)
+        {
+            {
+                auto lock = model.read_lock();
+                if (model.shutdown) break;
+            }
+
+            // the timeout only limits how long shutdown may take, requests are applied as soon as they are submitted
+            if (queue.wait_for(std::chrono::milliseconds(100))) task();
+        }
+    }
+
+    // This makes a task which monitors the data plane liveness and, when the deadline is missed, advertises all senders and receivers
+    // as inactive until the data plane is alive again, at which point their subscriptions are restored from the IS-05 /active endpoints.
+    node_implementation_task make_node_implementation_data_plane_task(nmos::node_model& model, data_plane_liveness& liveness, slog::base_gate& gate)
+    {
+        auto lock = model.read_lock();
+        const std::chrono::milliseconds timeout(nvnmos::fields::data_plane_timeout(model.settings));
+        lock.unlock();
+
+        // while expired, check frequently so that recovery is noticed promptly
+        const auto recovery_interval = (std::min)(timeout, std::chrono::milliseconds(100));
+
+        return [&model, &liveness, &gate, timeout, recovery_interval]
+        {
+            const auto now = data_plane_liveness::clock::now();
+            const auto deadline = liveness.last_alive_time() + timeout;
+
+            if (liveness.expired != (deadline <= now))
+            {
+                const bool expired = !liveness.expired;
+
+                if (expired)
+                {
+                    slog::log<slog::severities::error>(gate, SLOG_FLF) << "Data plane deadline missed; advertising senders and receivers as inactive";
+                }
+                else
+                {
+                    slog::log<slog::severities::info>(gate, SLOG_FLF) << "Data plane alive; restoring senders' and receivers' subscriptions";
+                }
+
+                auto lock = model.write_lock(); // in order to update the resources
+
+                impl::update_data_plane_subscriptions(model.node_resources, model.connection_resources, expired);
+                liveness.expired = expired;
+
+                model.notify();
+            }
+
+            return liveness.expired ? now + recovery_interval : deadline;
+        };
+    }
+
+    // apply a batch of link events, keeping the shared link state, the node's interfaces and the link state of each leg
+    // of the senders and receivers up-to-date, and notifying the application of the affected legs
+    void node_implementation_apply_link_events_(nmos::node_model& model, const std::vector<link_event>& batch, link_state_handler link_state_changed, slog::base_gate& gate)
+    {
+        const bool addresses_changed = batch.end() != std::find_if(batch.begin(), batch.end(), [](const link_event& event)
+        {
+            return event.address_changed;
+        });
+
+        // the node's interfaces are updated with their current addresses, without holding the lock
+        const auto host_interfaces = addresses_changed
+            ? web::hosts::experimental::host_interfaces()
+            : std::vector<web::hosts::experimental::host_interface>{};
+
+        std::vector<std::pair<utility::string_t, bool>> changed;
+        std::vector<std::tuple<std::string, unsigned int, bool>> legs;
+        {
+            auto lock = model.write_lock(); // in order to update the link state and the resources
+
+            // last known link state, shared by every source of events, and assumed to be up until an event indicates otherwise
+            auto& link_states = nvnmos::fields::link_states(model.settings);
+            for (const auto& event : batch)
+            {
+                if (event.address_changed) continue;
+                const bool up = !link_states.has_field(event.name) || link_states.at(event.name).as_bool();
+                if (up == event.up) continue;
+                link_states[event.name] = web::json::value::boolean(event.up);
+                changed.push_back({ event.name, event.up });
+            }
+            if (changed.empty() && !addresses_changed) return;
+
+            const auto seed_id = nmos::experimental::fields::seed_id(model.settings);
+            const auto node_id = impl::make_id(seed_id, nmos::types::node);
+
+            // an interface whose link is down stays in the node, since the senders' and receivers' interface_bindings refer to it
+            if (addresses_changed) impl::update_node_interfaces(model.node_resources, node_id, host_interfaces);
+
+            // find the affected senders and receivers, before modifying them
+            std::vector<std::pair<nmos::id, nmos::type>> affected;
+            auto& by_type = model.node_resources.get<nmos::tags::type>();
+            for (const auto& type : { nmos::types::sender, nmos::types::receiver })
+            {
+                const auto resources = by_type.equal_range(nmos::details::has_data(type));
+                for (auto resource = resources.first; resources.second != resource; ++resource)
+                {
+                    const auto& interface_bindings = nmos::fields::interface_bindings(resource->data);
+                    for (unsigned int leg = 0; leg < (unsigned int)interface_bindings.size(); ++leg)
+                    {
+                        const auto& name = interface_bindings.at(leg).as_string();
+                        const auto change = std::find_if(changed.begin(), changed.end(), [&name](const std::pair<utility::string_t, bool>& change)
+                        {
+                            return name == change.first;
+                        });
+                        if (changed.end() == change) continue;
+                        legs.push_back(std::make_tuple(utility::us2s(impl::get_internal_id(*resource)), leg, change->second));
+                        if (affected.empty() || affected.back().first != resource->id) affected.push_back({ resource->id, type });
+                    }
+                }
+            }
+
+            // advertise the link state of each leg of the affected senders and receivers
+            for (const auto& id_type : affected)
+            {
+                nmos::modify_resource(model.node_resources, id_type.first, [&link_states](nmos::resource& resource)
+                {
+                    if (impl::set_link_state(resource, link_states))
+                    {
+                        resource.data[nmos::fields::version] = web::json::value::string(nmos::make_version());
+                    }
+                });
+            }
+
+            model.notify();
+        }
+
+        for (const auto& change : changed)
+        {
+            slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Network interface: " << change.first << " link is " << (change.second ? "up" : "down");
+        }
+
+        // notify the application without holding the lock
+        if (link_state_changed)
+        {
+            for (const auto& leg : legs)
+            {
+                link_state_changed(std::get<0>(leg), std::get<1>(leg), std::get<2>(leg));
+            }
+        }
+    }
+
+    // This monitors the network interfaces' link state, keeping the node's interfaces up-to-date and notifying the application
+    // of each leg of the senders and receivers which is affected by a link going down or coming up, until the server is shut down
+    void node_implementation_link_monitor_thread(nmos::node_model& model, link_event_source& events, link_state_handler link_state_changed, slog::base_gate& gate)
+    {
+        for (;;)
+        {
+            {
+                auto lock = model.read_lock();
+                if (model.shutdown) break;
+            }
+
+            // the timeout only limits how long shutdown may take, link events are received as soon as they occur
+            const auto batch = events.wait_for(std::chrono::milliseconds(100));
+            if (batch.empty()) continue;
+
+            node_implementation_apply_link_events_(model, batch, link_state_changed, gate);
+        }
+    }
+
+    // This makes a task which applies any available link events without waiting for them, for use when the events source's
+    // file descriptor is polled by the application's event loop
+    node_implementation_task make_node_implementation_link_monitor_task(nmos::node_model& model, link_event_source& events, link_state_handler link_state_changed, slog::base_gate& gate)
+    {
+        return [&model, &events, link_state_changed, &gate]
+        {
+            const auto batch = events.wait_for(std::chrono::milliseconds::zero());
+            if (!batch.empty()) node_implementation_apply_link_events_(model, batch, link_state_changed, gate);
+
+            // the events source's file descriptor indicates when events are available, so this is only a fallback
+            return node_implementation_task_clock::now() + std::chrono::milliseconds(100);
+        };
+    }
+
+    // This makes a task which polls the PTP status and, only when the grandmaster, domain, traceability or lock state changes,
+    // updates the node's clock and the senders' transport files
+    node_implementation_task make_node_implementation_ptp_status_task(nmos::node_model& model, ptp_status_source& source, const sdp_store& sdps, transportfile_store& transportfiles, bool split, slog::base_gate& gate)
+    {
+        auto lock = model.read_lock();
+        const std::chrono::milliseconds interval(nvnmos::fields::ptp_status_interval(model.settings));
+        lock.unlock();
+
+        // for now, only manage a single clock
+        const auto clock = nmos::clock_names::clk0;
+
+        bool first = true;
+        ptp_status last;
+
+        // when split, the state of the last request, and when the next one is due
+        bool pending = false;
+        auto due = node_implementation_task_clock::now();
+
+        return [&model, &source, &sdps, &transportfiles, &gate, interval, clock, split, first, last, pending, due]() mutable
+        {
+            const auto now = node_implementation_task_clock::now();
+
+            // query without holding the lock
+            ptp_status status;
+            bool available = false;
+            if (split)
+            {
+                if (!pending)
+                {
+                    // discard any late responses to an earlier request
+                    if (now < due)
+                    {
+                        source.receive(status);
+                        return due;
+                    }
+
+                    // send the request, then read the responses when the source's file descriptor is readable
+                    if (source.request())
+                    {
+                        pending = true;
+                        due = now + std::chrono::milliseconds(100);
+                        return due;
+                    }
+                }
+                else
+                {
+                    available = source.receive(status);
+                    if (!available && now < due) return due;
+                    pending = false;
+                }
+            }
+            else
+            {
+                available = source.get(status);
+            }
+
+            if (!available)
+            {
+                // if the status isn't available, the clock can't be considered locked
+                status = last;
+                status.locked = false;
+            }
+
+            if (first || status != last)
+            {
+                auto lock = model.write_lock(); // in order to update the resources
+
+                const auto seed_id = nmos::experimental::fields::seed_id(model.settings);
+                const auto node_id = impl::make_id(seed_id, nmos::types::node);
+
+                const auto node_clock = !status.gmid.empty()
+                    ? nmos::make_ptp_clock(clock, status.traceable, status.gmid, status.locked)
+                    : nmos::make_internal_clock(clock);
+                impl::update_node_clock(model.node_resources, node_id, node_clock);
+
+                nvnmos::fields::clocks(model.settings)[clock.name][nmos::fields::ptp_domain_number] = status.domain;
+
+                // the senders' /transportfile endpoints include ts-refclk based on the current clock
+
+                const auto set_transportfile = make_node_implementation_transportfile_setter(model.node_resources, sdps, transportfiles, model.settings);
+
+                auto& by_type = model.node_resources.get<nmos::tags::type>();
+                const auto senders = by_type.equal_range(nmos::details::has_data(nmos::types::sender));
+                for (auto sender = senders.first; senders.second != sender; ++sender)
+                {
+                    auto connection_sender = nmos::find_resource(model.connection_resources, { sender->id, nmos::types::sender });
+                    if (model.connection_resources.end() == connection_sender) continue;
+
+                    const auto& transportfile = nmos::fields::endpoint_transportfile(connection_sender->data);
+                    if (nmos::fields::transportfile_data(transportfile).is_null() && (!transportfile.has_field(U("href")) || transportfile.at(U("href")).is_null())) continue;
+
+                    nmos::modify_resource(model.connection_resources, sender->id, [&](nmos::resource& connection_sender)
+                    {
+                        set_transportfile(*sender, connection_sender, connection_sender.data[nmos::fields::endpoint_transportfile]);
+                    });
+                }
+
+                model.notify();
+
+                slog::log<slog::severities::info>(gate, SLOG_FLF) << "PTP status: grandmaster: " << (!status.gmid.empty() ? status.gmid : U("(none)"))
+                    << ", domain: " << status.domain << ", " << (status.locked ? "locked" : "not locked") << ", " << (status.traceable ? "traceable" : "not traceable");
+
+                last = status;
+                first = false;
+            }
+
+            due = node_implementation_task_clock::now() + interval;
+            return due;
+        };
+    }
 
     namespace impl
     {
@@ -1149,30 +2017,6 @@ namespace nvnmos
             return sdp::fields::information(session_description);
         }
 
-        // identify supported format from media type
-        format get_format(const nmos::media_type& media_type)
-        {
-            if (nmos::media_types::video_raw == media_type) return format::video;
-            if (nmos::media_types::audio_L(24) == media_type) return format::audio;
-            if (nmos::media_types::audio_L(16) == media_type) return format::audio;
-            if (nmos::media_types::video_smpte291 == media_type) return format::data;
-            if (nmos::media_types::video_SMPTE2022_6 == media_type) return format::mux;
-            throw node_implementation_exception{};
-        }
-
-        // get a little mnemonic string to use in resource labels and descriptions
-        utility::string_t get_format_hint(format format)
-        {
-            switch (format)
-            {
-            case format::video: return U("v");
-            case format::audio: return U("a");
-            case format::data: return U("d");
-            case format::mux: return U("m");
-            }
-            throw node_implementation_exception{};
-        }
-
         // find interface with the specified address
         std::vector<web::hosts::experimental::host_interface>::const_iterator find_interface(const std::vector<web::hosts::experimental::host_interface>& interfaces, const utility::string_t& address)
         {
@@ -1202,6 +2046,76 @@ namespace nvnmos
             return utility::s2us(boost::asio::ip::address_v4(a).to_string());
         }
 
+        // set the IS-05 constraints of each leg of a sender or receiver from the configured transport parameters and settings
+        // so that unacceptable PATCH requests are rejected by the Connection API before reaching the activation callback
+        // returning false if the configured transport parameters don't satisfy them
+        bool set_endpoint_constraints(web::json::value& constraints, const nmos::type& type, const web::json::value& transport_params, const nmos::settings& settings, slog::base_gate& gate)
+        {
+            using web::json::value;
+            using web::json::value_of;
+
+            const bool constrain_ports = 0 != nvnmos::fields::rtp_port_min(settings) || 0 != nvnmos::fields::rtp_port_max(settings);
+            const auto port_min = 0 != nvnmos::fields::rtp_port_min(settings) ? nvnmos::fields::rtp_port_min(settings) : 1;
+            const auto port_max = 0 != nvnmos::fields::rtp_port_max(settings) ? nvnmos::fields::rtp_port_max(settings) : 65535;
+            const auto port_constraint = value_of({
+                { nmos::fields::constraint_minimum, port_min },
+                { nmos::fields::constraint_maximum, port_max }
+            });
+
+            // source-specific multicast addresses, i.e. 232.0.0.0/8 or ff3x::/32
+            // see https://www.rfc-editor.org/rfc/rfc4607#section-1
+            // a sender's destination_ip may also be "auto", which the node implementation resolves to one
+            const auto ssm_constraint = value_of({
+                { nmos::fields::constraint_pattern, nmos::types::sender == type
+                    ? U("^(auto$|232\\.|[fF][fF]3[0-9a-fA-F]:)")
+                    : U("^(232\\.|[fF][fF]3[0-9a-fA-F]:)") }
+            });
+
+            const auto& interface_ip = nmos::types::sender == type ? nmos::fields::source_ip.key : nmos::fields::interface_ip.key;
+            const auto& multicast_ip = nmos::types::sender == type ? nmos::fields::destination_ip.key : nmos::fields::multicast_ip.key;
+
+            for (int leg = 0; leg < (int)constraints.size(); ++leg)
+            {
+                auto& leg_constraints = constraints[leg];
+                const auto& leg_params = transport_params.at(leg);
+
+                // the interface is fixed by the configuration
+                leg_constraints[interface_ip] = value_of({
+                    { nmos::fields::constraint_enum, value_of({ leg_params.at(interface_ip) }) }
+                });
+
+                if (constrain_ports)
+                {
+                    for (const auto& port : { nmos::fields::source_port.key, nmos::fields::destination_port.key })
+                    {
+                        if (!leg_constraints.has_field(port)) continue;
+
+                        // the configured port must satisfy the constraint too, since the initial /active parameters are not validated by the API
+                        if (leg_params.has_field(port) && leg_params.at(port).is_integer())
+                        {
+                            const auto configured = leg_params.at(port).as_integer();
+                            if (configured < port_min || port_max < configured)
+                            {
+                                slog::log<slog::severities::severe>(gate, SLOG_FLF)
+                                    << "Configured " << port << ": " << configured << " is outside the RTP port range for leg: " << leg;
+                                return false;
+                            }
+                        }
+
+                        leg_constraints[port] = port_constraint;
+                    }
+                }
+
+                if (nvnmos::fields::ssm_only(settings))
+                {
+                    // for receivers, unicast (a null multicast_ip) is still acceptable since the pattern only applies to strings
+                    leg_constraints[multicast_ip] = ssm_constraint;
+                }
+            }
+
+            return true;
+        }
+
         // set the internal id for the sender or receiver as a resource tag
         void set_internal_id(nmos::resource& resource, const utility::string_t& internal_id)
         {
@@ -1220,6 +2134,27 @@ namespace nvnmos
                 : U("");
         }
 
+        // set the link state of each leg of the sender or receiver as a resource tag, from the last known link state of its interfaces
+        // returning whether it has changed
+        bool set_link_state(nmos::resource& resource, const web::json::value& link_states)
+        {
+            using web::json::value;
+
+            // links are assumed to be up until an event indicates otherwise
+            auto states = value::array();
+            for (const auto& interface_binding : nmos::fields::interface_bindings(resource.data))
+            {
+                const auto& name = interface_binding.as_string();
+                const bool up = !link_states.has_field(name) || link_states.at(name).as_bool();
+                web::json::push_back(states, value::string(up ? U("up") : U("down")));
+            }
+
+            auto& tags = resource.data[nmos::fields::tags];
+            if (states == nvnmos::fields::link_state_tag(tags)) return false;
+            tags[nvnmos::fields::link_state_tag] = states;
+            return true;
+        }
+
         // set the group hint for the sender or receiver as a resource tag
         void set_group_hint(nmos::resource& resource, const utility::string_t& group_hint)
         {
@@ -1371,6 +2306,20 @@ namespace nvnmos
                 return interface_names.end() != interface_names.find(interface.name);
             }))));
 
+            // keep any bound interface which the host no longer reports, e.g. because its link is down,
+            // since the senders' and receivers' interface_bindings must refer to the node's interfaces
+            for (const auto& interface : nmos::fields::interfaces(node->data))
+            {
+                const auto& name = nmos::fields::name(interface);
+                if (interface_names.end() == interface_names.find(name)) continue;
+                const auto& current = interfaces.as_array();
+                if (current.end() != std::find_if(current.begin(), current.end(), [&name](const web::json::value& interface_)
+                {
+                    return name == nmos::fields::name(interface_);
+                })) continue;
+                web::json::push_back(interfaces, interface);
+            }
+
             if (interfaces.as_array() != nmos::fields::interfaces(node->data))
             {
                 nmos::modify_resource(node_resources, node_id, [&interfaces](nmos::resource& node)
@@ -1381,21 +2330,81 @@ namespace nvnmos
                 });
             }
         }
+
+        // modify a sender's or receiver's subscription to be inactive, or to match its IS-05 /active endpoint
+        void update_subscription(nmos::resources& node_resources, const nmos::resource& connection_resource, bool expired, const nmos::tai& at)
+        {
+            const auto& endpoint_active = nmos::fields::endpoint_active(connection_resource.data);
+            const auto active = !expired && nmos::fields::master_enable(endpoint_active);
+            const auto& connected_id_or_null = nmos::types::sender == connection_resource.type
+                ? nmos::fields::receiver_id(endpoint_active)
+                : nmos::fields::sender_id(endpoint_active);
+            const auto connected_id = active && !connected_id_or_null.is_null() ? connected_id_or_null.as_string() : nmos::id{};
+
+            nmos::modify_resource(node_resources, connection_resource.id, [&](nmos::resource& resource)
+            {
+                nmos::set_resource_subscription(resource, active, connected_id, at);
+            });
+        }
+
+        // modify senders' and receivers' subscriptions to be inactive, or to match their IS-05 /active endpoints
+        void update_data_plane_subscriptions(nmos::resources& node_resources, const nmos::resources& connection_resources, bool expired)
+        {
+            const auto at = nmos::tai_now();
+
+            for (const auto& connection_resource : connection_resources)
+            {
+                if (!connection_resource.has_data()) continue;
+
+                update_subscription(node_resources, connection_resource, expired, at);
+            }
+        }
+    }
+
+    // This gets the internal id of the specified sender or receiver.
+    utility::string_t node_implementation_get_internal_id(const nmos::resource& resource)
+    {
+        return impl::get_internal_id(resource);
+    }
+
+    // This replaces the default node behaviour, if required by the settings, e.g. to disable the DNS-SD advertisement of the Node API.
+    // It must be called after nmos::experimental::make_node_server, before the server is opened.
+    void node_implementation_customize_behaviour(nmos::server& node_server, nmos::node_model& model, const nmos::experimental::node_implementation& node_implementation, slog::base_gate& gate)
+    {
+        if (nvnmos::fields::node_advertisement(model.settings)) return;
+
+        // nmos::experimental::make_node_server sets up the node behaviour (including the DNS-SD advertisements)
+        // as the first thread function; replace it with the same behaviour using an advertiser that doesn't advertise
+        // but still using the default DNS-SD implementation for discovery, which only browses if no registry_address
+        // has been configured
+        if (node_server.thread_functions.empty()) throw node_implementation_exception();
+
+        auto load_ca_certificates = node_implementation.load_ca_certificates;
+        auto registration_changed = node_implementation.registration_changed;
+        node_server.thread_functions.front() = [&model, load_ca_certificates, registration_changed, &gate]
+        {
+            mdns::service_advertiser advertiser(std::unique_ptr<mdns::details::service_advertiser_impl>(new impl::null_service_advertiser_impl));
+            mdns::service_discovery discovery(gate);
+
+            nmos::node_behaviour_thread(model, load_ca_certificates, registration_changed, advertiser, discovery, gate);
+        };
+
+        slog::log<slog::severities::info>(gate, SLOG_FLF) << "Node API DNS-SD advertisement is disabled";
     }
 
     // This constructs all the callbacks used to integrate the application into the server instance for the NMOS Node.
-    nmos::experimental::node_implementation make_node_implementation(nmos::node_model& model, rtp_connection_activation_handler rtp_connection_activated, slog::base_gate& gate)
+    nmos::experimental::node_implementation make_node_implementation(nmos::node_model& model, rtp_connection_activation_handler rtp_connection_activated, sender_transportfile_resolver resolve_sender_transportfile, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, node_health& health, startup_times& startup, slog::base_gate& gate)
     {
         return nmos::experimental::node_implementation()
             .on_load_server_certificates(nmos::make_load_server_certificates_handler(model.settings, gate))
             .on_load_dh_param(nmos::make_load_dh_param_handler(model.settings, gate))
             .on_load_ca_certificates(nmos::make_load_ca_certificates_handler(model.settings, gate))
             .on_system_changed(make_node_implementation_system_global_handler(model, gate)) // may be omitted if not required
-            .on_registration_changed(make_node_implementation_registration_handler(gate)) // may be omitted if not required
+            .on_registration_changed(make_node_implementation_registration_handler(health, startup, gate)) // may be omitted if not required
             .on_parse_transport_file(make_node_implementation_transport_file_parser()) // may be omitted if the default is sufficient
             .on_validate_connection_resource_patch(make_node_implementation_patch_validator()) // may be omitted if not required
             .on_resolve_auto(make_node_implementation_auto_resolver())
-            .on_set_transportfile(make_node_implementation_transportfile_setter(model.node_resources, model.settings))
-            .on_connection_activated(make_node_implementation_connection_activation_handler(std::move(rtp_connection_activated), model.settings, gate));
+            .on_set_transportfile(make_node_implementation_transportfile_setter(model.node_resources, sdps, transportfiles, model.settings))
+            .on_connection_activated(make_node_implementation_connection_activation_handler(model, std::move(rtp_connection_activated), std::move(resolve_sender_transportfile), sdps, parsed_sdps, transportfiles, rollback, connections, liveness, gate));
     }
 }
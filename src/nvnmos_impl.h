@@ -26,6 +26,13 @@
 #ifndef NVNMOS_IMPL_H
 #define NVNMOS_IMPL_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "cpprest/host_utils.h"
 #include "cpprest/json_utils.h"
 
 namespace slog
@@ -36,6 +43,9 @@ namespace slog
 namespace nmos
 {
     struct node_model;
+    struct resource;
+    struct server;
+    struct type;
 
     namespace experimental
     {
@@ -52,8 +62,32 @@ namespace nvnmos
         const web::json::field_as_value_or device_tags{ U("device_tags"), web::json::value::object() };
         const web::json::field_as_value senders{ U("senders") }; // object with ids as keys
         const web::json::field_as_value receivers{ U("receivers") }; // object with ids as keys
-        const web::json::field_as_string sdp{ U("sdp") };
+        const web::json::field_as_string sdp_key{ U("sdp_key") }; // see nvnmos::sdp_store
         const web::json::field_as_value clocks{ U("clocks") }; // object with clock names as keys
+        const web::json::field_as_integer_or data_plane_timeout{ U("data_plane_timeout"), 0 }; // milliseconds, or zero to disable
+        const web::json::field_as_bool_or node_advertisement{ U("node_advertisement"), true };
+        const web::json::field_as_string_or query_api{ U("query_api"), U("") }; // base URL of a Query API, or empty to disable
+        const web::json::field_as_bool_or lazy_transport_files{ U("lazy_transport_files"), false };
+        const web::json::field_as_bool_or link_monitor{ U("link_monitor"), false };
+        const web::json::field_as_string_or link_events{ U("link_events"), U("netlink") }; // or "application" for events pushed via nvnmos::fake_link_event_source
+        const web::json::field_as_value link_states{ U("link_states") }; // object with interface names as keys, and whether the link is up as values
+        const web::json::field_as_string_or ptp_status{ U("ptp_status"), U("") }; // see nvnmos::make_ptp_status_source, or empty to use the SDP ts-refclk
+        const web::json::field_as_integer_or ptp_status_domain{ U("ptp_status_domain"), 0 };
+        const web::json::field_as_integer_or ptp_status_interval{ U("ptp_status_interval"), 1000 }; // milliseconds
+        const web::json::field_as_integer_or rtp_port_min{ U("rtp_port_min"), 0 }; // zero for no minimum
+        const web::json::field_as_integer_or rtp_port_max{ U("rtp_port_max"), 0 }; // zero for no maximum
+        const web::json::field_as_bool_or ssm_only{ U("ssm_only"), false };
+        const web::json::field_as_integer_or activation_queue_size{ U("activation_queue_size"), 0 }; // zero to disable
+        const web::json::field_as_integer_or activation_queue_sdp_size{ U("activation_queue_sdp_size"), 16384 }; // bytes
+        const web::json::field_as_integer_or activation_queue_interval{ U("activation_queue_interval"), 1 }; // milliseconds, only used when the queue has to be polled
+        const web::json::field_as_integer_or activation_retries{ U("activation_retries"), 0 }; // zero to roll back without retrying
+        const web::json::field_as_integer_or activation_retry_interval{ U("activation_retry_interval"), 100 }; // milliseconds, doubled after each attempt
+        const web::json::field_as_bool_or external_event_loop{ U("external_event_loop"), false }; // see nvnmos::event_loop
+        const web::json::field_as_integer_or http_threads{ U("http_threads"), 0 }; // zero for the cpprestsdk default
+        const web::json::field_as_string_or replication_socket{ U("replication_socket"), U("") }; // see nvnmos::replication_log, or empty to disable
+        const web::json::field_as_bool_or replication_standby{ U("replication_standby"), false };
+        const web::json::field_as_bool_or replication_auto_promote{ U("replication_auto_promote"), false };
+        const web::json::field_as_bool_or registry_accounting{ U("registry_accounting"), false }; // see nvnmos::registry_accounting
     }
 
     // custom SDP attributes
@@ -68,33 +102,244 @@ namespace nvnmos
         const utility::string_t source_port{ U("x-nvnmos-src-port") };
     }
 
+    class activation_queue;
+    class connection_index;
+    class format_registry;
+    class link_event_source;
+    class ptp_status_source;
+    class sdp_cache;
+    class sdp_store;
+    class transportfile_store;
+
+    // Exceptions are reserved for unexpected errors; expected failures are returned as a status, and the node implementation writes the log message
     struct node_implementation_exception {};
 
+    enum class node_implementation_status
+    {
+        ok,
+        // no sender or receiver has the specified internal id
+        not_found,
+        // a sender or receiver with the same internal id already exists
+        duplicate_id,
+        // the media type of the SDP data is not supported
+        unsupported_format,
+        // no network interface corresponds to a connection address in the SDP data
+        no_interface,
+        // the SDP data could not be parsed
+        invalid_sdp,
+        // e.g. a configured port is outside the RTP port range
+        invalid_argument
+    };
+
+    // Data plane liveness, indicated by the application and monitored by the task from make_node_implementation_data_plane_task
+    struct data_plane_liveness
+    {
+        typedef std::chrono::steady_clock clock;
+
+        // time of the last indication, as a count of clock ticks, so that the indication is a single atomic store
+        std::atomic<clock::rep> last_alive{ clock::now().time_since_epoch().count() };
+        // whether the deadline has been missed and the senders and receivers are advertised as inactive
+        std::atomic<bool> expired{ false };
+
+        void alive() { last_alive.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed); }
+        clock::time_point last_alive_time() const { return clock::time_point(clock::duration(last_alive.load(std::memory_order_relaxed))); }
+    };
+
+    // Node health, updated by the server and the node behaviour, and read by the health endpoints without waiting for the model lock
+    struct node_health
+    {
+        typedef std::chrono::steady_clock clock;
+
+        // whether the API ports are open, which a standby only does when promoted
+        std::atomic<bool> listening{ false };
+        // whether the node is in registered operation with a Registration API
+        std::atomic<bool> registered{ false };
+        // time the registered operation last started or stopped, as a count of clock ticks
+        std::atomic<clock::rep> registration_changed{ clock::now().time_since_epoch().count() };
+
+        void set_registered(bool value)
+        {
+            registered = value;
+            registration_changed.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        }
+        clock::time_point registration_changed_time() const { return clock::time_point(clock::duration(registration_changed.load(std::memory_order_relaxed))); }
+    };
+
+    // Times at which the phases of starting the server completed, so that the time to registered operation can be broken down
+    struct startup_times
+    {
+        typedef std::chrono::steady_clock clock;
+
+        enum phase { settings, server, init, resources, open, registered, num_phases };
+        static const char* phase_name(phase which);
+
+        const clock::time_point start{ clock::now() };
+        // time after the start, as a count of clock ticks, or -1 until the phase has completed
+        std::array<std::atomic<clock::rep>, num_phases> elapsed;
+
+        startup_times() { for (auto& time : elapsed) time = -1; }
+
+        // record the completion of the phase, returning false if it had already completed
+        bool complete(phase which)
+        {
+            clock::rep expected = -1;
+            return elapsed[which].compare_exchange_strong(expected, (clock::now() - start).count());
+        }
+
+        // summarize the phases which have completed, e.g. "settings 1.2 ms, server 3.4 ms"
+        std::string summary() const;
+    };
+
+    // The IS-05 /active endpoint of each sender and receiver which the application last accepted, so that when the application fails
+    // to apply an activation, the /active endpoint can be rolled back to match the data plane, and the activation retried if required
+    class activation_rollback
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        // an activation which the application failed to apply
+        struct retry
+        {
+            utility::string_t id;
+            utility::string_t type;
+            std::string internal_id;
+            std::string sdp;
+            // the /active endpoint to restore if the application then accepts the activation
+            web::json::value endpoint_active;
+            // the update time of the connection resource after it was rolled back, so that a superseded activation isn't retried
+            utility::string_t updated;
+            unsigned int attempts;
+            clock::time_point due;
+        };
+
+        // record the /active endpoint accepted by the application for the specified connection resource
+        // the creation time distinguishes a sender or receiver which has been removed and added again with the same id
+        void accept(const utility::string_t& id, const utility::string_t& created, const web::json::value& endpoint_active);
+
+        // get the /active endpoint last accepted by the application, or null if there isn't one
+        web::json::value last_accepted(const utility::string_t& id, const utility::string_t& created) const;
+
+        // forget the /active endpoint and any pending retry for a connection resource which has been removed
+        void forget(const utility::string_t& id);
+
+        // forget everything, when all the connection resources have been removed
+        void clear();
+
+        // schedule a retry, replacing any pending retry for the same connection resource
+        void schedule(retry next);
+
+        // remove and return the retries which are due
+        std::vector<retry> take_due(clock::time_point now);
+
+        // get the time the next retry is due, or clock::time_point::max() if there are none
+        clock::time_point next_due() const;
+
+    private:
+        mutable std::mutex mutex;
+        std::map<utility::string_t, std::pair<utility::string_t, web::json::value>> accepted;
+        std::vector<retry> retries;
+    };
+
     // This constructs and inserts a node resource and a device resource into the model, based on the model settings.
     void node_implementation_init(nmos::node_model& model, slog::base_gate& gate);
 
     // This constructs and inserts sources/flows/senders into the model, based on the specified SDP file.
-    void node_implementation_add_sender(nmos::node_model& model, const std::string& sdp, slog::base_gate& gate);
+    // The format-specific parts of the resources are made by the handler for its media type.
+    node_implementation_status node_implementation_add_sender(nmos::node_model& model, sdp_store& sdps, const format_registry& formats, const std::string& sdp, slog::base_gate& gate);
 
     // This removes sources/flows/senders from the model corresponding to the specified id.
-    void node_implementation_remove_sender(nmos::node_model& model, const utility::string_t& id, slog::base_gate& gate);
+    node_implementation_status node_implementation_remove_sender(nmos::node_model& model, sdp_store& sdps, transportfile_store& transportfiles, activation_rollback& rollback, const utility::string_t& id, slog::base_gate& gate);
 
     // This constructs and inserts a receiver into the model, based on the specified SDP file.
-    void node_implementation_add_receiver(nmos::node_model& model, const std::string& sdp, slog::base_gate& gate);
+    // The format-specific parts of the resource are made by the handler for its media type.
+    node_implementation_status node_implementation_add_receiver(nmos::node_model& model, sdp_store& sdps, const format_registry& formats, const std::string& sdp, slog::base_gate& gate);
 
     // This removes the receiver from the model corresponding to the specified id.
-    void node_implementation_remove_receiver(nmos::node_model& model, const utility::string_t& id, slog::base_gate& gate);
+    node_implementation_status node_implementation_remove_receiver(nmos::node_model& model, sdp_store& sdps, activation_rollback& rollback, connection_index& connections, const utility::string_t& id, slog::base_gate& gate);
+
+    // This constructs and inserts the receivers and senders into the model, based on the specified SDP files, in a single update.
+    node_implementation_status node_implementation_add_receivers_and_senders(nmos::node_model& model, sdp_store& sdps, const format_registry& formats, const std::vector<std::string>& receiver_sdps, const std::vector<std::string>& sender_sdps, slog::base_gate& gate);
+
+    // This removes all sources/flows/senders and receivers from the model in a single update, leaving the node and device.
+    void node_implementation_reset(nmos::node_model& model, sdp_store& sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, slog::base_gate& gate);
+
+    // This gets the internal id of the specified sender or receiver.
+    utility::string_t node_implementation_get_internal_id(const nmos::resource& resource);
 
     // This is an application callback to update the specified sender or receiver, as a result of an IS-05 Connection API activation.
     // If the SDP file is empty, the sender or receiver has been deactivated.
-    typedef std::function<void(const std::string& id, const std::string& sdp)> rtp_connection_activation_handler;
+    // It returns whether the activation was applied; if not, the /active endpoint is rolled back, see nvnmos::activation_rollback.
+    typedef std::function<bool(const std::string& id, const std::string& sdp)> rtp_connection_activation_handler;
+
+    // This is an application callback to notify that the network link of the specified leg of a sender or receiver has gone down or come up.
+    typedef std::function<void(const std::string& id, unsigned int leg, bool up)> link_state_handler;
+
+    // This is a callback to look up the transport file of a remote sender, e.g. from nvnmos::query_cache.
+    // If the transport file isn't known, it returns an empty string.
+    typedef std::function<utility::string_t(const utility::string_t& sender_id)> sender_transportfile_resolver;
+
+    // This replaces the default node behaviour, if required by the settings, e.g. to disable the DNS-SD advertisement of the Node API.
+    // It must be called after nmos::experimental::make_node_server, before the server is opened.
+    void node_implementation_customize_behaviour(nmos::server& node_server, nmos::node_model& model, const nmos::experimental::node_implementation& node_implementation, slog::base_gate& gate);
 
     // This constructs all the callbacks used to integrate the application into the server instance for the NMOS Node.
-    nmos::experimental::node_implementation make_node_implementation(nmos::node_model& model, rtp_connection_activation_handler rtp_connection_activated, slog::base_gate& gate);
+    nmos::experimental::node_implementation make_node_implementation(nmos::node_model& model, rtp_connection_activation_handler rtp_connection_activated, sender_transportfile_resolver resolve_sender_transportfile, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, node_health& health, startup_times& startup, slog::base_gate& gate);
+
+    // This makes the activation callback of the node implementation for each sender and receiver which is active, e.g. when a standby
+    // whose state has been replicated from the primary is promoted, so that any which the application fails to apply are rolled back
+    // in the same way as an IS-05 Connection API activation
+    void node_implementation_activate_active(nmos::node_model& model, const nmos::experimental::node_implementation& node_implementation, slog::base_gate& gate);
 
     // This updates the transport parameters and transport file for the specified sender or receiver based on the specified SDP file.
     // For now, the SDP file is not validated against the existing sender or receiver capabilities and constraints.
-    void node_implementation_activate_rtp_connection(nmos::node_model& model, const utility::string_t& id, const std::string& sdp, slog::base_gate& gate);
+    // While the data plane deadline is missed, the subscription remains inactive.
+    node_implementation_status node_implementation_activate_rtp_connection(nmos::node_model& model, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, const utility::string_t& id, const std::string& sdp, slog::base_gate& gate);
+
+    // This is an application callback to notify that an activation submitted to the queue has been applied, or has failed.
+    typedef std::function<void(const std::string& id, bool success)> activation_completion_handler;
+
+    // This is a periodic task of the node implementation, which runs without blocking if it is due, and returns when it is next due.
+    // Tasks are either run by node_implementation_task_thread, or by the application's event loop via nvnmos::event_loop.
+    typedef std::chrono::steady_clock node_implementation_task_clock;
+    typedef std::function<node_implementation_task_clock::time_point()> node_implementation_task;
+
+    // This runs the specified task each time it is due, until the server is shut down
+    void node_implementation_task_thread(nmos::node_model& model, node_implementation_task task);
+
+    // This makes a task which applies the activations submitted to the queue, in order
+    // Requests for the same sender or receiver which are queued together are coalesced, so only the latest is applied
+    node_implementation_task make_node_implementation_activation_queue_task(nmos::node_model& model, activation_queue& queue, const sdp_store& sdps, sdp_cache& parsed_sdps, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const data_plane_liveness& liveness, activation_completion_handler activation_completed, slog::base_gate& gate);
+
+    // This runs the activation queue task as soon as requests are submitted to the queue, rather than polling it, until the server is shut down
+    void node_implementation_activation_queue_thread(nmos::node_model& model, activation_queue& queue, node_implementation_task task);
+
+    // This makes a task which retries the activations which the application failed to apply, with an exponential backoff
+    // If a retry is accepted, the /active endpoint is restored to that activation, unless the sender or receiver has since been updated
+    // The application callback is made with the model locked for writing, in the same way as for an IS-05 Connection API activation
+    node_implementation_task make_node_implementation_activation_retry_task(nmos::node_model& model, activation_rollback& rollback, connection_index& connections, rtp_connection_activation_handler rtp_connection_activated, const sdp_store& sdps, transportfile_store& transportfiles, const data_plane_liveness& liveness, slog::base_gate& gate);
+
+    // This checks that the specified SDP file would be accepted by node_implementation_add_sender or node_implementation_add_receiver
+    // given the specified host interfaces and node settings, by adding it to a scratch model rather than modifying any existing one.
+    // If accepted, it sets the internal id and the transport params from the SDP file; errors are reported in the same way as when adding.
+    node_implementation_status node_implementation_validate_sdp(const nmos::type& type, const std::string& sdp, const format_registry& formats, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, const web::json::value& settings, utility::string_t& internal_id, web::json::value& transport_params, slog::base_gate& gate);
+
+    // This makes a task which monitors the data plane liveness and, when the deadline is missed, advertises all senders and receivers
+    // as inactive until the data plane is alive again, at which point their subscriptions are restored from the IS-05 /active endpoints.
+    node_implementation_task make_node_implementation_data_plane_task(nmos::node_model& model, data_plane_liveness& liveness, slog::base_gate& gate);
+
+    // This monitors the network interfaces' link state, keeping the node's interfaces up-to-date and notifying the application
+    // of each leg of the senders and receivers which is affected by a link going down or coming up, until the server is shut down
+    void node_implementation_link_monitor_thread(nmos::node_model& model, link_event_source& events, link_state_handler link_state_changed, slog::base_gate& gate);
+
+    // This makes a task which applies any available link events without waiting for them, for use when the events source's
+    // file descriptor is polled by the application's event loop
+    node_implementation_task make_node_implementation_link_monitor_task(nmos::node_model& model, link_event_source& events, link_state_handler link_state_changed, slog::base_gate& gate);
+
+    // This makes a task which polls the PTP status and, only when the grandmaster, domain, traceability or lock state changes,
+    // updates the node's clock and the senders' transport files
+    // If split, the query is sent and its responses are read in separate runs, so the task never blocks, for use when the source's
+    // file descriptor is polled by the application's event loop
+    node_implementation_task make_node_implementation_ptp_status_task(nmos::node_model& model, ptp_status_source& source, const sdp_store& sdps, transportfile_store& transportfiles, bool split, slog::base_gate& gate);
 }
 
 #endif
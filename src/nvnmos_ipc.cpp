@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_ipc.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace nvnmos
+{
+    namespace ipc
+    {
+        // send a message, with optional file descriptors, returning false on error
+        bool send_message(int socket, const std::string& message, const int* fds, size_t num_fds)
+        {
+            if (max_message_size < message.size()) return false;
+
+            iovec iov{ (void*)message.data(), message.size() };
+            msghdr header{};
+            header.msg_iov = &iov;
+            header.msg_iovlen = 1;
+
+            std::vector<char> control;
+            if (0 != num_fds)
+            {
+                control.resize(CMSG_SPACE(num_fds * sizeof(int)));
+                header.msg_control = control.data();
+                header.msg_controllen = control.size();
+                auto cmsg = CMSG_FIRSTHDR(&header);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(num_fds * sizeof(int));
+                std::memcpy(CMSG_DATA(cmsg), fds, num_fds * sizeof(int));
+            }
+
+            ssize_t result;
+            do result = ::sendmsg(socket, &header, MSG_NOSIGNAL); while (-1 == result && EINTR == errno);
+            return (ssize_t)message.size() == result;
+        }
+
+        // receive a message, with optional file descriptors, returning false on error or if the peer has disconnected
+        // the number of file descriptors is updated to the number received
+        bool receive_message(int socket, std::string& message, int* fds, size_t* num_fds)
+        {
+            message.resize(max_message_size);
+            iovec iov{ &message[0], message.size() };
+            msghdr header{};
+            header.msg_iov = &iov;
+            header.msg_iovlen = 1;
+
+            const size_t max_fds = nullptr != num_fds ? *num_fds : 0;
+            std::vector<char> control(CMSG_SPACE((0 != max_fds ? max_fds : 1) * sizeof(int)));
+            header.msg_control = control.data();
+            header.msg_controllen = control.size();
+
+            ssize_t result;
+            do result = ::recvmsg(socket, &header, MSG_CMSG_CLOEXEC); while (-1 == result && EINTR == errno);
+            if (nullptr != num_fds) *num_fds = 0;
+            if (result <= 0) return false;
+            message.resize((size_t)result);
+
+            for (auto cmsg = CMSG_FIRSTHDR(&header); nullptr != cmsg; cmsg = CMSG_NXTHDR(&header, cmsg))
+            {
+                if (SOL_SOCKET != cmsg->cmsg_level || SCM_RIGHTS != cmsg->cmsg_type) continue;
+                const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (size_t i = 0; i != count; ++i)
+                {
+                    int fd;
+                    std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                    if (nullptr != num_fds && *num_fds < max_fds) fds[(*num_fds)++] = fd;
+                    else ::close(fd);
+                }
+            }
+
+            // a truncated message is an error
+            return 0 == (header.msg_flags & (MSG_TRUNC | MSG_CTRUNC));
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_IPC_H
+#define NVNMOS_IPC_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Protocol between the nvnmosd daemon and the nvnmos-client library
+// Control requests and replies are single messages on a UNIX domain SOCK_SEQPACKET socket, and events from the daemon
+// are delivered via a single-producer single-consumer ring in shared memory, whose file descriptor is passed to the
+// client in the reply to its hello request, along with an eventfd which is signalled when events are written
+namespace nvnmos
+{
+    namespace ipc
+    {
+        const char* const default_socket_path = "/run/nvnmosd.sock";
+
+        const uint32_t version = 1;
+
+        // the maximum size of a request or reply message, including the header
+        const size_t max_message_size = 65536;
+
+        enum class request_type : uint32_t
+        {
+            // payload is the client name, which identifies the owner of senders and receivers across client restarts
+            hello = 1,
+            // payload is the SDP data
+            add_receiver,
+            add_sender,
+            // payload is the internal id
+            remove_receiver,
+            remove_sender
+        };
+
+        struct request_header
+        {
+            uint32_t version;
+            request_type type;
+        };
+
+        // status values are those of NvNmosStatus
+        struct reply
+        {
+            int32_t status;
+        };
+
+        enum class event_type : uint32_t
+        {
+            // the SDP data is empty when the sender or receiver has been deactivated
+            activation = 1,
+            link_state
+        };
+
+        // each slot of the ring holds an event header followed by the internal id and SDP data, without terminators
+        struct event_header
+        {
+            event_type type;
+            uint32_t leg;
+            uint32_t up;
+            uint32_t id_size;
+            uint32_t sdp_size;
+        };
+
+        // the std::atomic members are used by two processes, so they must not require a lock
+        static_assert(2 == ATOMIC_LLONG_LOCK_FREE, "64-bit atomics must be lock-free to be shared between processes");
+
+        struct ring_header
+        {
+            uint32_t version;
+            uint32_t slot_count; // power of two
+            uint32_t slot_size;
+
+            // written by the daemon
+            alignas(64) std::atomic<uint64_t> head;
+            // written by the client
+            alignas(64) std::atomic<uint64_t> tail;
+
+            // statistics, written by the daemon
+            alignas(64) std::atomic<uint64_t> events_written;
+            std::atomic<uint64_t> events_dropped;
+
+            // data plane liveness, incremented by the client
+            alignas(64) std::atomic<uint64_t> alive;
+        };
+
+        inline size_t ring_size(uint32_t slot_count, uint32_t slot_size)
+        {
+            return sizeof(ring_header) + (size_t)slot_count * slot_size;
+        }
+
+        inline char* ring_slot(ring_header* ring, uint64_t position)
+        {
+            return (char*)(ring + 1) + (size_t)(position & (ring->slot_count - 1)) * ring->slot_size;
+        }
+
+        // send a message, with optional file descriptors, returning false on error
+        bool send_message(int socket, const std::string& message, const int* fds = nullptr, size_t num_fds = 0);
+
+        // receive a message, with optional file descriptors, returning false on error or if the peer has disconnected
+        // the number of file descriptors is updated to the number received
+        bool receive_message(int socket, std::string& message, int* fds = nullptr, size_t* num_fds = nullptr);
+    }
+}
+
+#endif
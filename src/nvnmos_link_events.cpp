@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_link_events.h"
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <system_error>
+#include "cpprest/asyncrt_utils.h"
+
+namespace nvnmos
+{
+#ifdef __linux__
+    namespace details
+    {
+        // rtnetlink socket subscribed to link and IPv4/IPv6 address notifications
+        class netlink_event_source : public link_event_source
+        {
+        public:
+            netlink_event_source()
+                : fd(::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE))
+            {
+                if (-1 == fd) throw std::system_error(errno, std::generic_category(), "netlink socket");
+
+                sockaddr_nl address{};
+                address.nl_family = AF_NETLINK;
+                address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+                if (-1 == ::bind(fd, (sockaddr*)&address, sizeof(address)))
+                {
+                    const auto error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(), "netlink bind");
+                }
+            }
+
+            ~netlink_event_source() override
+            {
+                ::close(fd);
+            }
+
+            std::vector<link_event> wait_for(std::chrono::milliseconds timeout) override
+            {
+                std::vector<link_event> events;
+
+                pollfd pfd{ fd, POLLIN, 0 };
+                int wait_ms = (int)timeout.count();
+                // once the first message has arrived, collect any others that are immediately available
+                while (0 < ::poll(&pfd, 1, wait_ms) && 0 != (pfd.revents & POLLIN))
+                {
+                    wait_ms = 0;
+
+                    const auto size = ::recv(fd, buffer, sizeof(buffer), 0);
+                    if (size <= 0) break;
+
+                    auto remaining = (unsigned int)size;
+                    for (auto header = (const nlmsghdr*)buffer; NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining))
+                    {
+                        if (RTM_NEWLINK == header->nlmsg_type || RTM_DELLINK == header->nlmsg_type)
+                        {
+                            const auto info = (const ifinfomsg*)NLMSG_DATA(header);
+                            const bool up = RTM_NEWLINK == header->nlmsg_type && 0 != (info->ifi_flags & IFF_RUNNING);
+                            auto name = get_link_name(header, info);
+                            if (!name.empty()) events.push_back({ utility::conversions::to_string_t(name), up, false });
+                        }
+                        else if (RTM_NEWADDR == header->nlmsg_type || RTM_DELADDR == header->nlmsg_type)
+                        {
+                            const auto info = (const ifaddrmsg*)NLMSG_DATA(header);
+                            char name[IF_NAMESIZE] = {};
+                            if (0 != ::if_indextoname(info->ifa_index, name)) events.push_back({ utility::conversions::to_string_t(std::string(name)), true, true });
+                        }
+                    }
+                }
+
+                return events;
+            }
+
+            int poll_fd() const override
+            {
+                return fd;
+            }
+
+        private:
+            static std::string get_link_name(const nlmsghdr* header, const ifinfomsg* info)
+            {
+                auto length = (int)IFLA_PAYLOAD(header);
+                for (auto attribute = IFLA_RTA(info); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length))
+                {
+                    if (IFLA_IFNAME == attribute->rta_type) return (const char*)RTA_DATA(attribute);
+                }
+                return{};
+            }
+
+            int fd;
+            alignas(nlmsghdr) char buffer[16384];
+        };
+    }
+#endif
+
+    // This constructs a source of link events from rtnetlink, or returns null if that isn't supported on this platform
+    std::unique_ptr<link_event_source> make_netlink_event_source()
+    {
+#ifdef __linux__
+        return std::unique_ptr<link_event_source>(new details::netlink_event_source());
+#else
+        return{};
+#endif
+    }
+
+    void fake_link_event_source::push(link_event event)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.push_back(std::move(event));
+        }
+        condition.notify_all();
+    }
+
+    std::vector<link_event> fake_link_event_source::wait_for(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait_for(lock, timeout, [&] { return !events.empty(); });
+        std::vector<link_event> result;
+        result.swap(events);
+        return result;
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_LINK_EVENTS_H
+#define NVNMOS_LINK_EVENTS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "cpprest/details/basic_types.h"
+
+namespace nvnmos
+{
+    // A change in the state of a network interface
+    struct link_event
+    {
+        utility::string_t name;
+        // whether the link is up, i.e. operational; for an address change, the last known state is unchanged
+        bool up;
+        // whether this is an address change rather than a link state change
+        bool address_changed;
+    };
+
+    // A source of network interface link and address events
+    class link_event_source
+    {
+    public:
+        virtual ~link_event_source() {}
+
+        // wait up to the specified timeout for events, returning all that are available, or none if the timeout expires
+        virtual std::vector<link_event> wait_for(std::chrono::milliseconds timeout) = 0;
+
+        // get a file descriptor which is readable when events are available, or -1 if there isn't one
+        virtual int poll_fd() const { return -1; }
+    };
+
+    // This constructs a source of link events from rtnetlink, or returns null if that isn't supported on this platform
+    std::unique_ptr<link_event_source> make_netlink_event_source();
+
+    // A source of link events which are pushed by the application, e.g. for testing without changing any real interfaces,
+    // see nmos_link_state_event
+    class fake_link_event_source : public link_event_source
+    {
+    public:
+        void push(link_event event);
+
+        std::vector<link_event> wait_for(std::chrono::milliseconds timeout) override;
+
+    private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<link_event> events;
+    };
+}
+
+#endif
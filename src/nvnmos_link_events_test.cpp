@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This drives a link going down and coming up again through the application link events,
+// and checks that the affected leg of a sender on the loopback interface is notified each time
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "nvnmos_test_fixture.h"
+
+namespace
+{
+    struct leg_state
+    {
+        std::string id;
+        unsigned int leg;
+        bool up;
+    };
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<leg_state> changes;
+
+    void handle_link_state_changed(NvNmosNodeServer* server, const char* id, unsigned int leg, bool up)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        changes.push_back({ id, leg, up });
+        condition.notify_all();
+    }
+
+    // wait for the specified number of link state changes, returning false if they don't all arrive in time
+    bool wait_for_changes(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return condition.wait_for(lock, std::chrono::seconds(5), [&] { return changes.size() >= count; });
+    }
+
+    bool check_change(size_t index, bool up)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (changes.size() <= index) return false;
+        const auto& change = changes[index];
+        if ("sender-0" == change.id && 0 == change.leg && up == change.up) return true;
+        std::fprintf(stderr, "Unexpected link state change: %s leg %u is %s\n", change.id.c_str(), change.leg, change.up ? "up" : "down");
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* host_addresses[1] = { "127.0.0.1" };
+
+    auto discovery_config = nvnmos::test::make_discovery_config();
+
+    const auto sender_sdp = nvnmos::test::make_sdp("sender-0", nvnmos::test::make_multicast_address(0), true);
+
+    NvNmosSenderConfig sender_config{};
+    sender_config.sdp = sender_sdp.c_str();
+
+    NvNmosNodeConfig node_config{};
+    node_config.host_name = "nvnmos-link-events-test.local";
+    node_config.host_addresses = host_addresses;
+    node_config.num_host_addresses = 1;
+    node_config.http_port = argc > 1 ? std::atoi(argv[1]) : 18280;
+    node_config.discovery = &discovery_config;
+    node_config.seed = "nvnmos-link-events-test";
+    node_config.senders = &sender_config;
+    node_config.num_senders = 1;
+    node_config.monitor_links = true;
+    node_config.application_link_events = true;
+    node_config.link_state_changed = &handle_link_state_changed;
+    node_config.log_callback = &nvnmos::test::handle_log;
+    node_config.log_level = NVNMOS_LOG_ERROR;
+
+    NvNmosNodeServer node_server{};
+    if (!create_nmos_node_server(&node_config, &node_server)) return 1;
+
+    bool success =
+        // the loopback interface's link goes down
+        nmos_link_state_event(&node_server, "lo", false)
+        && wait_for_changes(1)
+        && check_change(0, false)
+        // an event which doesn't change the link state is ignored
+        && nmos_link_state_event(&node_server, "lo", false)
+        // the link comes up again
+        && nmos_link_state_event(&node_server, "lo", true)
+        && wait_for_changes(2)
+        && check_change(1, true)
+        // an interface which isn't bound to any sender or receiver doesn't affect any legs
+        && nmos_link_state_event(&node_server, "nvnmos-test0", false)
+        && !wait_for_changes(3);
+
+    if (!destroy_nmos_node_server(&node_server)) return 1;
+
+    std::fprintf(stderr, "%s\n", success ? "Passed" : "Failed");
+    return success ? 0 : 1;
+}
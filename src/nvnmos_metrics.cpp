@@ -0,0 +1,251 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_metrics.h"
+
+#include <algorithm>
+#include <cctype>
+#include "nmos/api_utils.h"
+#include "nmos/server.h"
+
+namespace nvnmos
+{
+    const std::array<double, http_metrics::num_bucket_bounds> http_metrics::bucket_bounds{ { 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0 } };
+
+    namespace details
+    {
+        const std::array<utility::string_t, http_metrics::num_methods> methods{ { U("GET"), U("HEAD"), U("OPTIONS"), U("POST"), U("PUT"), U("PATCH"), U("DELETE") } };
+
+        size_t find_method(const utility::string_t& method)
+        {
+            return std::find(methods.begin(), methods.end(), method) - methods.begin();
+        }
+
+        // find the next non-empty segment of the path, from begin, returning false if there are no more
+        bool next_segment(const utility::string_t& path, size_t& begin, size_t& end)
+        {
+            while (begin < path.size() && U('/') == path[begin]) ++begin;
+            if (path.size() == begin) return false;
+            end = path.find(U('/'), begin);
+            if (utility::string_t::npos == end) end = path.size();
+            return true;
+        }
+
+        bool is_resource_id(const utility::string_t& path, size_t begin, size_t end)
+        {
+            // e.g. "3f2c1b0a-9d8e-4c7b-a6f5-e4d3c2b1a090"
+            if (36 != end - begin) return false;
+            for (size_t i = 0; i < end - begin; ++i)
+            {
+                const auto c = path[begin + i];
+                const bool hyphen = 8 == i || 13 == i || 18 == i || 23 == i;
+                if (hyphen ? U('-') != c : !std::isxdigit((int)c)) return false;
+            }
+            return true;
+        }
+
+        bool is_api_version(const utility::string_t& path, size_t begin, size_t end)
+        {
+            // e.g. "v1.3"
+            size_t i = begin;
+            if (i == end || U('v') != path[i++]) return false;
+            size_t major_digits = 0, minor_digits = 0, dots = 0;
+            for (; i < end; ++i)
+            {
+                const auto c = path[i];
+                if (U('.') == c) ++dots;
+                else if (!std::isdigit((int)c)) return false;
+                else ++(0 == dots ? major_digits : minor_digits);
+            }
+            return 1 == dots && 0 != major_digits && 0 != minor_digits;
+        }
+
+        bool match_segment(const utility::string_t& path, size_t begin, size_t end, const utility::string_t& segment)
+        {
+            if (U("{id}") == segment) return is_resource_id(path, begin, end);
+            if (U("{version}") == segment) return is_api_version(path, begin, end);
+            return 0 == path.compare(begin, end - begin, segment);
+        }
+
+        // the route templates of the APIs served by the node
+        std::vector<utility::string_t> make_route_templates()
+        {
+            std::vector<utility::string_t> result{ U("/"), U("/x-nmos") };
+
+            const utility::string_t node_api(U("/x-nmos/node/{version}"));
+            result.insert(result.end(), { U("/x-nmos/node"), node_api, node_api + U("/self") });
+            for (const auto& resources : { U("devices"), U("sources"), U("flows"), U("senders"), U("receivers") })
+            {
+                result.push_back(node_api + U("/") + resources);
+                result.push_back(node_api + U("/") + resources + U("/{id}"));
+            }
+            result.push_back(node_api + U("/receivers/{id}/target"));
+
+            const utility::string_t connection_api(U("/x-nmos/connection/{version}"));
+            result.insert(result.end(), { U("/x-nmos/connection"), connection_api, connection_api + U("/bulk"), connection_api + U("/single") });
+            for (const auto& resources : { U("senders"), U("receivers") })
+            {
+                result.push_back(connection_api + U("/bulk/") + resources);
+                result.push_back(connection_api + U("/single/") + resources);
+                result.push_back(connection_api + U("/single/") + resources + U("/{id}"));
+                for (const auto& endpoint : { U("constraints"), U("staged"), U("active"), U("transporttype") })
+                {
+                    result.push_back(connection_api + U("/single/") + resources + U("/{id}/") + endpoint);
+                }
+            }
+            result.push_back(connection_api + U("/single/senders/{id}/transportfile"));
+
+            result.insert(result.end(), { U("/settings"), U("/settings/all"), U("/log"), U("/log/events") });
+
+            result.insert(result.end(), { U("/x-nvnmos/transportfile/{id}"), U("/x-nvnmos/state"), U("/x-nvnmos/metrics"), U("/healthz"), U("/readyz") });
+
+            return result;
+        }
+    }
+
+    // pre-register the route templates, e.g. "/x-nmos/node/{version}/senders/{id}", whose requests are counted separately;
+    // requests to any other path, and any requests that are not found, are counted together as method "*" and route "*"
+    // this must be called before any requests are recorded, since the routes are not locked
+    void http_metrics::register_routes(const std::vector<utility::string_t>& route_templates)
+    {
+        for (const auto& route_template : route_templates)
+        {
+            route registered;
+            registered.route_template = route_template;
+            size_t begin = 0, end = 0;
+            for (; details::next_segment(route_template, begin, end); begin = end)
+            {
+                registered.segments.push_back(route_template.substr(begin, end - begin));
+            }
+            registered.stats.reset(new route_stats[num_methods * num_status_classes]);
+            routes.push_back(std::move(registered));
+        }
+    }
+
+    const http_metrics::route* http_metrics::find_route(const utility::string_t& path) const
+    {
+        for (const auto& route : routes)
+        {
+            size_t begin = 0, end = 0, index = 0;
+            bool matched = true;
+            for (; matched && details::next_segment(path, begin, end); begin = end, ++index)
+            {
+                matched = index < route.segments.size() && details::match_segment(path, begin, end, route.segments[index]);
+            }
+            if (matched && route.segments.size() == index) return &route;
+        }
+        return nullptr;
+    }
+
+    // record a completed request, without taking a lock or allocating memory
+    void http_metrics::record(const utility::string_t& method, const utility::string_t& path, web::http::status_code status, std::chrono::steady_clock::duration latency)
+    {
+        const auto status_class = (size_t)(std::min)((std::max)((int)status / 100, 1), (int)num_status_classes) - 1;
+        const auto method_index = details::find_method(method);
+        const auto found = num_methods != method_index && web::http::status_codes::NotFound != status ? find_route(path) : nullptr;
+        auto& stats = found ? found->stats[method_index * num_status_classes + status_class] : unmatched[status_class];
+
+        const auto seconds = std::chrono::duration<double>(latency).count();
+        const auto bucket = std::lower_bound(bucket_bounds.begin(), bucket_bounds.end(), seconds) - bucket_bounds.begin();
+
+        stats.count.fetch_add(1, std::memory_order_relaxed);
+        stats.sum_us.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), std::memory_order_relaxed);
+        stats.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    web::json::value http_metrics::to_json() const
+    {
+        auto bounds = web::json::value::array();
+        for (auto bound : bucket_bounds) web::json::push_back(bounds, bound);
+
+        auto json_routes = web::json::value::array();
+        auto add_route = [&json_routes](const utility::string_t& method, const utility::string_t& route_template, size_t status_class, const route_stats& stats)
+        {
+            const auto count = stats.count.load(std::memory_order_relaxed);
+            if (0 == count) return;
+
+            auto buckets = web::json::value::array();
+            for (const auto& bucket : stats.buckets) web::json::push_back(buckets, bucket.load(std::memory_order_relaxed));
+
+            web::json::push_back(json_routes, web::json::value_of({
+                { U("method"), method },
+                { U("route"), route_template },
+                { U("status"), utility::string_t(1, (utility::char_t)(U('1') + status_class)) + U("xx") },
+                { U("count"), count },
+                { U("sum"), stats.sum_us.load(std::memory_order_relaxed) / 1e6 },
+                { U("buckets"), buckets }
+            }, true));
+        };
+
+        for (const auto& route : routes)
+        {
+            for (size_t method_index = 0; method_index < num_methods; ++method_index)
+            {
+                for (size_t status_class = 0; status_class < num_status_classes; ++status_class)
+                {
+                    add_route(details::methods[method_index], route.route_template, status_class, route.stats[method_index * num_status_classes + status_class]);
+                }
+            }
+        }
+        for (size_t status_class = 0; status_class < num_status_classes; ++status_class)
+        {
+            add_route(U("*"), U("*"), status_class, unmatched[status_class]);
+        }
+
+        return web::json::value_of({
+            { U("bucket_bounds"), bounds },
+            { U("routes"), json_routes }
+        }, true);
+    }
+
+    // This instruments each of the server's API routers to record the requests it handles, so it must be called
+    // after all the routes have been added, and before the server is opened
+    void instrument_api_routers(nmos::server& server, http_metrics& metrics)
+    {
+        using namespace web::http::experimental::listener::api_router_using_declarations;
+
+        metrics.register_routes(details::make_route_templates());
+
+        for (auto& api_router : server.api_routers)
+        {
+            web::http::experimental::listener::api_router instrumented;
+
+            // the latency is measured until the response has been sent, however the routes handle the request
+            instrumented.support(U(".*"), [&metrics](http_request req, http_response res, const string_t&, const route_parameters&)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const auto method = req.method();
+                const auto path = req.relative_uri().path();
+                req.get_response().then([&metrics, start, method, path](pplx::task<http_response> finished)
+                {
+                    try
+                    {
+                        metrics.record(method, path, finished.get().status_code(), std::chrono::steady_clock::now() - start);
+                    }
+                    catch (...)
+                    {
+                        // the response was not sent
+                    }
+                });
+                return pplx::task_from_result(true);
+            });
+            instrumented.mount({}, api_router.second);
+
+            api_router.second = std::move(instrumented);
+        }
+    }
+}
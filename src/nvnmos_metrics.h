@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_METRICS_H
+#define NVNMOS_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "cpprest/api_router.h"
+
+namespace nmos
+{
+    struct server;
+}
+
+namespace nvnmos
+{
+    // Source of the metrics for the /x-nvnmos/metrics endpoint and the C API
+    typedef std::function<web::json::value()> metrics_provider;
+
+    // Counters and latency histograms of HTTP requests, per method, route template and status class
+    class http_metrics
+    {
+    public:
+        // upper bounds of the latency histogram buckets, in seconds, with a final bucket for anything slower
+        static const size_t num_bucket_bounds = 13;
+        static const std::array<double, num_bucket_bounds> bucket_bounds;
+
+        // pre-register the route templates, e.g. "/x-nmos/node/{version}/senders/{id}", whose requests are counted separately;
+        // requests to any other path, and any requests that are not found, are counted together as method "*" and route "*"
+        // this must be called before any requests are recorded, since the routes are not locked
+        void register_routes(const std::vector<utility::string_t>& route_templates);
+
+        // record a completed request, without taking a lock or allocating memory
+        void record(const utility::string_t& method, const utility::string_t& path, web::http::status_code status, std::chrono::steady_clock::duration latency);
+
+        web::json::value to_json() const;
+
+        // the methods that are counted separately, and the status classes, "1xx" to "5xx"
+        static const size_t num_methods = 7;
+        static const size_t num_status_classes = 5;
+
+    private:
+        struct route_stats
+        {
+            std::atomic<uint64_t> count{ 0 };
+            std::atomic<uint64_t> sum_us{ 0 };
+            std::array<std::atomic<uint64_t>, num_bucket_bounds + 1> buckets;
+
+            route_stats() { for (auto& bucket : buckets) bucket = 0; }
+        };
+
+        struct route
+        {
+            utility::string_t route_template;
+            std::vector<utility::string_t> segments;
+            // indexed by method and status class
+            std::unique_ptr<route_stats[]> stats;
+        };
+
+        const route* find_route(const utility::string_t& path) const;
+
+        std::vector<route> routes;
+        // indexed by status class
+        std::array<route_stats, num_status_classes> unmatched;
+    };
+
+    // This instruments each of the server's API routers to record the requests it handles, so it must be called
+    // after all the routes have been added, and before the server is opened
+    void instrument_api_routers(nmos::server& server, http_metrics& metrics);
+}
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_ptp_status.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include "cpprest/json_utils.h"
+
+namespace nvnmos
+{
+#ifdef __linux__
+    namespace details
+    {
+        // PTP management messages, see IEEE 1588-2008 Clause 15
+        namespace management
+        {
+            const uint8_t message_type = 0x0d;
+            const uint8_t control_field = 0x04;
+            const uint8_t get = 0x00;
+            const uint8_t response = 0x02;
+            const uint16_t management_tlv = 0x0001;
+
+            const uint16_t default_data_set = 0x2000;
+            const uint16_t parent_data_set = 0x2002;
+            const uint16_t time_properties_data_set = 0x2003;
+            const uint16_t port_data_set = 0x2004;
+
+            const uint8_t port_state_slave = 9;
+            const uint8_t time_traceable = 0x10;
+
+            // header (34 octets), targetPortIdentity (10), boundary hops (2), action (2), TLV type and length (4)
+            const std::size_t tlv_offset = 48;
+        }
+
+        inline void put16(uint8_t* p, uint16_t value) { p[0] = uint8_t(value >> 8); p[1] = uint8_t(value); }
+        inline uint16_t get16(const uint8_t* p) { return uint16_t(p[0] << 8 | p[1]); }
+
+        // format a clockIdentity as per IS-04, e.g. "ac-de-48-23-45-67-01-9f"
+        inline utility::string_t make_gmid(const uint8_t* identity)
+        {
+            utility::ostringstream_t gmid;
+            gmid << std::hex << std::setfill(U('0'));
+            for (int i = 0; i < 8; ++i)
+            {
+                if (0 != i) gmid << U('-');
+                gmid << std::setw(2) << (int)identity[i];
+            }
+            return gmid.str();
+        }
+
+        // queries ptp4l like 'pmc -u', one GET per data set
+        class pmc_status_source : public ptp_status_source
+        {
+        public:
+            pmc_status_source(const std::string& uds_address, int domain)
+                : fd(::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0))
+                , domain(domain)
+                , sequence_id(0)
+            {
+                if (-1 == fd) throw std::system_error(errno, std::generic_category(), "pmc socket");
+
+                // bind to an abstract address, so that there is no file to clean up, for ptp4l to respond to
+                static std::atomic<unsigned int> instance{ 0 };
+                const auto name = "nvnmos-pmc." + std::to_string(::getpid()) + "." + std::to_string(instance++);
+                sockaddr_un local{};
+                local.sun_family = AF_UNIX;
+                std::memcpy(local.sun_path + 1, name.data(), (std::min)(name.size(), sizeof(local.sun_path) - 1));
+                if (-1 == ::bind(fd, (sockaddr*)&local, socklen_t(offsetof(sockaddr_un, sun_path) + 1 + name.size())))
+                {
+                    const auto error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(), "pmc bind");
+                }
+
+                remote.sun_family = AF_UNIX;
+                std::strncpy(remote.sun_path, uds_address.c_str(), sizeof(remote.sun_path) - 1);
+            }
+
+            ~pmc_status_source() override
+            {
+                ::close(fd);
+            }
+
+            bool get(ptp_status& status) override
+            {
+                if (!request()) return false;
+
+                // the data sets are queried together, so this only waits for a single round trip
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+                for (;;)
+                {
+                    if (receive(status)) return true;
+                    if (failed) return false;
+
+                    const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                    pollfd pfd{ fd, POLLIN, 0 };
+                    if (timeout <= 0 || ::poll(&pfd, 1, (int)timeout) <= 0) return false;
+                }
+            }
+
+            int poll_fd() const override { return fd; }
+
+            bool request() override
+            {
+                first_sequence_id = sequence_id;
+                received = 0;
+                failed = false;
+
+                for (const auto management_id : management_ids)
+                {
+                    if (!send(management_id)) return false;
+                }
+                return true;
+            }
+
+            bool receive(ptp_status& status) override
+            {
+                for (;;)
+                {
+                    uint8_t response[1500];
+                    const auto size = ::recv(fd, response, sizeof(response), MSG_DONTWAIT);
+                    if (size < 0) break;
+                    if (size < (ssize_t)management::tlv_offset + 6) continue;
+
+                    // ignore stale responses to earlier requests
+                    if (management::message_type != (response[0] & 0x0f)) continue;
+                    const uint16_t index = uint16_t(get16(response + 30) - first_sequence_id);
+                    if (num_management_ids <= index || 0 != (received & (1u << index))) continue;
+                    if (management::response != (response[46] & 0x0f)) continue;
+
+                    // e.g. MANAGEMENT_ERROR_STATUS
+                    const auto length = get16(response + 50);
+                    if (management::management_tlv != get16(response + 48)
+                        || management_ids[index] != get16(response + 52)
+                        || length < 2 || management::tlv_offset + 4 + length > (std::size_t)size
+                        || !parse(management_ids[index], response + management::tlv_offset + 6, length - 2))
+                    {
+                        failed = true;
+                        continue;
+                    }
+
+                    received |= 1u << index;
+                }
+
+                if (failed || (1u << num_management_ids) - 1 != received) return false;
+
+                // only report the status once for each request
+                received = 0;
+                status = partial;
+                return true;
+            }
+
+        private:
+            static const std::size_t num_management_ids = 4;
+            static const uint16_t management_ids[num_management_ids];
+
+            bool send(uint16_t management_id)
+            {
+                const uint16_t sequence = sequence_id++;
+
+                uint8_t request[management::tlv_offset + 6] = {};
+                request[0] = management::message_type;
+                request[1] = 2; // versionPTP
+                put16(request + 2, sizeof(request));
+                request[4] = (uint8_t)domain;
+                put16(request + 30, sequence);
+                request[32] = management::control_field;
+                request[33] = 0x7f; // logMessageInterval
+                std::memset(request + 34, 0xff, 10); // wildcard targetPortIdentity
+                request[46] = management::get;
+                put16(request + 48, management::management_tlv);
+                put16(request + 50, 2); // managementId only
+                put16(request + 52, management_id);
+
+                return (ssize_t)sizeof(request) == ::sendto(fd, request, sizeof(request), 0, (const sockaddr*)&remote, sizeof(remote));
+            }
+
+            // set the relevant fields of the status from a data set, returning false if it is too short
+            bool parse(uint16_t management_id, const uint8_t* data, std::size_t size)
+            {
+                switch (management_id)
+                {
+                case management::default_data_set:
+                    // domainNumber follows flags, numberPorts, priority1, clockQuality, priority2 and clockIdentity
+                    if (size < 19) return false;
+                    partial.domain = data[18];
+                    return true;
+                case management::parent_data_set:
+                    // grandmasterIdentity follows parentPortIdentity, PS, observedParentOffsetScaledLogVariance,
+                    // observedParentClockPhaseChangeRate, grandmasterPriority1, grandmasterClockQuality and grandmasterPriority2
+                    if (size < 32) return false;
+                    partial.gmid = make_gmid(&data[24]);
+                    return true;
+                case management::time_properties_data_set:
+                    // flags follow currentUtcOffset
+                    if (size < 3) return false;
+                    partial.traceable = 0 != (data[2] & management::time_traceable);
+                    return true;
+                case management::port_data_set:
+                    // portState follows portIdentity
+                    if (size < 11) return false;
+                    partial.locked = management::port_state_slave == data[10];
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            int fd;
+            int domain;
+            uint16_t sequence_id;
+            sockaddr_un remote{};
+
+            // the state of the last request
+            uint16_t first_sequence_id = 0;
+            unsigned int received = 0;
+            bool failed = false;
+            ptp_status partial;
+        };
+
+        const uint16_t pmc_status_source::management_ids[pmc_status_source::num_management_ids] =
+        {
+            management::default_data_set,
+            management::parent_data_set,
+            management::time_properties_data_set,
+            management::port_data_set
+        };
+    }
+#endif
+
+    namespace details
+    {
+        class file_status_source : public ptp_status_source
+        {
+        public:
+            explicit file_status_source(std::string path) : path(std::move(path)) {}
+
+            bool get(ptp_status& status) override
+            {
+                std::ifstream file(path);
+                if (!file) return false;
+
+                try
+                {
+                    std::stringstream text;
+                    text << file.rdbuf();
+                    const auto json = web::json::value::parse(utility::conversions::to_string_t(text.str()));
+
+                    status.gmid = web::json::field_as_string_or{ U("gmid"), U("") }(json);
+                    status.domain = web::json::field_as_integer_or{ U("domain"), 0 }(json);
+                    status.locked = web::json::field_as_bool_or{ U("locked"), false }(json);
+                    status.traceable = web::json::field_as_bool_or{ U("traceable"), false }(json);
+                    return true;
+                }
+                catch (const web::json::json_exception&)
+                {
+                    // e.g. the file is being rewritten
+                    return false;
+                }
+            }
+
+        private:
+            std::string path;
+        };
+    }
+
+    // This constructs a source which queries a linuxptp ptp4l instance using PTP management messages over its UNIX domain socket,
+    // like 'pmc -u', or returns null if that isn't supported on this platform
+    std::unique_ptr<ptp_status_source> make_pmc_status_source(const std::string& uds_address, int domain)
+    {
+#ifdef __linux__
+        return std::unique_ptr<ptp_status_source>(new details::pmc_status_source(uds_address, domain));
+#else
+        return{};
+#endif
+    }
+
+    // This constructs a source which reads a JSON file
+    std::unique_ptr<ptp_status_source> make_file_status_source(const std::string& path)
+    {
+        return std::unique_ptr<ptp_status_source>(new details::file_status_source(path));
+    }
+
+    // This constructs the source specified by a path, using the file source if it has the prefix "file:" and the pmc source otherwise
+    std::unique_ptr<ptp_status_source> make_ptp_status_source(const std::string& path, int domain)
+    {
+        static const std::string file_prefix{ "file:" };
+        if (0 == path.compare(0, file_prefix.size(), file_prefix))
+        {
+            return make_file_status_source(path.substr(file_prefix.size()));
+        }
+        return make_pmc_status_source(path, domain);
+    }
+}
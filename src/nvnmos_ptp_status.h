@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_PTP_STATUS_H
+#define NVNMOS_PTP_STATUS_H
+
+#include <memory>
+#include <string>
+#include "cpprest/details/basic_types.h"
+
+namespace nvnmos
+{
+    // The status of the local PTP instance, as required for the node's clock
+    struct ptp_status
+    {
+        // grandmaster identity, formatted as per IS-04, e.g. "ac-de-48-23-45-67-01-9f"
+        utility::string_t gmid;
+        int domain = 0;
+        bool locked = false;
+        bool traceable = false;
+
+        bool operator==(const ptp_status& other) const
+        {
+            return gmid == other.gmid && domain == other.domain && locked == other.locked && traceable == other.traceable;
+        }
+        bool operator!=(const ptp_status& other) const { return !(*this == other); }
+    };
+
+    // A source of the PTP status, which is polled
+    class ptp_status_source
+    {
+    public:
+        virtual ~ptp_status_source() {}
+
+        // get the current status, returning false if it is not available
+        // this may block while the status is queried, so a source with a file descriptor can also be queried in two steps
+        virtual bool get(ptp_status& status) = 0;
+
+        // get a file descriptor which is readable when responses to a request are available, or -1 if there isn't one
+        virtual int poll_fd() const { return -1; }
+
+        // send a request for the current status without waiting for the responses, returning false if it could not be sent
+        virtual bool request() { return false; }
+
+        // read any available responses without waiting, returning true once all the responses to the last request have been read
+        virtual bool receive(ptp_status& status) { return false; }
+    };
+
+    // This constructs a source which queries a linuxptp ptp4l instance using PTP management messages over its UNIX domain socket,
+    // like 'pmc -u', or returns null if that isn't supported on this platform
+    std::unique_ptr<ptp_status_source> make_pmc_status_source(const std::string& uds_address, int domain);
+
+    // This constructs a source which reads a JSON file, e.g. {"gmid": "ac-de-48-23-45-67-01-9f", "domain": 0, "locked": true, "traceable": false},
+    // which can be written by other tools or tests
+    std::unique_ptr<ptp_status_source> make_file_status_source(const std::string& path);
+
+    // This constructs the source specified by a path, using the file source if it has the prefix "file:" and the pmc source otherwise
+    std::unique_ptr<ptp_status_source> make_ptp_status_source(const std::string& path, int domain);
+}
+
+#endif
@@ -0,0 +1,273 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_query_cache.h"
+
+#include <atomic>
+#include "cpprest/http_client.h"
+#include "cpprest/ws_client.h"
+#include "nmos/client_utils.h"
+#include "nmos/json_fields.h"
+#include "nmos/model.h"
+#include "nmos/slog.h"
+#include "nmos/transport.h"
+#include "nvnmos_impl.h"
+
+namespace nvnmos
+{
+    // get the transport file of the specified remote sender, or an empty string if it isn't (yet) known
+    utility::string_t query_cache::find_transportfile(const utility::string_t& sender_id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = senders.find(sender_id);
+        return senders.end() != found ? found->second.transportfile : utility::string_t{};
+    }
+
+    // apply the "pre"/"post" events of a Query API WebSocket data grain
+    void query_cache::apply_grain(const web::json::value& message)
+    {
+        // see https://specs.amwa.tv/is-04/releases/v1.3.2/docs/Query_API.html#websockets
+        const auto& grain = message.at(U("grain"));
+        const auto& events = grain.at(U("data"));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& event : events.as_array())
+        {
+            const auto& id = event.at(U("path")).as_string();
+            if (!event.has_field(U("post")) || event.at(U("post")).is_null())
+            {
+                // resource removed
+                senders.erase(id);
+                continue;
+            }
+
+            const auto& post = event.at(U("post"));
+            const auto& version = nmos::fields::version(post);
+            const auto& manifest_href_or_null = nmos::fields::manifest_href(post);
+            const auto is_rtp = nmos::transports::rtp == nmos::transport_base(nmos::transport{ nmos::fields::transport(post) });
+            const auto manifest_href = is_rtp && manifest_href_or_null.is_string() ? manifest_href_or_null.as_string() : utility::string_t{};
+
+            auto& sender = senders[id];
+            if (sender.version == version) continue;
+
+            // the transport file may have changed along with any other property of the sender
+            sender.version = version;
+            sender.manifest_href = manifest_href;
+            sender.transportfile.clear();
+
+            if (!manifest_href.empty()) fetches.push_back(id);
+        }
+    }
+
+    // forget all remote senders, e.g. when the subscription is lost
+    void query_cache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        senders.clear();
+        fetches.clear();
+    }
+
+    // get a sender whose transport file needs to be fetched, returning false if there are none
+    bool query_cache::next_fetch(utility::string_t& sender_id, utility::string_t& version, utility::string_t& manifest_href)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!fetches.empty())
+        {
+            sender_id = fetches.front();
+            fetches.pop_front();
+
+            auto found = senders.find(sender_id);
+            if (senders.end() == found || !found->second.transportfile.empty() || found->second.manifest_href.empty()) continue;
+
+            version = found->second.version;
+            manifest_href = found->second.manifest_href;
+            return true;
+        }
+        return false;
+    }
+
+    bool query_cache::has_fetch() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !fetches.empty();
+    }
+
+    // set the fetched transport file, unless the sender has changed or been removed in the meantime
+    void query_cache::set_transportfile(const utility::string_t& sender_id, const utility::string_t& version, const utility::string_t& transportfile)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = senders.find(sender_id);
+        if (senders.end() == found || found->second.version != version) return;
+        found->second.transportfile = transportfile;
+    }
+
+    namespace details
+    {
+        // create a Query API subscription to /senders and connect to it, applying each message to the cache
+        std::unique_ptr<web::websockets::client::websocket_callback_client> subscribe_senders(const utility::string_t& query_api, const web::http::client::http_client_config& http_config, const web::websockets::client::websocket_client_config& websocket_config, query_cache& cache, std::atomic<bool>& closed, nmos::node_model& model, slog::base_gate& gate)
+        {
+            using web::json::value;
+            using web::json::value_of;
+
+            web::http::client::http_client client(query_api, http_config);
+
+            const auto body = value_of({
+                { nmos::fields::max_update_rate_ms, 100 },
+                { nmos::fields::resource_path, U("/senders") },
+                { nmos::fields::params, value::object() },
+                { nmos::fields::persist, false },
+                { nmos::fields::secure, U("https") == web::uri(query_api).scheme() }
+            });
+
+            auto response = client.request(web::http::methods::POST, U("/subscriptions"), body).get();
+            if (web::http::status_codes::OK != response.status_code() && web::http::status_codes::Created != response.status_code())
+            {
+                throw web::http::http_exception(U("Query API subscription request failed: ") + utility::ostringstreamed(response.status_code()));
+            }
+
+            const auto subscription = response.extract_json().get();
+            const auto ws_href = nmos::fields::ws_href(subscription);
+
+            std::unique_ptr<web::websockets::client::websocket_callback_client> websocket(new web::websockets::client::websocket_callback_client(websocket_config));
+
+            websocket->set_message_handler([&cache, &model, &gate](const web::websockets::client::websocket_incoming_message& message)
+            {
+                try
+                {
+                    cache.apply_grain(value::parse(utility::s2us(message.extract_string().get())));
+                }
+                catch (const std::exception& e)
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Query API WebSocket message error: " << e.what();
+                }
+
+                // wake query_cache_thread to fetch any new transport files
+                model.notify();
+            });
+
+            websocket->set_close_handler([&closed, &model, &gate](web::websockets::client::websocket_close_status status, const utility::string_t& reason, const std::error_code& error)
+            {
+                slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Query API WebSocket connection closed: " << reason;
+
+                closed = true;
+                model.notify();
+            });
+
+            websocket->connect(ws_href).wait();
+
+            slog::log<slog::severities::info>(gate, SLOG_FLF) << "Subscribed to remote senders via Query API WebSocket at: " << ws_href;
+
+            return websocket;
+        }
+
+        // fetch a sender's transport file from its manifest_href
+        utility::string_t get_transportfile(const utility::string_t& manifest_href, const web::http::client::http_client_config& http_config)
+        {
+            web::http::client::http_client client(manifest_href, http_config);
+
+            auto response = client.request(web::http::methods::GET).get();
+            if (web::http::status_codes::OK != response.status_code())
+            {
+                throw web::http::http_exception(U("Transport file request failed: ") + utility::ostringstreamed(response.status_code()));
+            }
+
+            return utility::s2us(response.extract_utf8string(true).get());
+        }
+    }
+
+    // This maintains the cache via a Query API WebSocket subscription to /senders, resubscribing as required,
+    // and fetches the senders' transport files, until the server is shut down
+    void query_cache_thread(nmos::node_model& model, query_cache& cache, slog::base_gate& gate)
+    {
+        auto lock = model.read_lock();
+
+        const auto query_api = nvnmos::fields::query_api(model.settings);
+        if (query_api.empty()) return;
+
+        const auto load_ca_certificates = nmos::make_load_ca_certificates_handler(model.settings, gate);
+        const auto http_config = nmos::make_http_client_config(model.settings, load_ca_certificates, gate);
+        const auto websocket_config = nmos::make_websocket_client_config(model.settings, load_ca_certificates, gate);
+        const auto backoff = std::chrono::seconds(nmos::fields::discovery_backoff_max(model.settings));
+
+        std::unique_ptr<web::websockets::client::websocket_callback_client> websocket;
+        std::atomic<bool> closed(true);
+
+        while (!model.shutdown)
+        {
+            if (closed)
+            {
+                // the cached transport files can't be trusted without the subscription
+                cache.clear();
+
+                lock.unlock();
+                try
+                {
+                    if (websocket) websocket->close().wait();
+                    websocket.reset();
+
+                    closed = false;
+                    websocket = details::subscribe_senders(query_api, http_config, websocket_config, cache, closed, model, gate);
+                }
+                catch (const std::exception& e)
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Query API subscription error: " << e.what();
+                    closed = true;
+                }
+                lock.lock();
+
+                if (closed)
+                {
+                    model.wait_for(lock, backoff, [&] { return model.shutdown; });
+                    continue;
+                }
+            }
+
+            // fetch any new or changed senders' transport files without holding the lock
+
+            utility::string_t sender_id, version, manifest_href;
+            while (!model.shutdown && !closed && cache.next_fetch(sender_id, version, manifest_href))
+            {
+                lock.unlock();
+                try
+                {
+                    cache.set_transportfile(sender_id, version, details::get_transportfile(manifest_href, http_config));
+                }
+                catch (const std::exception& e)
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Could not fetch transport file for remote sender: " << sender_id << ": " << e.what();
+                }
+                lock.lock();
+            }
+
+            // the wait has a timeout since the WebSocket handlers notify without holding the lock
+            model.wait_for(lock, std::chrono::seconds(1), [&] { return model.shutdown || closed || cache.has_fetch(); });
+        }
+
+        lock.unlock();
+        if (websocket)
+        {
+            try
+            {
+                websocket->close().wait();
+            }
+            catch (const std::exception& e)
+            {
+                slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Query API WebSocket close error: " << e.what();
+            }
+        }
+    }
+}
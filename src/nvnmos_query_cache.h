@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_QUERY_CACHE_H
+#define NVNMOS_QUERY_CACHE_H
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include "cpprest/json_utils.h"
+
+namespace slog
+{
+    class base_gate;
+}
+
+namespace nmos
+{
+    struct node_model;
+}
+
+namespace nvnmos
+{
+    // Cache of remote senders and their transport files, kept up to date by query_cache_thread
+    // so that receiver activations can resolve a sender's SDP file without an HTTP round trip
+    class query_cache
+    {
+    public:
+        // get the transport file of the specified remote sender, or an empty string if it isn't (yet) known
+        utility::string_t find_transportfile(const utility::string_t& sender_id) const;
+
+        // apply the "pre"/"post" events of a Query API WebSocket data grain
+        void apply_grain(const web::json::value& message);
+
+        // forget all remote senders, e.g. when the subscription is lost
+        void clear();
+
+        // get a sender whose transport file needs to be fetched, returning false if there are none
+        bool next_fetch(utility::string_t& sender_id, utility::string_t& version, utility::string_t& manifest_href);
+        bool has_fetch() const;
+
+        // set the fetched transport file, unless the sender has changed or been removed in the meantime
+        void set_transportfile(const utility::string_t& sender_id, const utility::string_t& version, const utility::string_t& transportfile);
+
+    private:
+        struct sender
+        {
+            utility::string_t version;
+            utility::string_t manifest_href;
+            utility::string_t transportfile;
+        };
+
+        mutable std::mutex mutex;
+        std::unordered_map<utility::string_t, sender> senders;
+        std::deque<utility::string_t> fetches;
+    };
+
+    // This maintains the cache via a Query API WebSocket subscription to /senders, resubscribing as required,
+    // and fetches the senders' transport files, until the server is shut down
+    void query_cache_thread(nmos::node_model& model, query_cache& cache, slog::base_gate& gate);
+}
+
+#endif
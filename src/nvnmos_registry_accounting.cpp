@@ -0,0 +1,182 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_registry_accounting.h"
+
+#include "nmos/model.h"
+#include "nmos/resources.h"
+
+namespace nvnmos
+{
+    namespace details
+    {
+        const utility::string_t other_operation{ U("other") };
+
+        // the size of the body of the Registration API request for the resource, e.g. POST /resource
+        uint64_t registration_request_size(const nmos::resource& resource)
+        {
+            return (uint64_t)web::json::value_of({
+                { U("type"), resource.type.name },
+                { U("data"), resource.data }
+            }).serialize().size();
+        }
+    }
+
+    registry_accounting::scope::scope(registry_accounting* accounting, const nmos::node_model& model, const utility::string_t& operation)
+        : accounting(accounting)
+        , model(model)
+        , range(0)
+    {
+        if (!accounting) return;
+
+        auto lock = model.read_lock();
+        std::lock_guard<std::mutex> accounting_lock(accounting->mutex);
+        range = accounting->next_range++;
+        accounting->ranges.insert({ range, { operation, nmos::most_recent_update(model.node_resources), nmos::tai_max() } });
+        ++accounting->totals[operation].operations;
+    }
+
+    registry_accounting::scope::~scope()
+    {
+        if (!accounting) return;
+
+        auto lock = model.read_lock();
+        std::lock_guard<std::mutex> accounting_lock(accounting->mutex);
+        accounting->ranges[range].end = nmos::most_recent_update(model.node_resources);
+    }
+
+    const utility::string_t& registry_accounting::find_operation(const nmos::tai& updated) const
+    {
+        for (const auto& range : ranges)
+        {
+            if (range.second.begin < updated && updated <= range.second.end) return range.second.operation;
+        }
+        return details::other_operation;
+    }
+
+    // check whether there may be changes to account for, while holding the model lock
+    bool registry_accounting::pending(const nmos::node_model& model) const
+    {
+        return changes.pending(model.node_resources);
+    }
+
+    // account for any changes
+    void registry_accounting::update(const nmos::node_model& model)
+    {
+        auto lock = model.read_lock();
+        std::lock_guard<std::mutex> accounting_lock(mutex);
+
+        auto account = [&](const utility::string_t& operation, const utility::string_t& type, bool post, uint64_t bytes)
+        {
+            for (auto requests : { &totals[operation].requests, &totals[operation].types[type] })
+            {
+                ++(post ? requests->posts : requests->deletes);
+                requests->bytes += bytes;
+            }
+        };
+
+        changes.detect(model.node_resources, [&](const nmos::resource& resource)
+        {
+            if (resource.has_data())
+            {
+                account(find_operation(resource.updated), resource.type.name, true, details::registration_request_size(resource));
+                published[resource.id] = resource.type.name;
+            }
+            else
+            {
+                // a resource without data has been erased, but not yet forgotten
+                auto found = published.find(resource.id);
+                if (published.end() == found) return;
+                account(find_operation(resource.updated), resource.type.name, false, 0);
+                published.erase(found);
+            }
+        }, [&](const nmos::id& id)
+        {
+            // a resource which has been forgotten without being seen erased, can't be attributed to an operation
+            auto found = published.find(id);
+            if (published.end() == found) return;
+            account(details::other_operation, found->second, false, 0);
+            published.erase(found);
+        });
+
+        // forget the operations which have completed, and whose changes have all been accounted for
+        for (auto it = ranges.begin(); ranges.end() != it;)
+        {
+            if (it->second.end <= changes.most_recent_update()) it = ranges.erase(it);
+            else ++it;
+        }
+    }
+
+    // get the totals per operation
+    web::json::value registry_accounting::to_json() const
+    {
+        auto to_json = [](const request_totals& requests)
+        {
+            return web::json::value_of({
+                { U("post"), requests.posts },
+                { U("delete"), requests.deletes },
+                { U("bytes"), requests.bytes }
+            }, true);
+        };
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto result = web::json::value::object(true);
+        for (const auto& operation : totals)
+        {
+            auto types = web::json::value::object(true);
+            for (const auto& type : operation.second.types)
+            {
+                types[type.first] = to_json(type.second);
+            }
+
+            auto json = to_json(operation.second.requests);
+            if (details::other_operation != operation.first) json[U("operations")] = web::json::value::number(operation.second.operations);
+            json[U("types")] = types;
+            result[operation.first] = json;
+        }
+        return result;
+    }
+
+    // This accounts for the changes as soon as they are made, until the server is shut down
+    void registry_accounting_thread(nmos::node_model& model, registry_accounting& accounting)
+    {
+        auto lock = model.read_lock();
+        for (;;)
+        {
+            model.wait(lock, [&] { return model.shutdown || accounting.pending(model); });
+            if (model.shutdown) break;
+
+            lock.unlock();
+            accounting.update(model);
+            lock.lock();
+        }
+    }
+
+    // This makes a task which accounts for the changes periodically, for use by the application's event loop
+    node_implementation_task make_registry_accounting_task(nmos::node_model& model, registry_accounting& accounting)
+    {
+        // the event loop isn't woken when the model is notified, so some changes may be coalesced
+        const std::chrono::milliseconds interval(50);
+
+        return [&model, &accounting, interval]
+        {
+            accounting.update(model);
+            return node_implementation_task_clock::now() + interval;
+        };
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_REGISTRY_ACCOUNTING_H
+#define NVNMOS_REGISTRY_ACCOUNTING_H
+
+#include <map>
+#include <mutex>
+#include "cpprest/json_utils.h"
+#include "nmos/tai.h"
+#include "nvnmos_change_detector.h"
+#include "nvnmos_impl.h"
+
+namespace nvnmos
+{
+    // Accounting of the Registration API requests caused by each nvnmos operation
+    // The requests are made by the nmos-cpp node behaviour, which POSTs each node resource that is inserted or modified, and
+    // DELETEs each one that is erased, so they are derived from the changes to the node resources, in the same way, and each
+    // change is attributed to the operation during which it was made, or to "other", e.g. for an activation by a controller
+    // The changes are attributed by their update time, not by the thread that made them, so while the scopes of operations
+    // on different threads overlap, each change made in the overlap is attributed to whichever operation began first, and
+    // changes made by other threads, e.g. by applying activations from the activation queue, are attributed to whichever
+    // operation is in progress at the time
+    class registry_accounting
+    {
+    public:
+        // This records the changes made while it is in scope as being caused by the specified operation,
+        // and does nothing if the accounting is null, i.e. disabled
+        class scope
+        {
+        public:
+            scope(registry_accounting* accounting, const nmos::node_model& model, const utility::string_t& operation);
+            ~scope();
+
+        private:
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+            registry_accounting* accounting;
+            const nmos::node_model& model;
+            uint64_t range;
+        };
+
+        // check whether there may be changes to account for, while holding the model lock
+        bool pending(const nmos::node_model& model) const;
+
+        // account for any changes
+        void update(const nmos::node_model& model);
+
+        // get the totals per operation
+        web::json::value to_json() const;
+
+    private:
+        struct operation_range
+        {
+            utility::string_t operation;
+            nmos::tai begin; // changes after this time
+            nmos::tai end; // changes up to and including this time, or tai_max while the operation is in progress
+        };
+
+        struct request_totals
+        {
+            uint64_t posts = 0;
+            uint64_t deletes = 0;
+            uint64_t bytes = 0;
+        };
+
+        struct operation_totals
+        {
+            uint64_t operations = 0;
+            request_totals requests;
+            std::map<utility::string_t, request_totals> types;
+        };
+
+        const utility::string_t& find_operation(const nmos::tai& updated) const;
+
+        mutable std::mutex mutex;
+        std::map<uint64_t, operation_range> ranges; // by sequence number
+        uint64_t next_range = 0;
+        std::map<utility::string_t, operation_totals> totals;
+
+        // only accessed by the thread or task accounting for the changes
+        change_detector changes;
+        std::map<utility::string_t, utility::string_t> published; // types by id
+    };
+
+    // This accounts for the changes as soon as they are made, until the server is shut down
+    void registry_accounting_thread(nmos::node_model& model, registry_accounting& accounting);
+
+    // This makes a task which accounts for the changes periodically, for use by the application's event loop
+    node_implementation_task make_registry_accounting_task(nmos::node_model& model, registry_accounting& accounting);
+}
+
+#endif
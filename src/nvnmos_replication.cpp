@@ -0,0 +1,854 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_replication.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "nmos/json_fields.h"
+#include "nmos/media_type.h"
+#include "nmos/model.h"
+#include "nmos/resources.h"
+#include "nmos/slog.h"
+#include "nvnmos_connection_index.h"
+#include "nvnmos_impl.h"
+#include "nvnmos_transportfile.h"
+
+namespace nvnmos
+{
+#ifdef __linux__
+    namespace details
+    {
+        // the maximum time a standby may make no progress reading its ops, after which it is told to resync
+        const std::chrono::seconds stall_timeout{ 1 };
+        // the maximum size of the ops waiting to be sent to a standby, after which it is told to resync
+        const size_t max_buffer_size = 64 * 1024 * 1024;
+
+        std::string serialize_op(const web::json::value& op, uint64_t seq)
+        {
+            auto line = op;
+            line[replication_fields::seq] = web::json::value::number(seq);
+            return utility::us2s(line.serialize()) + "\n";
+        }
+
+        // the primary holds a lock on this file for as long as it is alive
+        std::string make_lock_path(const std::string& socket_path)
+        {
+            return socket_path + ".lock";
+        }
+
+        class unix_replication_log : public replication_log
+        {
+        public:
+            explicit unix_replication_log(const std::string& socket_path)
+                : path(socket_path)
+                , lock_fd(::open(make_lock_path(socket_path).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644))
+                , listener(-1)
+                , base(0)
+            {
+                if (-1 == lock_fd) throw std::system_error(errno, std::generic_category(), "replication lock");
+
+                // never replace the socket of a primary which is still alive
+                if (-1 == ::flock(lock_fd, LOCK_EX | LOCK_NB))
+                {
+                    const auto error = errno;
+                    ::close(lock_fd);
+                    throw std::system_error(error, std::generic_category(), "replication lock");
+                }
+
+                listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+                if (-1 == listener)
+                {
+                    const auto error = errno;
+                    ::close(lock_fd);
+                    throw std::system_error(error, std::generic_category(), "replication socket");
+                }
+
+                sockaddr_un address{};
+                address.sun_family = AF_UNIX;
+                if (sizeof(address.sun_path) <= path.size())
+                {
+                    ::close(listener);
+                    ::close(lock_fd);
+                    throw std::system_error(ENAMETOOLONG, std::generic_category(), "replication socket");
+                }
+                std::memcpy(address.sun_path, path.c_str(), path.size());
+
+                // replace the socket of a primary which has failed, e.g. when a standby is promoted
+                ::unlink(path.c_str());
+                if (-1 == ::bind(listener, (sockaddr*)&address, sizeof(address)) || -1 == ::listen(listener, SOMAXCONN))
+                {
+                    const auto error = errno;
+                    ::close(listener);
+                    ::close(lock_fd);
+                    throw std::system_error(error, std::generic_category(), "replication bind");
+                }
+            }
+
+            ~unix_replication_log() override
+            {
+                for (auto& standby : standbys) ::close(standby.fd);
+                ::close(listener);
+                ::unlink(path.c_str());
+                // closing the file releases the lock, after which a standby may be promoted
+                ::close(lock_fd);
+            }
+
+            void append(const web::json::value& op) override
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                const auto& type = replication_fields::op(op);
+                if (replication_ops::reset == type)
+                {
+                    adds.clear();
+                }
+                else if (replication_ops::add_receiver == type || replication_ops::add_sender == type)
+                {
+                    adds[get_sdp_internal_id(utility::us2s(replication_fields::sdp(op)))] = op;
+                }
+                else if (replication_ops::remove_receiver == type || replication_ops::remove_sender == type)
+                {
+                    adds.erase(replication_fields::id(op));
+                }
+
+                queued.push_back(op);
+            }
+
+            void set_state(const utility::string_t& id, const web::json::value& op) override
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                states[id] = op;
+                queued.push_back(op);
+            }
+
+            void retain(const std::set<utility::string_t>& ids) override
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto it = states.begin(); states.end() != it;)
+                {
+                    if (0 == ids.count(it->first)) it = states.erase(it);
+                    else ++it;
+                }
+            }
+
+            bool pending() const override
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                return !queued.empty();
+            }
+
+            void accept() override
+            {
+                for (;;)
+                {
+                    const int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                    if (-1 == fd) return;
+
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    // the snapshot already includes the effect of the ops which are still queued
+                    standby connected{ fd, 0, base + queued.size(), {}, false, std::chrono::steady_clock::now(), false };
+
+                    // queue the compacted log as a snapshot
+                    push(connected, web::json::value_of({ { replication_fields::op, replication_ops::reset } }));
+                    for (auto& add : adds) push(connected, add.second);
+                    for (auto& state : states) push(connected, state.second);
+
+                    standbys.push_back(std::move(connected));
+                }
+            }
+
+            void flush() override
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                const auto now = std::chrono::steady_clock::now();
+                for (auto it = standbys.begin(); standbys.end() != it;)
+                {
+                    if (it->buffer.empty()) it->progress = now;
+                    for (size_t index = it->from < base ? 0 : (size_t)(it->from - base); index < queued.size(); ++index)
+                    {
+                        push(*it, queued[index]);
+                    }
+
+                    if (write(*it, now))
+                    {
+                        ++it;
+                    }
+                    else
+                    {
+                        ::close(it->fd);
+                        it = standbys.erase(it);
+                    }
+                }
+
+                base += queued.size();
+                queued.clear();
+            }
+
+            int poll_fd() const override
+            {
+                return listener;
+            }
+
+        private:
+            struct standby
+            {
+                int fd;
+                uint64_t seq;
+                // the index of the first queued op which isn't included in the standby's snapshot
+                uint64_t from;
+                // the serialized ops which haven't been sent yet
+                std::string buffer;
+                // whether the last send ended part way through an op
+                bool mid_line;
+                // when the standby last made progress reading its ops
+                std::chrono::steady_clock::time_point progress;
+                // whether the standby has been told to resync, after which it is disconnected
+                bool resyncing;
+            };
+
+            // the mutex must be held
+            static void push(standby& standby, const web::json::value& op)
+            {
+                if (standby.resyncing) return;
+                standby.buffer += serialize_op(op, standby.seq++);
+            }
+
+            // send as much as possible without blocking, returning false if the standby has failed, or has been told to resync
+            // the mutex must be held
+            static bool write(standby& standby, std::chrono::steady_clock::time_point now)
+            {
+                while (!standby.buffer.empty())
+                {
+                    const auto result = ::send(standby.fd, standby.buffer.data(), standby.buffer.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                    if (-1 == result && EINTR == errno) continue;
+                    if (-1 == result && (EAGAIN == errno || EWOULDBLOCK == errno)) break;
+                    if (result <= 0) return false;
+                    standby.mid_line = '\n' != standby.buffer[(size_t)result - 1];
+                    standby.buffer.erase(0, (size_t)result);
+                    standby.progress = now;
+                }
+
+                if (standby.buffer.empty()) return !standby.resyncing;
+
+                if (standby.resyncing) return now - standby.progress < stall_timeout;
+
+                if (max_buffer_size < standby.buffer.size() || stall_timeout <= now - standby.progress)
+                {
+                    // finish the op which has been partly sent, so that the standby can parse the resync op which replaces the rest
+                    const auto line_size = standby.mid_line ? standby.buffer.find('\n') + 1 : 0;
+                    standby.buffer.erase(line_size);
+                    standby.buffer += serialize_op(web::json::value_of({ { replication_fields::op, replication_ops::resync } }), standby.seq++);
+                    standby.resyncing = true;
+                    standby.progress = now;
+                }
+                return true;
+            }
+
+            const std::string path;
+            const int lock_fd;
+            int listener;
+
+            mutable std::mutex mutex;
+            std::vector<standby> standbys;
+            // the add ops of the current senders and receivers, with internal ids as keys
+            std::map<utility::string_t, web::json::value> adds;
+            // the state ops of the current resources, with resource ids as keys
+            std::map<utility::string_t, web::json::value> states;
+            // the ops which haven't been sent yet, and the index of the first of them
+            std::vector<web::json::value> queued;
+            uint64_t base;
+        };
+
+        class unix_replication_stream : public replication_stream
+        {
+        public:
+            explicit unix_replication_stream(const std::string& socket_path)
+                : path(socket_path)
+                , fd(-1)
+                // the socket changes each time the standby reconnects, so the epoll instance, to which it's added, is polled instead
+                , epoll_fd(::epoll_create1(EPOLL_CLOEXEC))
+            {}
+
+            ~unix_replication_stream() override
+            {
+                if (-1 != fd) ::close(fd);
+                if (-1 != epoll_fd) ::close(epoll_fd);
+            }
+
+            bool connect() override
+            {
+                if (-1 != fd) return true;
+
+                sockaddr_un address{};
+                address.sun_family = AF_UNIX;
+                if (sizeof(address.sun_path) <= path.size()) return false;
+                std::memcpy(address.sun_path, path.c_str(), path.size());
+
+                fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (-1 == fd) return false;
+                if (-1 == ::connect(fd, (sockaddr*)&address, sizeof(address)))
+                {
+                    ::close(fd);
+                    fd = -1;
+                    return false;
+                }
+                if (-1 != epoll_fd)
+                {
+                    epoll_event event{};
+                    event.events = EPOLLIN;
+                    event.data.fd = fd;
+                    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+                }
+                buffer.clear();
+                return true;
+            }
+
+            bool next(web::json::value& op, std::chrono::milliseconds timeout) override
+            {
+                if (-1 == fd) return false;
+
+                auto newline = buffer.find('\n');
+                if (std::string::npos == newline)
+                {
+                    pollfd pfd{ fd, POLLIN, 0 };
+                    if (::poll(&pfd, 1, (int)timeout.count()) <= 0) return false;
+
+                    char chunk[65536];
+                    const auto size = ::recv(fd, chunk, sizeof(chunk), 0);
+                    if (size <= 0)
+                    {
+                        disconnect();
+                        return false;
+                    }
+                    buffer.append(chunk, (size_t)size);
+
+                    newline = buffer.find('\n');
+                    if (std::string::npos == newline) return false;
+                }
+
+                op = web::json::value::parse(utility::s2us(buffer.substr(0, newline)));
+                buffer.erase(0, newline + 1);
+                return true;
+            }
+
+            bool connected() const override
+            {
+                return -1 != fd;
+            }
+
+            void disconnect() override
+            {
+                if (-1 == fd) return;
+                if (-1 != epoll_fd) ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+                ::close(fd);
+                fd = -1;
+            }
+
+            bool primary_alive() override
+            {
+                const int lock_fd = ::open(make_lock_path(path).c_str(), O_RDWR | O_CLOEXEC);
+                if (-1 == lock_fd) return false;
+
+                // if the lock can be taken, the primary has released it, or has died
+                const bool alive = -1 == ::flock(lock_fd, LOCK_EX | LOCK_NB) && EWOULDBLOCK == errno;
+                ::close(lock_fd);
+                return alive;
+            }
+
+            int poll_fd() const override
+            {
+                return epoll_fd;
+            }
+
+        private:
+            const std::string path;
+            int fd;
+            const int epoll_fd;
+            std::string buffer;
+        };
+    }
+#endif
+
+    // This constructs a replication log listening on the specified UNIX domain socket, replacing any stale socket file,
+    // or returns null if that isn't supported on this platform
+    std::unique_ptr<replication_log> make_replication_log(const std::string& socket_path)
+    {
+#ifdef __linux__
+        return std::unique_ptr<replication_log>(new details::unix_replication_log(socket_path));
+#else
+        return{};
+#endif
+    }
+
+    // This constructs a replication stream from the specified UNIX domain socket, or returns null if that isn't supported
+    // on this platform
+    std::unique_ptr<replication_stream> make_replication_stream(const std::string& socket_path)
+    {
+#ifdef __linux__
+        return std::unique_ptr<replication_stream>(new details::unix_replication_stream(socket_path));
+#else
+        return{};
+#endif
+    }
+
+    namespace details
+    {
+        web::json::value make_connection_state(const nmos::resource& connection_resource, const nmos::resource& resource, transportfile_store& transportfiles)
+        {
+            using web::json::value_of;
+
+            auto op = value_of({
+                { replication_fields::op, replication_ops::connection },
+                { replication_fields::id, connection_resource.id },
+                { replication_fields::type, connection_resource.type.name },
+                { nmos::fields::version, connection_resource.data.at(nmos::fields::version) },
+                { nmos::fields::endpoint_staged, nmos::fields::endpoint_staged(connection_resource.data) },
+                { nmos::fields::endpoint_active, nmos::fields::endpoint_active(connection_resource.data) },
+                { replication_fields::subscription, replication_fields::subscription(resource.data) }
+            });
+
+            if (nmos::types::sender == connection_resource.type)
+            {
+                auto transportfile = nmos::fields::endpoint_transportfile(connection_resource.data);
+
+                // a lazily rendered /transportfile refers to the nvnmos API, so render it now, since the standby has no inputs from which to do so
+                auto& transportfile_data = nmos::fields::transportfile_data(transportfile);
+                if (transportfile_data.is_null())
+                {
+                    const auto rendered = transportfiles.get(connection_resource.id);
+                    if (!rendered.empty())
+                    {
+                        transportfile = value_of({
+                            { nmos::fields::transportfile_data, rendered },
+                            { nmos::fields::transportfile_type, nmos::media_types::application_sdp.name }
+                        });
+                    }
+                }
+
+                op[nmos::fields::endpoint_transportfile] = transportfile;
+            }
+
+            return op;
+        }
+
+        web::json::value make_node_state(const nmos::resource& node)
+        {
+            using web::json::value_of;
+
+            return value_of({
+                { replication_fields::op, replication_ops::node },
+                { replication_fields::id, node.id },
+                { replication_fields::clocks, replication_fields::clocks(node.data) },
+                { replication_fields::interfaces, replication_fields::interfaces(node.data) }
+            });
+        }
+
+        // apply a "connection" or "node" op, returning false if the resource doesn't (yet) exist
+        bool apply_state(nmos::node_model& model, connection_index& connections, const web::json::value& op)
+        {
+            auto lock = model.write_lock(); // in order to update the resources
+
+            const auto& id = replication_fields::id(op);
+
+            if (replication_ops::node == replication_fields::op(op))
+            {
+                if (model.node_resources.end() == nmos::find_resource(model.node_resources, { id, nmos::types::node })) return false;
+
+                nmos::modify_resource(model.node_resources, id, [&](nmos::resource& node)
+                {
+                    node.data[replication_fields::clocks] = replication_fields::clocks(op);
+                    node.data[replication_fields::interfaces] = replication_fields::interfaces(op);
+                });
+            }
+            else
+            {
+                const nmos::type type{ replication_fields::type(op) };
+                if (model.connection_resources.end() == nmos::find_resource(model.connection_resources, { id, type })) return false;
+                if (model.node_resources.end() == nmos::find_resource(model.node_resources, { id, type })) return false;
+
+                nmos::modify_resource(model.connection_resources, id, [&](nmos::resource& connection_resource)
+                {
+                    connection_resource.data[nmos::fields::version] = op.at(nmos::fields::version);
+                    connection_resource.data[nmos::fields::endpoint_staged] = nmos::fields::endpoint_staged(op);
+                    connection_resource.data[nmos::fields::endpoint_active] = nmos::fields::endpoint_active(op);
+                    if (op.has_field(nmos::fields::endpoint_transportfile))
+                    {
+                        connection_resource.data[nmos::fields::endpoint_transportfile] = nmos::fields::endpoint_transportfile(op);
+                    }
+                });
+
+                nmos::modify_resource(model.node_resources, id, [&](nmos::resource& resource)
+                {
+                    resource.data[replication_fields::subscription] = replication_fields::subscription(op);
+                });
+
+                connections.update(model.node_resources, model.connection_resources, id);
+            }
+
+            model.notify();
+            return true;
+        }
+    }
+
+    namespace details
+    {
+        // Publishes the state of the resources which have changed since they were last published
+        class replication_publisher
+        {
+        public:
+            replication_publisher() : most_recent_update(nmos::tai_min()), collected(false) {}
+
+            // whether any resources have changed; the model must be locked
+            bool changed(const nmos::node_model& model) const
+            {
+                return most_recent_update < nmos::most_recent_update(model.connection_resources) || most_recent_update < nmos::most_recent_update(model.node_resources);
+            }
+
+            // make the state ops of the resources which have changed; the model must be locked
+            void collect(const nmos::node_model& model, transportfile_store& transportfiles)
+            {
+                most_recent_update = (std::max)(nmos::most_recent_update(model.connection_resources), nmos::most_recent_update(model.node_resources));
+
+                states.clear();
+                ids.clear();
+
+                for (const auto& connection_resource : model.connection_resources)
+                {
+                    if (nmos::types::sender != connection_resource.type && nmos::types::receiver != connection_resource.type) continue;
+                    auto resource = nmos::find_resource(model.node_resources, { connection_resource.id, connection_resource.type });
+                    if (model.node_resources.end() == resource) continue;
+
+                    ids.insert(connection_resource.id);
+
+                    // a change of subscription is always accompanied by a change of the connection resource
+                    auto& version = published[connection_resource.id];
+                    if (version == connection_resource.updated) continue;
+                    version = connection_resource.updated;
+
+                    states.push_back({ connection_resource.id, make_connection_state(connection_resource, *resource, transportfiles) });
+                }
+
+                for (const auto& node : model.node_resources)
+                {
+                    if (nmos::types::node != node.type) continue;
+
+                    ids.insert(node.id);
+
+                    auto& version = published[node.id];
+                    if (version == node.updated) continue;
+                    version = node.updated;
+
+                    states.push_back({ node.id, make_node_state(node) });
+                }
+
+                for (auto it = published.begin(); published.end() != it;)
+                {
+                    if (0 == ids.count(it->first)) it = published.erase(it);
+                    else ++it;
+                }
+
+                collected = true;
+            }
+
+            // record the collected state ops, accept any pending standby connections and send the queued ops, without
+            // holding the model lock, since a standby may be slow to read them
+            void publish(replication_log& log, slog::base_gate& gate)
+            {
+                try
+                {
+                    if (collected)
+                    {
+                        for (auto& state : states) log.set_state(state.first, state.second);
+                        log.retain(ids);
+                        collected = false;
+                    }
+                    log.accept();
+                    log.flush();
+                }
+                catch (const std::exception& e)
+                {
+                    slog::log<slog::severities::error>(gate, SLOG_FLF) << "Replication error: " << e.what();
+                }
+            }
+
+        private:
+            // the version of each resource whose state has been published
+            std::map<utility::string_t, nmos::tai> published;
+            nmos::tai most_recent_update;
+
+            // the state ops which have been collected but not yet recorded, and the ids of all the current resources
+            std::vector<std::pair<utility::string_t, web::json::value>> states;
+            std::set<utility::string_t> ids;
+            bool collected;
+        };
+    }
+
+    // This publishes the state of the node's connection resources and node resource, when they change, accepts standby
+    // connections, and sends the queued ops to the standbys, until the server is shut down
+    void replication_publisher_thread(nmos::node_model& model, replication_log& log, transportfile_store& transportfiles, slog::base_gate& gate)
+    {
+        auto lock = model.read_lock();
+
+        details::replication_publisher publisher;
+
+        for (;;)
+        {
+            // wait for the resources to change, but also check for standby connections periodically
+            model.wait_for(lock, std::chrono::milliseconds(100), [&] { return model.shutdown || log.pending() || publisher.changed(model); });
+            if (model.shutdown) break;
+
+            if (publisher.changed(model)) publisher.collect(model, transportfiles);
+
+            lock.unlock();
+            publisher.publish(log, gate);
+            lock.lock();
+        }
+    }
+
+    // This makes a task which does the same periodically, or when a standby connects, for use by the application's event loop
+    node_implementation_task make_replication_publisher_task(nmos::node_model& model, replication_log& log, transportfile_store& transportfiles, slog::base_gate& gate)
+    {
+        // the event loop isn't woken when the model is notified, so changes are published with this latency, which also
+        // bounds the time before a standby which couldn't keep up is sent more of its ops
+        const std::chrono::milliseconds interval(50);
+
+        std::shared_ptr<details::replication_publisher> publisher(new details::replication_publisher);
+
+        return [&model, &log, &transportfiles, &gate, interval, publisher]
+        {
+            {
+                auto lock = model.read_lock();
+                if (publisher->changed(model)) publisher->collect(model, transportfiles);
+            }
+            publisher->publish(log, gate);
+            return node_implementation_task_clock::now() + interval;
+        };
+    }
+
+    replication_standby::replication_standby(nmos::node_model& model, replication_stream& stream, sdp_store& sdps, const format_registry& formats, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, slog::base_gate& gate)
+        : model(model)
+        , stream(stream)
+        , sdps(sdps)
+        , formats(formats)
+        , transportfiles(transportfiles)
+        , rollback(rollback)
+        , connections(connections)
+        , gate(gate)
+        , was_connected(false)
+        , expected_seq(0)
+    {}
+
+    // connect to the primary if necessary, and apply the ops which have been received, waiting up to the specified timeout
+    // for the first of them, returning false if the primary was connected and has then been lost
+    bool replication_standby::run_once(std::chrono::milliseconds timeout)
+    {
+        if (!stream.connected())
+        {
+            if (!stream.connect())
+            {
+                // a disconnection alone doesn't mean the primary has been lost, e.g. it may have told this standby to resync,
+                // so only promote once the primary can't be connected to and has released its lock
+                if (was_connected && !stream.primary_alive())
+                {
+                    slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Replication stream from primary disconnected, and primary is not alive";
+                    return false;
+                }
+                std::this_thread::sleep_for(timeout);
+                return true;
+            }
+            slog::log<slog::severities::info>(gate, SLOG_FLF) << "Replication stream from primary " << (was_connected ? "reconnected" : "connected");
+            was_connected = true;
+            // each connection starts with a snapshot
+            expected_seq = 0;
+        }
+
+        // apply all the ops which have been received, so that none are left buffered when the stream is next polled
+        for (;;)
+        {
+            web::json::value op;
+            try
+            {
+                if (!stream.next(op, timeout))
+                {
+                    if (!stream.connected()) slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Replication stream from primary disconnected";
+                    return true;
+                }
+            }
+            catch (const web::json::json_exception& e)
+            {
+                // a corrupt op doesn't mean the primary has been lost, so get a fresh snapshot
+                slog::log<slog::severities::error>(gate, SLOG_FLF) << "Replication stream error: " << e.what() << "; resynchronizing";
+                stream.disconnect();
+                return true;
+            }
+            timeout = std::chrono::milliseconds::zero();
+
+            // an op has been missed, so the standby's model can't be trusted until it has a fresh snapshot
+            const auto seq = (uint64_t)replication_fields::seq(op);
+            if (expected_seq != seq)
+            {
+                slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Replication stream out of sequence, expected: " << expected_seq << ", received: " << seq << "; resynchronizing";
+                stream.disconnect();
+                return true;
+            }
+            expected_seq = seq + 1;
+
+            if (replication_ops::resync == replication_fields::op(op))
+            {
+                slog::log<slog::severities::warning>(gate, SLOG_FLF) << "Replication stream resynchronization requested by primary";
+                stream.disconnect();
+                return true;
+            }
+
+            apply(op);
+        }
+    }
+
+    // apply one op, which is in sequence
+    void replication_standby::apply(const web::json::value& op)
+    {
+        const auto& type = replication_fields::op(op);
+        const auto seq = (uint64_t)replication_fields::seq(op);
+        slog::log<slog::severities::more_info>(gate, SLOG_FLF) << "Applying replication op: " << type << ", seq: " << seq;
+
+        auto status = node_implementation_status::ok;
+        try
+        {
+            if (replication_ops::reset == type)
+            {
+                node_implementation_reset(model, sdps, transportfiles, rollback, connections, gate);
+                pending.clear();
+            }
+            else if (replication_ops::add_receiver == type)
+            {
+                status = node_implementation_add_receiver(model, sdps, formats, utility::us2s(replication_fields::sdp(op)), gate);
+            }
+            else if (replication_ops::add_sender == type)
+            {
+                status = node_implementation_add_sender(model, sdps, formats, utility::us2s(replication_fields::sdp(op)), gate);
+            }
+            else if (replication_ops::remove_receiver == type)
+            {
+                status = node_implementation_remove_receiver(model, sdps, rollback, connections, replication_fields::id(op), gate);
+            }
+            else if (replication_ops::remove_sender == type)
+            {
+                status = node_implementation_remove_sender(model, sdps, transportfiles, rollback, replication_fields::id(op), gate);
+            }
+            else if (replication_ops::connection == type || replication_ops::node == type)
+            {
+                if (!details::apply_state(model, connections, op)) pending[replication_fields::id(op)] = op;
+            }
+
+            // apply any states which were waiting for a sender or receiver to be added
+            if (replication_ops::add_receiver == type || replication_ops::add_sender == type)
+            {
+                for (auto it = pending.begin(); pending.end() != it;)
+                {
+                    if (details::apply_state(model, connections, it->second)) it = pending.erase(it);
+                    else ++it;
+                }
+            }
+        }
+        catch (const node_implementation_exception&)
+        {
+            // node implementation writes the log message
+            status = node_implementation_status::invalid_argument;
+        }
+
+        // the standby's application may already have added the same sender or receiver itself
+        if (node_implementation_status::duplicate_id == status && (replication_ops::add_receiver == type || replication_ops::add_sender == type))
+        {
+            status = node_implementation_status::ok;
+        }
+
+        if (node_implementation_status::ok != status)
+        {
+            slog::log<slog::severities::error>(gate, SLOG_FLF) << "Standby could not apply replication op: " << type << ", seq: " << seq;
+        }
+    }
+
+    // This applies the ops received from the primary to the standby's model until the primary is lost or the specified flag
+    // is set, returning whether the primary was lost
+    bool replication_standby_thread(nmos::node_model& model, replication_stream& stream, sdp_store& sdps, const format_registry& formats, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const std::atomic<bool>& stopping, slog::base_gate& gate)
+    {
+        replication_standby standby(model, stream, sdps, formats, transportfiles, rollback, connections, gate);
+
+        while (!stopping)
+        {
+            if (!standby.run_once(std::chrono::milliseconds(100))) return true;
+        }
+
+        return false;
+    }
+
+    // This makes a task which does the same for use by the application's event loop, calling the specified handler if the
+    // primary is lost, after which the task, like one for which the flag is set, is never due again
+    node_implementation_task make_replication_standby_task(nmos::node_model& model, replication_stream& stream, sdp_store& sdps, const format_registry& formats, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const std::atomic<bool>& stopping, std::function<void()> primary_lost, slog::base_gate& gate)
+    {
+        // the stream's file descriptor wakes the event loop when ops are received, so this only paces the reconnection attempts
+        const std::chrono::milliseconds interval(100);
+
+        std::shared_ptr<replication_standby> standby(new replication_standby(model, stream, sdps, formats, transportfiles, rollback, connections, gate));
+        std::shared_ptr<bool> lost(new bool(false));
+
+        return [&stopping, primary_lost, interval, standby, lost]
+        {
+            if (stopping || *lost) return node_implementation_task_clock::time_point::max();
+
+            if (!standby->run_once(std::chrono::milliseconds::zero()))
+            {
+                *lost = true;
+                if (primary_lost) primary_lost();
+                return node_implementation_task_clock::time_point::max();
+            }
+
+            return node_implementation_task_clock::now() + interval;
+        };
+    }
+
+    // This finds the value of the 'x-nvnmos-id' attribute, without parsing the whole SDP data
+    utility::string_t get_sdp_internal_id(const std::string& sdp)
+    {
+        static const std::string attribute = "a=" + utility::us2s(nvnmos::attributes::internal_id) + ":";
+        std::istringstream lines(sdp);
+        for (std::string line; std::getline(lines, line);)
+        {
+            if (!line.empty() && '\r' == line.back()) line.pop_back();
+            if (0 == line.compare(0, attribute.size(), attribute)) return utility::s2us(line.substr(attribute.size()));
+        }
+        return{};
+    }
+}
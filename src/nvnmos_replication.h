@@ -0,0 +1,195 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_REPLICATION_H
+#define NVNMOS_REPLICATION_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include "cpprest/json_utils.h"
+#include "nvnmos_impl.h"
+
+namespace slog
+{
+    class base_gate;
+}
+
+namespace nmos
+{
+    struct node_model;
+}
+
+namespace nvnmos
+{
+    class activation_rollback;
+    class connection_index;
+    class format_registry;
+    class sdp_store;
+    class transportfile_store;
+
+    // Replication ops, serialized as one JSON object per line, with a sequence number
+    // "reset", "add_receiver" and "add_sender" (with "sdp"), "remove_receiver" and "remove_sender" (with internal "id")
+    // are changes made by the application, which a standby applies in the same way, resulting in the same seed-derived ids
+    // "connection" (with the IS-05 /staged, /active and /transportfile endpoints and IS-04 subscription) and "node" (with
+    // the clocks and interfaces) are the latest state of resources, however it was changed, e.g. by a controller
+    // "resync" is sent to a standby which can't keep up, before it is disconnected, so that it reconnects for a fresh snapshot
+    namespace replication_ops
+    {
+        const utility::string_t reset{ U("reset") };
+        const utility::string_t add_receiver{ U("add_receiver") };
+        const utility::string_t add_sender{ U("add_sender") };
+        const utility::string_t remove_receiver{ U("remove_receiver") };
+        const utility::string_t remove_sender{ U("remove_sender") };
+        const utility::string_t connection{ U("connection") };
+        const utility::string_t node{ U("node") };
+        const utility::string_t resync{ U("resync") };
+    }
+
+    namespace replication_fields
+    {
+        // replication op fields
+        const web::json::field_as_integer seq{ U("seq") };
+        const web::json::field_as_string op{ U("op") };
+        const web::json::field_as_string id{ U("id") }; // internal id, or resource id for state ops
+        const web::json::field_as_string type{ U("type") };
+        const web::json::field_as_string sdp{ U("sdp") };
+        // resource data fields which are replicated
+        const web::json::field_as_value subscription{ U("subscription") };
+        const web::json::field_as_value clocks{ U("clocks") };
+        const web::json::field_as_value interfaces{ U("interfaces") };
+    }
+
+    // Ordered log of changes to the node, published by a primary server to standby servers over a local socket
+    // The log is compacted to the current state, which is sent as a snapshot to each standby when it connects
+    // Changes are queued, and only sent by the publisher thread, so recording them never blocks on a slow standby
+    class replication_log
+    {
+    public:
+        virtual ~replication_log() {}
+
+        // record a change made by the application
+        virtual void append(const web::json::value& op) = 0;
+
+        // record the latest state of the specified resource
+        virtual void set_state(const utility::string_t& id, const web::json::value& op) = 0;
+
+        // forget the state of resources other than those specified, e.g. those which have been removed
+        virtual void retain(const std::set<utility::string_t>& ids) = 0;
+
+        // whether there are recorded changes which haven't been sent yet
+        virtual bool pending() const = 0;
+
+        // accept any pending standby connections without blocking, queueing a snapshot for each
+        virtual void accept() = 0;
+
+        // send the recorded changes to each standby without blocking, telling any which can't keep up to resync
+        virtual void flush() = 0;
+
+        // the file descriptor which becomes readable when a standby connects
+        virtual int poll_fd() const = 0;
+    };
+
+    // This constructs a replication log listening on the specified UNIX domain socket, replacing any stale socket file,
+    // or returns null if that isn't supported on this platform
+    // The primary holds a lock on a file next to the socket, so that a standby can tell whether it is still alive; if another
+    // primary holds the lock, a std::system_error is thrown
+    std::unique_ptr<replication_log> make_replication_log(const std::string& socket_path);
+
+    // Stream of replication ops received by a standby server from the primary
+    class replication_stream
+    {
+    public:
+        virtual ~replication_stream() {}
+
+        // connect to the primary, returning false if it isn't (yet) available
+        virtual bool connect() = 0;
+
+        // wait up to the specified timeout for the next op, returning false on timeout or if the primary has disconnected
+        virtual bool next(web::json::value& op, std::chrono::milliseconds timeout) = 0;
+
+        virtual bool connected() const = 0;
+
+        // disconnect from the primary, e.g. in order to reconnect for a fresh snapshot
+        virtual void disconnect() = 0;
+
+        // check whether the primary is still alive, i.e. still holds its lock, even if it can't be connected to
+        virtual bool primary_alive() = 0;
+
+        // a file descriptor which becomes readable when ops have been received, and stays the same when reconnecting, or -1
+        virtual int poll_fd() const = 0;
+    };
+
+    // This constructs a replication stream from the specified UNIX domain socket, or returns null if that isn't supported
+    // on this platform
+    std::unique_ptr<replication_stream> make_replication_stream(const std::string& socket_path);
+
+    // This publishes the state of the node's connection resources and node resource, when they change, accepts standby
+    // connections, and sends the queued ops to the standbys, until the server is shut down
+    void replication_publisher_thread(nmos::node_model& model, replication_log& log, transportfile_store& transportfiles, slog::base_gate& gate);
+
+    // This makes a task which does the same periodically, or when a standby connects, for use by the application's event loop
+    node_implementation_task make_replication_publisher_task(nmos::node_model& model, replication_log& log, transportfile_store& transportfiles, slog::base_gate& gate);
+
+    // Applies the ops received from the primary to the standby's model, reconnecting for a fresh snapshot whenever the stream
+    // is disconnected, out of sequence or can't be parsed
+    class replication_standby
+    {
+    public:
+        replication_standby(nmos::node_model& model, replication_stream& stream, sdp_store& sdps, const format_registry& formats, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, slog::base_gate& gate);
+
+        // connect to the primary if necessary, and apply the ops which have been received, waiting up to the specified timeout
+        // for the first of them, returning false if the primary was connected and has then been lost, i.e. can't be connected
+        // to and fails the liveness check
+        bool run_once(std::chrono::milliseconds timeout);
+
+    private:
+        // apply one op, which is in sequence
+        void apply(const web::json::value& op);
+
+        nmos::node_model& model;
+        replication_stream& stream;
+        sdp_store& sdps;
+        const format_registry& formats;
+        transportfile_store& transportfiles;
+        activation_rollback& rollback;
+        connection_index& connections;
+        slog::base_gate& gate;
+
+        // state ops for resources which haven't been added yet, since the primary publishes resource states independently
+        // of the application's changes
+        std::map<utility::string_t, web::json::value> pending;
+        bool was_connected;
+        uint64_t expected_seq;
+    };
+
+    // This applies the ops received from the primary to the standby's model until the primary is lost or the specified flag
+    // is set, returning whether the primary was lost
+    bool replication_standby_thread(nmos::node_model& model, replication_stream& stream, sdp_store& sdps, const format_registry& formats, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const std::atomic<bool>& stopping, slog::base_gate& gate);
+
+    // This makes a task which does the same for use by the application's event loop, calling the specified handler if the
+    // primary is lost, after which the task, like one for which the flag is set, is never due again
+    node_implementation_task make_replication_standby_task(nmos::node_model& model, replication_stream& stream, sdp_store& sdps, const format_registry& formats, transportfile_store& transportfiles, activation_rollback& rollback, connection_index& connections, const std::atomic<bool>& stopping, std::function<void()> primary_lost, slog::base_gate& gate);
+
+    // This finds the value of the 'x-nvnmos-id' attribute, without parsing the whole SDP data
+    utility::string_t get_sdp_internal_id(const std::string& sdp);
+}
+
+#endif
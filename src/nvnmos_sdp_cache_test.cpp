@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This checks the cache of parsed SDP data, i.e. that hits return the same entry, that the least recently used entry
+// is evicted when it is full, and that invalid SDP data is rejected without being cached
+
+#include <cstdio>
+#include <stdexcept>
+#include "nvnmos_sdp_store.h"
+#include "nvnmos_test_fixture.h"
+
+namespace
+{
+    bool check(bool condition, const char* description)
+    {
+        if (!condition) std::fprintf(stderr, "Failed: %s\n", description);
+        return condition;
+    }
+
+    std::string make_receiver_sdp(unsigned int index)
+    {
+        return nvnmos::test::make_sdp("receiver-" + std::to_string(index), nvnmos::test::make_multicast_address(index), false);
+    }
+
+    bool test_eviction()
+    {
+        nvnmos::sdp_cache cache(2);
+        const auto a = make_receiver_sdp(1);
+        const auto b = make_receiver_sdp(2);
+        const auto c = make_receiver_sdp(3);
+
+        bool success = true;
+
+        const auto entry_a = cache.find_or_parse(a);
+        const auto entry_b = cache.find_or_parse(b);
+        success = check(2 == cache.size() && 0 == cache.hits() && 2 == cache.misses(), "parse two entries") && success;
+        success = check(a == entry_a->text && b == entry_b->text, "entries hold their SDP data") && success;
+
+        // a hit returns the same entry, and makes it the most recently used
+        success = check(entry_a == cache.find_or_parse(a) && 1 == cache.hits(), "hit returns the same entry") && success;
+
+        // so the next miss evicts the other entry
+        cache.find_or_parse(c);
+        success = check(2 == cache.size() && 3 == cache.misses(), "the cache doesn't exceed its capacity") && success;
+        success = check(entry_a == cache.find_or_parse(a) && 2 == cache.hits(), "the most recently used entry is kept") && success;
+        success = check(entry_b != cache.find_or_parse(b) && 4 == cache.misses(), "the least recently used entry is evicted") && success;
+
+        // the evicted entry is still valid for as long as it's referenced
+        success = check(b == entry_b->text, "an evicted entry remains valid") && success;
+        return success;
+    }
+
+    bool test_capacity_zero()
+    {
+        nvnmos::sdp_cache cache(0);
+        const auto a = make_receiver_sdp(1);
+
+        bool success = true;
+        success = check(cache.find_or_parse(a) != cache.find_or_parse(a), "nothing is cached with no capacity") && success;
+        success = check(0 == cache.size() && 0 == cache.hits() && 2 == cache.misses(), "every lookup is a miss with no capacity") && success;
+        return success;
+    }
+
+    bool test_invalid()
+    {
+        nvnmos::sdp_cache cache(2);
+
+        bool thrown = false;
+        try
+        {
+            cache.find_or_parse("not SDP data");
+        }
+        catch (const std::exception&)
+        {
+            thrown = true;
+        }
+
+        bool success = true;
+        success = check(thrown, "invalid SDP data is rejected") && success;
+        success = check(0 == cache.size(), "invalid SDP data isn't cached") && success;
+        return success;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool success = true;
+    success = test_eviction() && success;
+    success = test_capacity_zero() && success;
+    success = test_invalid() && success;
+
+    std::fprintf(stderr, "%s\n", success ? "Passed" : "Failed");
+    return success ? 0 : 1;
+}
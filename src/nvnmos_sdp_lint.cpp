@@ -0,0 +1,298 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// nvnmos-sdp-lint checks SDP files offline against exactly what the NvNmos library accepts when senders and receivers
+// are added, and flags duplicate internal ids and sender multicast destination collisions across the whole set
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <boost/algorithm/string/split.hpp>
+#include "cpprest/host_utils.h"
+#include "nmos/id.h"
+#include "nmos/json_fields.h"
+#include "nmos/settings.h"
+#include "nmos/slog.h"
+#include "nmos/type.h"
+#include "nvnmos_format.h"
+#include "nvnmos_impl.h"
+
+namespace
+{
+    // collects the messages that the library would log, so they can be reported against each file
+    class capture_gate : public slog::base_gate
+    {
+    public:
+        virtual bool pertinent(slog::severity level) const
+        {
+            return slog::severities::warning <= level;
+        }
+
+        virtual void log(const slog::log_message& message) const
+        {
+            messages.push_back(message.str());
+        }
+
+        mutable std::vector<std::string> messages;
+    };
+
+    struct sdp_file
+    {
+        sdp_file(std::string path, nmos::type type) : path(std::move(path)), type(std::move(type)) {}
+
+        std::string path;
+        nmos::type type;
+
+        // results
+        bool valid = false;
+        std::vector<std::string> errors;
+        double milliseconds = 0.0;
+        utility::string_t internal_id;
+        web::json::value transport_params;
+    };
+
+    void lint(sdp_file& file, const nvnmos::format_registry& formats, const std::vector<web::hosts::experimental::host_interface>& host_interfaces, const nmos::settings& settings)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        capture_gate gate;
+        try
+        {
+            std::ifstream stream(file.path, std::ios::in | std::ios::binary);
+            if (!stream) throw std::runtime_error("could not read file");
+            std::ostringstream sdp;
+            sdp << stream.rdbuf();
+
+            const auto status = nvnmos::node_implementation_validate_sdp(file.type, sdp.str(), formats, host_interfaces, settings, file.internal_id, file.transport_params, gate);
+            file.valid = nvnmos::node_implementation_status::ok == status;
+            // node implementation writes the log message
+            if (!file.valid && gate.messages.empty()) file.errors.push_back("not accepted by the node implementation");
+        }
+        catch (const nvnmos::node_implementation_exception&)
+        {
+            // node implementation writes the log message
+            if (gate.messages.empty()) file.errors.push_back("unexpected error in the node implementation");
+        }
+        catch (const web::json::json_exception& e)
+        {
+            file.errors.push_back(std::string("JSON error: ") + e.what());
+        }
+        catch (const std::exception& e)
+        {
+            file.errors.push_back(e.what());
+        }
+        catch (...)
+        {
+            file.errors.push_back("unexpected unknown exception");
+        }
+        file.errors.insert(file.errors.begin(), gate.messages.begin(), gate.messages.end());
+
+        file.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool is_multicast_address(const utility::string_t& address)
+    {
+        const auto dot = address.find(U('.'));
+        if (utility::string_t::npos == dot) return false;
+        const auto first = utility::istringstreamed(address.substr(0, dot), 0);
+        return 224 <= first && first <= 239;
+    }
+
+    // parse "name=address[,address...]"
+    bool parse_interface(const std::string& arg, uint32_t index, web::hosts::experimental::host_interface& interface)
+    {
+        const auto equals = arg.find('=');
+        if (std::string::npos == equals || 0 == equals) return false;
+
+        const auto csv = arg.substr(equals + 1);
+        std::vector<std::string> addresses;
+        boost::algorithm::split(addresses, csv, [](char c) { return ',' == c; });
+
+        interface.index = index;
+        interface.name = utility::s2us(arg.substr(0, equals));
+        for (const auto& address : addresses)
+        {
+            if (address.empty()) return false;
+            interface.addresses.push_back(utility::s2us(address));
+        }
+        return true;
+    }
+
+    int usage(const char* name)
+    {
+        std::cerr
+            << "Usage:\n"
+            << name << " [-j threads] [-i name=address[,address...]]... (-s | -r) file... [(-s | -r) file...]\n"
+            << "  -j  number of worker threads (default: number of hardware threads)\n"
+            << "  -i  synthetic host interface, which may be repeated (default: the host's interfaces)\n"
+            << "  -s  the following files are sender SDP files\n"
+            << "  -r  the following files are receiver SDP files\n";
+        return 2;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    static const nmos::id seed_namespace_id = U("18daddcf-a234-4f59-808a-dbf6a42e17bb");
+
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::vector<web::hosts::experimental::host_interface> host_interfaces;
+    std::vector<sdp_file> files;
+
+    const nmos::type* type = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if ("-j" == arg && i + 1 < argc)
+        {
+            threads = (unsigned int)utility::istringstreamed(utility::s2us(argv[++i]), 0);
+            if (0 == threads) return usage(argv[0]);
+        }
+        else if ("-i" == arg && i + 1 < argc)
+        {
+            web::hosts::experimental::host_interface interface;
+            if (!parse_interface(argv[++i], (uint32_t)host_interfaces.size() + 1, interface)) return usage(argv[0]);
+            host_interfaces.push_back(std::move(interface));
+        }
+        else if ("-s" == arg)
+        {
+            type = &nmos::types::sender;
+        }
+        else if ("-r" == arg)
+        {
+            type = &nmos::types::receiver;
+        }
+        else if (!arg.empty() && '-' != arg[0] && nullptr != type)
+        {
+            files.push_back(sdp_file(arg, *type));
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (files.empty()) return usage(argv[0]);
+
+    if (host_interfaces.empty())
+    {
+        host_interfaces = web::hosts::experimental::host_interfaces();
+    }
+
+    // settings equivalent to those of a node, with a fixed seed since the generated ids are not reported
+    nmos::settings settings;
+    web::json::insert(settings, std::make_pair(nmos::experimental::fields::seed_id, nmos::make_repeatable_id(seed_namespace_id, U("nvnmos-sdp-lint"))));
+    nmos::insert_node_default_settings(settings);
+
+    // only the built-in formats are supported
+    const nvnmos::format_registry formats;
+
+    // check each file on a pool of threads
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::atomic<std::size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < (std::min)(threads, (unsigned int)files.size()); ++t)
+    {
+        workers.push_back(std::thread([&]
+        {
+            for (auto f = next++; f < files.size(); f = next++)
+            {
+                lint(files[f], formats, host_interfaces, settings);
+            }
+        }));
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // report per-file results in the order specified
+
+    std::size_t invalid = 0;
+    for (const auto& file : files)
+    {
+        std::cout << file.path << ": " << (file.valid ? "ok" : "error") << " [" << utility::us2s(file.type.name);
+        if (file.valid) std::cout << " " << utility::us2s(file.internal_id);
+        std::cout << "] (" << file.milliseconds << " ms)\n";
+        for (const auto& error : file.errors)
+        {
+            std::cout << "  " << error << "\n";
+        }
+        if (!file.valid) ++invalid;
+    }
+
+    // check across the whole set
+    // internal ids must be unique across all senders and receivers since they are used to identify either
+    // sender multicast destinations must be unique, whereas any number of receivers may join the same group
+
+    std::size_t problems = 0;
+
+    std::map<utility::string_t, std::vector<const sdp_file*>> internal_ids;
+    std::map<std::pair<utility::string_t, int>, std::vector<std::pair<const sdp_file*, int>>> destinations;
+    for (const auto& file : files)
+    {
+        if (!file.valid) continue;
+
+        internal_ids[file.internal_id].push_back(&file);
+
+        if (nmos::types::sender != file.type) continue;
+
+        for (int leg = 0; leg < (int)file.transport_params.size(); ++leg)
+        {
+            const auto& transport_param = file.transport_params.at(leg);
+            const auto& destination_ip = nmos::fields::destination_ip(transport_param);
+            const auto& destination_port = nmos::fields::destination_port(transport_param);
+            if (!destination_ip.is_string() || !is_multicast_address(destination_ip.as_string())) continue;
+
+            const auto port = destination_port.is_integer() ? destination_port.as_integer() : 0;
+            destinations[{ destination_ip.as_string(), port }].push_back({ &file, leg });
+        }
+    }
+
+    for (const auto& internal_id : internal_ids)
+    {
+        if (internal_id.second.size() < 2) continue;
+        ++problems;
+        std::cout << "duplicate internal id: " << utility::us2s(internal_id.first) << "\n";
+        for (const auto& file : internal_id.second)
+        {
+            std::cout << "  " << file->path << " [" << utility::us2s(file->type.name) << "]\n";
+        }
+    }
+
+    for (const auto& destination : destinations)
+    {
+        if (destination.second.size() < 2) continue;
+        ++problems;
+        std::cout << "multicast collision: " << utility::us2s(destination.first.first) << ":" << destination.first.second << "\n";
+        for (const auto& file_leg : destination.second)
+        {
+            std::cout << "  " << file_leg.first->path << " (leg " << file_leg.second << ")\n";
+        }
+    }
+
+    std::cout << files.size() << " files, " << invalid << " errors, " << problems << " conflicts (" << elapsed << " ms)\n";
+
+    return 0 == invalid && 0 == problems ? 0 : 1;
+}
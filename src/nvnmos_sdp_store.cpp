@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_sdp_store.h"
+
+#include <iomanip>
+#include "sdp/sdp.h"
+
+namespace nvnmos
+{
+    sdp_entry::sdp_entry(std::string text_)
+        : text(std::move(text_))
+        , session_description(sdp::parse_session_description(text))
+        , sdp_params(nmos::get_session_description_sdp_parameters(session_description))
+    {}
+
+    // find the key for the specified SDP data, or the key at which to insert it
+    std::pair<utility::string_t, bool> sdp_store::find_key(const std::string& sdp) const
+    {
+        utility::ostringstream_t hash;
+        hash << std::hex << std::setw(16) << std::setfill(U('0')) << std::hash<std::string>{}(sdp);
+
+        // in the unlikely event of a hash collision, the full SDP data is compared and a suffix is added to the key
+        for (int suffix = 0;; ++suffix)
+        {
+            const auto key = 0 == suffix ? hash.str() : hash.str() + U("-") + utility::ostringstreamed(suffix);
+            auto found = entries.find(key);
+            if (entries.end() == found) return{ key, false };
+            if (found->second.entry->text == sdp) return{ key, true };
+        }
+    }
+
+    // get the existing entry for the specified SDP data, or parse it, without adding a reference
+    std::shared_ptr<const sdp_entry> sdp_store::find_or_parse(const std::string& sdp) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto key = find_key(sdp);
+            if (key.second) return entries.at(key.first).entry;
+        }
+
+        // parse without holding the lock
+        return std::make_shared<const sdp_entry>(sdp);
+    }
+
+    // add a reference to the specified entry, inserting it if necessary, and return its key
+    utility::string_t sdp_store::acquire(std::shared_ptr<const sdp_entry> entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto key = find_key(entry->text);
+        if (key.second)
+        {
+            ++entries.at(key.first).references;
+        }
+        else
+        {
+            entries.insert({ key.first, { std::move(entry), 1 } });
+        }
+        return key.first;
+    }
+
+    // remove a reference to the specified key, erasing the entry when there are none left
+    void sdp_store::release(const utility::string_t& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(key);
+        if (entries.end() == found) return;
+        if (0 == --found->second.references) entries.erase(found);
+    }
+
+    // get the entry with the specified key, or null if not found
+    std::shared_ptr<const sdp_entry> sdp_store::find(const utility::string_t& key) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(key);
+        return entries.end() != found ? found->second.entry : std::shared_ptr<const sdp_entry>{};
+    }
+
+    // remove all entries
+    void sdp_store::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+    // get the entry for the specified SDP data, parsing it if necessary; parse errors are thrown
+    std::shared_ptr<const sdp_entry> sdp_cache::find_or_parse(const std::string& sdp)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = entries.find(sdp);
+            if (entries.end() != found)
+            {
+                lru.splice(lru.begin(), lru, found->second);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return *found->second;
+            }
+        }
+
+        // parse without holding the lock
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        auto entry = std::make_shared<const sdp_entry>(sdp);
+        if (0 == capacity) return entry;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(sdp);
+        if (entries.end() != found)
+        {
+            // another thread parsed the same SDP data in the meantime
+            lru.splice(lru.begin(), lru, found->second);
+            return *found->second;
+        }
+
+        if (capacity <= lru.size())
+        {
+            entries.erase(lru.back()->text);
+            lru.pop_back();
+        }
+        lru.push_front(entry);
+        entries.insert({ sdp, lru.begin() });
+        return entry;
+    }
+
+    std::size_t sdp_cache::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lru.size();
+    }
+}
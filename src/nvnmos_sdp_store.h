@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_SDP_STORE_H
+#define NVNMOS_SDP_STORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "nmos/sdp_utils.h"
+
+namespace nvnmos
+{
+    // SDP data and the results of parsing it, which are immutable once constructed
+    struct sdp_entry
+    {
+        explicit sdp_entry(std::string text);
+
+        const std::string text;
+        const web::json::value session_description; // see sdp::parse_session_description
+        const nmos::sdp_parameters sdp_params; // see nmos::get_session_description_sdp_parameters
+    };
+
+    // Content-addressed store of the SDP data used to configure the senders and receivers, so that identical SDP data
+    // is only held and parsed once however many senders and receivers use it
+    // The settings hold the key of each sender's and receiver's SDP data, and each key holds a reference
+    class sdp_store
+    {
+    public:
+        // get the existing entry for the specified SDP data, or parse it, without adding a reference
+        // this allows the entry to be validated before it is acquired; parse errors are thrown
+        std::shared_ptr<const sdp_entry> find_or_parse(const std::string& sdp) const;
+
+        // add a reference to the specified entry, inserting it if necessary, and return its key
+        utility::string_t acquire(std::shared_ptr<const sdp_entry> entry);
+
+        // remove a reference to the specified key, erasing the entry when there are none left
+        void release(const utility::string_t& key);
+
+        // get the entry with the specified key, or null if not found
+        std::shared_ptr<const sdp_entry> find(const utility::string_t& key) const;
+
+        // remove all entries
+        void clear();
+
+    private:
+        struct counted_entry
+        {
+            std::shared_ptr<const sdp_entry> entry;
+            std::size_t references;
+        };
+
+        // find the key for the specified SDP data, or the key at which to insert it
+        std::pair<utility::string_t, bool> find_key(const std::string& sdp) const;
+
+        mutable std::mutex mutex;
+        std::unordered_map<utility::string_t, counted_entry> entries;
+    };
+
+    // Bounded cache of the results of parsing incoming SDP data, e.g. transport files staged by a controller, which is often
+    // the same for many receivers in a salvo, with the least recently used entry evicted when it is full
+    class sdp_cache
+    {
+    public:
+        static const std::size_t default_capacity = 64;
+
+        explicit sdp_cache(std::size_t capacity = default_capacity) : capacity(capacity) {}
+
+        // get the entry for the specified SDP data, parsing it if necessary; parse errors are thrown
+        std::shared_ptr<const sdp_entry> find_or_parse(const std::string& sdp);
+
+        std::uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+        std::uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+        std::size_t size() const;
+        std::size_t max_size() const { return capacity; }
+
+    private:
+        typedef std::list<std::shared_ptr<const sdp_entry>> lru_list; // most recently used first
+
+        const std::size_t capacity;
+        mutable std::mutex mutex;
+        lru_list lru;
+        std::unordered_map<std::string, lru_list::iterator> entries; // by SDP data
+        std::atomic<std::uint64_t> hits_{ 0 };
+        std::atomic<std::uint64_t> misses_{ 0 };
+    };
+}
+
+#endif
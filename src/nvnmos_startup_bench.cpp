@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// nvnmos-startup-bench measures the startup phases of an NMOS Node server configured with the specified numbers of
+// senders and receivers, i.e. the time to create the node and device, to add the resources and to open the API ports,
+// which don't depend on a registry, so that changes to the startup path can be compared
+// It fails if the median time of any phase exceeds its budget, so that it can also be run as a test
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "nvnmos_test_fixture.h"
+
+namespace
+{
+    // the duration of each phase, in milliseconds
+    struct phase_times
+    {
+        double init;
+        double resources;
+        double open;
+    };
+
+    // the default budgets are generous, so that only a gross regression fails, even on a loaded build machine
+    const phase_times default_budgets{ 1000, 10000, 2000 };
+
+    bool run(unsigned int count, int http_port, phase_times& result)
+    {
+        const char* host_addresses[1] = { "127.0.0.1" };
+
+        auto discovery_config = nvnmos::test::make_discovery_config();
+
+        std::vector<std::string> sdps;
+        sdps.reserve(2 * count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            sdps.push_back(nvnmos::test::make_sdp("sender-" + std::to_string(i), nvnmos::test::make_multicast_address(2 * i + 1), true));
+            sdps.push_back(nvnmos::test::make_sdp("receiver-" + std::to_string(i), nvnmos::test::make_multicast_address(2 * i + 2), false));
+        }
+
+        std::vector<NvNmosSenderConfig> sender_configs(count);
+        std::vector<NvNmosReceiverConfig> receiver_configs(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            sender_configs[i].sdp = sdps[2 * i].c_str();
+            receiver_configs[i].sdp = sdps[2 * i + 1].c_str();
+        }
+
+        NvNmosNodeConfig node_config{};
+        node_config.host_name = "nvnmos-startup-bench.local";
+        node_config.host_addresses = host_addresses;
+        node_config.num_host_addresses = 1;
+        node_config.http_port = http_port;
+        node_config.discovery = &discovery_config;
+        node_config.seed = "nvnmos-startup-bench";
+        node_config.senders = sender_configs.data();
+        node_config.num_senders = count;
+        node_config.receivers = receiver_configs.data();
+        node_config.num_receivers = count;
+        node_config.log_callback = &nvnmos::test::handle_log;
+        node_config.log_level = NVNMOS_LOG_ERROR;
+
+        NvNmosNodeServer node_server{};
+        if (!create_nmos_node_server(&node_config, &node_server)) return false;
+
+        NvNmosStartupTimes times{};
+        const bool success = nmos_get_startup_times(&node_server, &times);
+
+        if (!destroy_nmos_node_server(&node_server) || !success) return false;
+
+        result.init = (times.init - times.server) / 1e6;
+        result.resources = (times.resources - times.init) / 1e6;
+        result.open = (times.open - times.resources) / 1e6;
+        return true;
+    }
+
+    // parse "init,resources,open" budgets in milliseconds, where an empty budget keeps the default, and a zero budget means
+    // that phase isn't checked
+    bool parse_budgets(const char* arg, phase_times& budgets)
+    {
+        double* phases[] = { &budgets.init, &budgets.resources, &budgets.open };
+        for (auto phase : phases)
+        {
+            char* end = nullptr;
+            const auto budget = std::strtod(arg, &end);
+            if (end != arg) *phase = budget;
+            if ('\0' == *end) return true;
+            if (',' != *end) return false;
+            arg = end + 1;
+        }
+        return false;
+    }
+
+    bool check_budget(const char* phase, unsigned int count, double median, double budget)
+    {
+        if (0 >= budget || median <= budget) return true;
+        std::fprintf(stderr, "The %s phase with %u senders and receivers took %.3f ms, over its budget of %.3f ms\n", phase, count, median, budget);
+        return false;
+    }
+}
+
+// usage: nvnmos-startup-bench [--budgets init,resources,open] [http-port [repeats [count...]]]
+// each count is the number of senders, and of receivers, defaulting to 1, 100 and 1000
+// the budgets are in milliseconds, for each count, defaulting to 1000, 10000 and 2000, and zero disables a budget
+int main(int argc, char* argv[])
+{
+    auto budgets = default_budgets;
+    int arg = 1;
+    if (arg + 1 < argc && 0 == std::strcmp(argv[arg], "--budgets"))
+    {
+        if (!parse_budgets(argv[arg + 1], budgets))
+        {
+            std::fprintf(stderr, "Invalid budgets: %s\n", argv[arg + 1]);
+            return 1;
+        }
+        arg += 2;
+    }
+
+    const int http_port = argc > arg ? std::atoi(argv[arg]) : 18380;
+    const int repeats = (std::max)(1, argc > arg + 1 ? std::atoi(argv[arg + 1]) : 5);
+
+    std::vector<unsigned int> counts;
+    for (int i = arg + 2; i < argc; ++i) counts.push_back((unsigned int)std::atoi(argv[i]));
+    if (counts.empty()) counts = { 1, 100, 1000 };
+
+    // the median of each phase is reported, since the first run in particular may be affected by e.g. page faults
+    bool within_budgets = true;
+    std::printf("%10s %12s %12s %12s\n", "count", "init/ms", "resources/ms", "open/ms");
+    for (auto count : counts)
+    {
+        std::vector<double> init, resources, open;
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            phase_times times;
+            if (!run(count, http_port, times))
+            {
+                std::fprintf(stderr, "Failed to start a node with %u senders and receivers\n", count);
+                return 1;
+            }
+            init.push_back(times.init);
+            resources.push_back(times.resources);
+            open.push_back(times.open);
+        }
+
+        auto median = [](std::vector<double>& times)
+        {
+            std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+            return times[times.size() / 2];
+        };
+        const phase_times medians{ median(init), median(resources), median(open) };
+        std::printf("%10u %12.3f %12.3f %12.3f\n", count, medians.init, medians.resources, medians.open);
+
+        within_budgets = check_budget("init", count, medians.init, budgets.init) && within_budgets;
+        within_budgets = check_budget("resources", count, medians.resources, budgets.resources) && within_budgets;
+        within_budgets = check_budget("open", count, medians.open, budgets.open) && within_budgets;
+    }
+
+    return within_budgets ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_state_digest.h"
+
+#include "nmos/model.h"
+#include "nmos/resources.h"
+
+namespace nvnmos
+{
+    namespace details
+    {
+        // hash 64-bit FNV-1a with a different offset basis for each lane, finalized with the splitmix64 mixer
+        struct resource_hasher
+        {
+            std::array<uint64_t, 4> lanes;
+
+            resource_hasher()
+            {
+                for (size_t lane = 0; lane < lanes.size(); ++lane)
+                {
+                    lanes[lane] = 0xcbf29ce484222325ULL ^ ((lane + 1) * 0x9e3779b97f4a7c15ULL);
+                }
+            }
+
+            void add(const void* data, size_t size)
+            {
+                const auto bytes = (const uint8_t*)data;
+                for (auto& lane : lanes)
+                {
+                    for (size_t i = 0; i < size; ++i)
+                    {
+                        lane = (lane ^ bytes[i]) * 0x100000001b3ULL;
+                    }
+                }
+            }
+
+            void add(const utility::string_t& value)
+            {
+                add(value.data(), value.size() * sizeof(utility::char_t));
+                // separate consecutive strings
+                add("", 1);
+            }
+
+            void add(int64_t value)
+            {
+                add(&value, sizeof(value));
+            }
+
+            state_digest_value hash() const
+            {
+                state_digest_value result = {};
+                fold_into(result);
+                return result;
+            }
+
+            void fold_into(state_digest_value& digest) const
+            {
+                for (size_t lane = 0; lane < lanes.size(); ++lane)
+                {
+                    auto value = lanes[lane];
+                    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+                    value = value ^ (value >> 31);
+                    for (size_t i = 0; i < 8; ++i)
+                    {
+                        digest[lane * 8 + i] ^= (uint8_t)(value >> (i * 8));
+                    }
+                }
+            }
+        };
+
+        // XOR is its own inverse, so this both adds a hash to a digest and removes it again
+        void fold_into(state_digest_value& digest, const state_digest_value& hash)
+        {
+            for (size_t i = 0; i < digest.size(); ++i)
+            {
+                digest[i] ^= hash[i];
+            }
+        }
+    }
+
+    utility::string_t make_state_digest_string(const state_digest_value& digest)
+    {
+        static const char* hex = "0123456789abcdef";
+        utility::string_t result;
+        result.reserve(digest.size() * 2);
+        for (auto byte : digest)
+        {
+            result.push_back(hex[byte >> 4]);
+            result.push_back(hex[byte & 0x0f]);
+        }
+        return result;
+    }
+
+    void state_digest::update(const nmos::node_model& model)
+    {
+        update(model.node_resources, U("node"), node_digests);
+        update(model.connection_resources, U("connection"), connection_digests);
+    }
+
+    void state_digest::update(const nmos::resources& resources, const utility::string_t& api, api_digest& digests)
+    {
+        if (!digests.changes.pending(resources)) return;
+
+        // remove the previous hash of the resource from the digests, if it was included
+        auto remove = [&](const nmos::id& id)
+        {
+            auto found = digests.hashes.find(id);
+            if (digests.hashes.end() == found) return;
+
+            details::fold_into(digest, found->second.hash);
+            auto type = digests.types.find(found->second.type);
+            details::fold_into(type->second.digest, found->second.hash);
+            if (0 == --type->second.count) digests.types.erase(type);
+
+            digests.hashes.erase(found);
+        };
+
+        digests.changes.detect(resources, [&](const nmos::resource& resource)
+        {
+            remove(resource.id);
+
+            // a resource without data has been erased, but not yet forgotten
+            if (!resource.has_data()) return;
+
+            details::resource_hasher hasher;
+            hasher.add(api);
+            hasher.add(resource.type.name);
+            hasher.add(resource.id);
+            hasher.add((int64_t)resource.updated.seconds);
+            hasher.add((int64_t)resource.updated.nanoseconds);
+            const auto hash = hasher.hash();
+
+            details::fold_into(digest, hash);
+            auto& type = digests.types[resource.type.name];
+            details::fold_into(type.digest, hash);
+            ++type.count;
+
+            digests.hashes.insert({ resource.id, { resource.type.name, hash } });
+        }, remove);
+    }
+
+    // get the digest, updating it for the resources which have changed since it was last updated
+    state_digest_value state_digest::get(const nmos::node_model& model)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        update(model);
+        return digest;
+    }
+
+    // get the digest, with the digest of the resources of each type in the Node API and Connection API, as JSON
+    web::json::value state_digest::get_json(const nmos::node_model& model)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        update(model);
+
+        auto to_json = [](const api_digest& digests)
+        {
+            auto result = web::json::value::object(true);
+            for (const auto& type : digests.types)
+            {
+                result[type.first] = web::json::value::string(make_state_digest_string(type.second.digest));
+            }
+            return result;
+        };
+
+        return web::json::value_of({
+            { U("digest"), make_state_digest_string(digest) },
+            { U("node"), to_json(node_digests) },
+            { U("connection"), to_json(connection_digests) }
+        }, true);
+    }
+}
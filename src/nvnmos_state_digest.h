@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_STATE_DIGEST_H
+#define NVNMOS_STATE_DIGEST_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include "cpprest/json_utils.h"
+#include "nvnmos_change_detector.h"
+
+namespace nmos
+{
+    struct node_model;
+}
+
+namespace nvnmos
+{
+    // A 256-bit digest, which changes whenever any resource changes
+    typedef std::array<uint8_t, 32> state_digest_value;
+
+    utility::string_t make_state_digest_string(const state_digest_value& digest);
+
+    // Digest of the node's state, the XOR of a hash of each resource's identity and update time, in total and per resource type,
+    // so that monitoring systems can cheaply detect when anything has changed
+    // The digest is updated incrementally, by XORing out the previous hash of each resource which has changed, and XORing in the new one
+    class state_digest
+    {
+    public:
+        // get the digest, updating it for the resources which have changed since it was last updated
+        // (the model lock must be held, but this may be called concurrently)
+        state_digest_value get(const nmos::node_model& model);
+
+        // get the digest, with the digest of the resources of each type in the Node API and Connection API, as JSON
+        web::json::value get_json(const nmos::node_model& model);
+
+    private:
+        struct type_digest
+        {
+            state_digest_value digest = {};
+            size_t count = 0;
+        };
+
+        struct resource_hash
+        {
+            utility::string_t type;
+            state_digest_value hash;
+        };
+
+        struct api_digest
+        {
+            change_detector changes;
+            std::unordered_map<utility::string_t, resource_hash> hashes; // by id
+            std::map<utility::string_t, type_digest> types; // by type
+        };
+
+        void update(const nmos::node_model& model);
+        void update(const nmos::resources& resources, const utility::string_t& api, api_digest& digests);
+
+        std::mutex mutex;
+        state_digest_value digest = {};
+        api_digest node_digests;
+        api_digest connection_digests;
+    };
+}
+
+#endif
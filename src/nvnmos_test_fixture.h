@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_TEST_FIXTURE_H
+#define NVNMOS_TEST_FIXTURE_H
+
+// Helpers shared by the tests and the benchmark, which start NMOS Node servers on the loopback interface
+
+#include <cstdio>
+#include <string>
+#include "nvnmos.h"
+
+namespace nvnmos
+{
+    namespace test
+    {
+        inline void handle_log(NvNmosNodeServer* server, const char* categories, int level, const char* message)
+        {
+            std::fprintf(stderr, "%s [%d:%s]\n", message, level, categories);
+        }
+
+        // the Node API isn't advertised, and no Registration API is expected to be listening, which only causes the
+        // registration to be retried
+        inline NvNmosDiscoveryConfig make_discovery_config()
+        {
+            NvNmosDiscoveryConfig discovery_config{};
+            discovery_config.disable_node_advertisement = true;
+            discovery_config.registry_address = "127.0.0.1";
+            discovery_config.registry_port = 9;
+            return discovery_config;
+        }
+
+        // each sender and receiver may have its own multicast group, e.g. 233.252.0.1
+        inline std::string make_multicast_address(unsigned int index)
+        {
+            return "233.252." + std::to_string((index >> 8) & 0xFF) + "." + std::to_string(index & 0xFF);
+        }
+
+        // SDP data for a video sender or receiver on the loopback interface, with the specified internal id
+        inline std::string make_sdp(const std::string& id, const std::string& multicast_address, bool sender)
+        {
+            return
+                "v=0\r\n"
+                "o=- 1 1 IN IP4 127.0.0.1\r\n"
+                "s=NvNmos Test " + std::string(sender ? "Sender" : "Receiver") + "\r\n"
+                "t=0 0\r\n"
+                "a=x-nvnmos-id:" + id + "\r\n"
+                "m=video 5020 RTP/AVP 96\r\n"
+                "c=IN IP4 " + multicast_address + "/64\r\n"
+                "a=source-filter: incl IN IP4 " + multicast_address + " 127.0.0.1\r\n"
+                "a=x-nvnmos-iface-ip:127.0.0.1\r\n"
+                + (sender ? "a=x-nvnmos-src-port:5004\r\n" : "") +
+                "a=rtpmap:96 raw/90000\r\n"
+                "a=fmtp:96 sampling=YCbCr-4:2:2; width=1920; height=1080; exactframerate=50; depth=10; TCS=SDR; colorimetry=BT709; PM=2110GPM; SSN=ST2110-20:2017; TP=2110TPN; \r\n"
+                "a=ts-refclk:localmac=CA-FE-01-CA-FE-02\r\n"
+                "a=mediaclk:direct=0\r\n";
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nvnmos_transportfile.h"
+
+#include "sdp/sdp.h"
+
+namespace nvnmos
+{
+    // This renders a sender's /transportfile from the specified inputs
+    utility::string_t make_transportfile(const transportfile_inputs& inputs)
+    {
+        auto sdp_params = inputs.sdp->sdp_params;
+        sdp_params.ts_refclk = inputs.ts_refclk;
+        sdp_params.origin.session_version = inputs.session_version;
+
+        // use nmos::make_session_description rather than impl::make_session_description for /transportfile
+        // because e.g. the custom SDP attributes in nvnmos::attributes are only for 'internal' use
+        auto session_description = nmos::make_session_description(sdp_params, inputs.transport_params);
+        return utility::s2us(sdp::make_session_description(session_description));
+    }
+
+    // record the inputs for the specified sender, discarding any previously rendered transport file
+    void transportfile_store::set(const utility::string_t& sender_id, transportfile_inputs inputs)
+    {
+        auto e = std::make_shared<entry>(std::move(inputs));
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[sender_id] = std::move(e);
+    }
+
+    // forget the specified sender
+    void transportfile_store::erase(const utility::string_t& sender_id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.erase(sender_id);
+    }
+
+    // forget all senders
+    void transportfile_store::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+    // get the transport file of the specified sender, rendering it if necessary, or an empty string if it isn't known
+    utility::string_t transportfile_store::get(const utility::string_t& sender_id)
+    {
+        std::shared_ptr<entry> e;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = entries.find(sender_id);
+            if (entries.end() == found) return {};
+            if (!found->second->transportfile.empty()) return found->second->transportfile;
+            e = found->second;
+        }
+
+        // render without holding the lock, since the inputs are immutable
+        auto transportfile = make_transportfile(e->inputs);
+
+        // memoize unless the sender has been activated again in the meantime
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(sender_id);
+        if (entries.end() != found && found->second == e) e->transportfile = transportfile;
+        return transportfile;
+    }
+}
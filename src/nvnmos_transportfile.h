@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NVNMOS_TRANSPORTFILE_H
+#define NVNMOS_TRANSPORTFILE_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "nvnmos_sdp_store.h"
+
+namespace nvnmos
+{
+    // The inputs from which a sender's /transportfile is rendered
+    struct transportfile_inputs
+    {
+        // the sender's configured SDP data
+        std::shared_ptr<const sdp_entry> sdp;
+        // the ts-refclk based on the current clock
+        std::vector<nmos::sdp_parameters::ts_refclk_t> ts_refclk;
+        // the /active transport_params
+        web::json::value transport_params;
+        // the session version at activation
+        uint64_t session_version;
+    };
+
+    // This renders a sender's /transportfile from the specified inputs
+    utility::string_t make_transportfile(const transportfile_inputs& inputs);
+
+    // Sender transport files which, if lazy_transport_files is enabled in the settings, are recorded on activation
+    // but only rendered, and then memoized, when first requested
+    class transportfile_store
+    {
+    public:
+        // record the inputs for the specified sender, discarding any previously rendered transport file
+        void set(const utility::string_t& sender_id, transportfile_inputs inputs);
+
+        // forget the specified sender
+        void erase(const utility::string_t& sender_id);
+
+        // forget all senders
+        void clear();
+
+        // get the transport file of the specified sender, rendering it if necessary, or an empty string if it isn't known
+        utility::string_t get(const utility::string_t& sender_id);
+
+    private:
+        struct entry
+        {
+            explicit entry(transportfile_inputs inputs) : inputs(std::move(inputs)) {}
+
+            const transportfile_inputs inputs;
+            utility::string_t transportfile; // empty until rendered
+        };
+
+        std::mutex mutex;
+        std::unordered_map<utility::string_t, std::shared_ptr<entry>> entries;
+    };
+}
+
+#endif
@@ -0,0 +1,533 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// nvnmosd owns a single NvNmos node on behalf of several data plane processes on the same host, which connect to it
+// using the nvnmos-client library, so that together they appear as one NMOS Node; see nvnmos_ipc.h for the protocol
+// The senders and receivers are owned by client name rather than by connection, so they survive client restarts
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "nvnmos.h"
+#include "nvnmos_ipc.h"
+
+namespace
+{
+    volatile std::sig_atomic_t stopping = 0;
+
+    void handle_signal(int)
+    {
+        stopping = 1;
+    }
+
+    // a connected client
+    struct session
+    {
+        // empty until the hello request
+        std::string name;
+        nvnmos::ipc::ring_header* ring = nullptr;
+        size_t ring_size = 0;
+        int event_fd = -1;
+        uint64_t last_alive = 0;
+    };
+
+    // a sender or receiver, which remains in the node while its owner is disconnected
+    struct resource
+    {
+        std::string owner;
+        bool sender = false;
+        std::string sdp;
+        // the latest activation, which is replayed when the owner reconnects
+        bool activated = false;
+        std::string active_sdp;
+    };
+
+    // find the value of the 'x-nvnmos-id' attribute, without parsing the whole SDP data
+    std::string get_internal_id(const std::string& sdp)
+    {
+        static const std::string attribute = "a=x-nvnmos-id:";
+        std::istringstream lines(sdp);
+        for (std::string line; std::getline(lines, line);)
+        {
+            if (!line.empty() && '\r' == line.back()) line.pop_back();
+            if (0 == line.compare(0, attribute.size(), attribute)) return line.substr(attribute.size());
+        }
+        return{};
+    }
+
+    class node_daemon
+    {
+    public:
+        node_daemon(uint32_t slot_count, uint32_t slot_size)
+            : slot_count(slot_count)
+            , slot_size(slot_size)
+        {}
+
+        NvNmosNodeServer server{};
+
+        // the socket of each connected client
+        // only the main thread adds or removes sessions, so it can read the set without the lock
+        std::map<int, session> sessions;
+
+        void open_session(int socket)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sessions[socket];
+        }
+
+        void close_session(int socket)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = sessions.find(socket);
+            if (sessions.end() == found) return;
+            if (nullptr != found->second.ring) ::munmap(found->second.ring, found->second.ring_size);
+            if (-1 != found->second.event_fd) ::close(found->second.event_fd);
+            sessions.erase(found);
+            ::close(socket);
+        }
+
+        // handle a request, returning false if the client should be disconnected
+        bool handle_request(int socket)
+        {
+            std::string message;
+            if (!nvnmos::ipc::receive_message(socket, message)) return false;
+            if (message.size() < sizeof(nvnmos::ipc::request_header)) return false;
+
+            nvnmos::ipc::request_header header;
+            std::memcpy(&header, message.data(), sizeof(header));
+            if (nvnmos::ipc::version != header.version) return false;
+            const auto payload = message.substr(sizeof(header));
+
+            if (nvnmos::ipc::request_type::hello == header.type) return hello(socket, payload);
+
+            std::string name;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto found = sessions.find(socket);
+                if (sessions.end() != found) name = found->second.name;
+            }
+            if (name.empty()) return false;
+
+            NvNmosStatus status = NVNMOS_STATUS_INVALID_ARGUMENT;
+            switch (header.type)
+            {
+            case nvnmos::ipc::request_type::add_receiver: status = add(name, false, payload); break;
+            case nvnmos::ipc::request_type::add_sender: status = add(name, true, payload); break;
+            case nvnmos::ipc::request_type::remove_receiver: status = remove(name, false, payload); break;
+            case nvnmos::ipc::request_type::remove_sender: status = remove(name, true, payload); break;
+            default: break;
+            }
+            return send_reply(socket, status);
+        }
+
+        // indicate that the data plane is alive if any client has done so since the last check
+        void check_alive()
+        {
+            bool alive = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto& session : sessions)
+                {
+                    if (nullptr == session.second.ring) continue;
+                    const auto count = session.second.ring->alive.load(std::memory_order_relaxed);
+                    if (session.second.last_alive != count) alive = true;
+                    session.second.last_alive = count;
+                }
+            }
+            if (alive) nmos_data_plane_alive(&server);
+        }
+
+        static bool handle_rtp_connection_activated(NvNmosNodeServer* server, const char* id, const char* sdp)
+        {
+            auto self = (node_daemon*)server->user_data;
+            std::lock_guard<std::mutex> lock(self->mutex);
+            auto found = self->resources.find(id);
+            if (self->resources.end() == found) return false;
+
+            // if the owner isn't connected, or its ring is full, the activation is rolled back, since the client won't apply it
+            auto session = self->find_session(found->second.owner);
+            if (nullptr == session) return false;
+            const std::string active_sdp = sdp ? sdp : "";
+            if (!self->push_event(*session, nvnmos::ipc::event_type::activation, id, active_sdp, 0, false)) return false;
+
+            found->second.activated = true;
+            found->second.active_sdp = active_sdp;
+            // the client applies the activation asynchronously
+            return true;
+        }
+
+        static void handle_link_state_changed(NvNmosNodeServer* server, const char* id, unsigned int leg, bool up)
+        {
+            auto self = (node_daemon*)server->user_data;
+            std::lock_guard<std::mutex> lock(self->mutex);
+            auto found = self->resources.find(id);
+            if (self->resources.end() == found) return;
+
+            auto session = self->find_session(found->second.owner);
+            if (nullptr != session) self->push_event(*session, nvnmos::ipc::event_type::link_state, id, {}, leg, up);
+        }
+
+        static void handle_log(NvNmosNodeServer*, const char* categories, int level, const char* message)
+        {
+            std::cerr << message << " [" << level << ":" << categories << "]" << std::endl;
+        }
+
+    private:
+        bool hello(int socket, const std::string& name)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto& current = sessions[socket];
+                if (!current.name.empty()) return false;
+                if (name.empty()) return send_reply(socket, NVNMOS_STATUS_INVALID_ARGUMENT);
+                if (nullptr != find_session(name)) return send_reply(socket, NVNMOS_STATUS_DUPLICATE_ID);
+            }
+
+            session created;
+            created.ring_size = nvnmos::ipc::ring_size(slot_count, slot_size);
+            const int shm_fd = ::memfd_create("nvnmosd", MFD_CLOEXEC);
+            created.event_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            bool result = -1 != shm_fd && -1 != created.event_fd && 0 == ::ftruncate(shm_fd, (off_t)created.ring_size);
+            if (result)
+            {
+                auto mapping = ::mmap(nullptr, created.ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+                result = MAP_FAILED != mapping;
+                if (result)
+                {
+                    created.ring = new (mapping) nvnmos::ipc::ring_header();
+                    created.ring->version = nvnmos::ipc::version;
+                    created.ring->slot_count = slot_count;
+                    created.ring->slot_size = slot_size;
+                }
+            }
+            const int fds[2] = { shm_fd, created.event_fd };
+            result = result && send_reply(socket, NVNMOS_STATUS_OK, fds, 2);
+            if (-1 != shm_fd) ::close(shm_fd);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& current = sessions[socket];
+            current.ring = created.ring;
+            current.ring_size = created.ring_size;
+            current.event_fd = created.event_fd;
+            if (!result) return false;
+            current.name = name;
+
+            // replay the latest activation of each sender and receiver owned by the client, e.g. after a restart
+            for (const auto& resource : resources)
+            {
+                if (name != resource.second.owner || !resource.second.activated) continue;
+                push_event(current, nvnmos::ipc::event_type::activation, resource.first, resource.second.active_sdp, 0, false);
+            }
+            std::cerr << "Client " << name << " connected" << std::endl;
+            return true;
+        }
+
+        // the mutex is not held while calling the library, since activations are reported while the model is locked
+        NvNmosStatus add(const std::string& name, bool sender, const std::string& sdp)
+        {
+            const auto id = get_internal_id(sdp);
+            if (id.empty()) return NVNMOS_STATUS_INVALID_SDP;
+
+            bool replace = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto found = resources.find(id);
+                if (resources.end() != found)
+                {
+                    if (name != found->second.owner || sender != found->second.sender) return NVNMOS_STATUS_DUPLICATE_ID;
+                    // the client has restarted, and the sender or receiver is unchanged
+                    if (sdp == found->second.sdp) return NVNMOS_STATUS_OK;
+                    replace = true;
+                }
+                else
+                {
+                    // reserve the id before adding, so that an activation is never reported for an unknown id
+                    auto& added = resources[id];
+                    added.owner = name;
+                    added.sender = sender;
+                }
+            }
+
+            if (replace)
+            {
+                const auto status = remove(name, sender, id);
+                if (NVNMOS_STATUS_OK != status) return status;
+                std::lock_guard<std::mutex> lock(mutex);
+                auto& added = resources[id];
+                added.owner = name;
+                added.sender = sender;
+            }
+
+            NvNmosStatus status;
+            if (sender)
+            {
+                NvNmosSenderConfig config{ sdp.c_str() };
+                status = add_nmos_sender_to_node_server_ex(&server, &config);
+            }
+            else
+            {
+                NvNmosReceiverConfig config{ sdp.c_str() };
+                status = add_nmos_receiver_to_node_server_ex(&server, &config);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (NVNMOS_STATUS_OK == status) resources[id].sdp = sdp;
+            else resources.erase(id);
+            return status;
+        }
+
+        NvNmosStatus remove(const std::string& name, bool sender, const std::string& id)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto found = resources.find(id);
+                if (resources.end() == found || name != found->second.owner || sender != found->second.sender) return NVNMOS_STATUS_NOT_FOUND;
+            }
+
+            const auto status = sender
+                ? remove_nmos_sender_from_node_server_ex(&server, id.c_str())
+                : remove_nmos_receiver_from_node_server_ex(&server, id.c_str());
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (NVNMOS_STATUS_OK == status) resources.erase(id);
+            return status;
+        }
+
+        static bool send_reply(int socket, NvNmosStatus status, const int* fds = nullptr, size_t num_fds = 0)
+        {
+            const nvnmos::ipc::reply reply{ (int32_t)status };
+            return nvnmos::ipc::send_message(socket, std::string((const char*)&reply, sizeof(reply)), fds, num_fds);
+        }
+
+        // the mutex must be held
+        session* find_session(const std::string& name)
+        {
+            for (auto& session : sessions)
+            {
+                if (name == session.second.name) return &session.second;
+            }
+            return nullptr;
+        }
+
+        // the mutex must be held, so that there is a single producer for each ring
+        // returns false if the event was dropped
+        bool push_event(session& session, nvnmos::ipc::event_type type, const std::string& id, const std::string& sdp, unsigned int leg, bool up)
+        {
+            auto ring = session.ring;
+            const auto head = ring->head.load(std::memory_order_relaxed);
+            const auto tail = ring->tail.load(std::memory_order_acquire);
+            if (ring->slot_count <= head - tail || ring->slot_size < sizeof(nvnmos::ipc::event_header) + id.size() + sdp.size())
+            {
+                ring->events_dropped.fetch_add(1, std::memory_order_relaxed);
+                std::cerr << "Client " << session.name << " event dropped for " << id << std::endl;
+                return false;
+            }
+
+            char* slot = nvnmos::ipc::ring_slot(ring, head);
+            const nvnmos::ipc::event_header header{ type, leg, up ? 1u : 0u, (uint32_t)id.size(), (uint32_t)sdp.size() };
+            std::memcpy(slot, &header, sizeof(header));
+            std::memcpy(slot + sizeof(header), id.data(), id.size());
+            std::memcpy(slot + sizeof(header) + id.size(), sdp.data(), sdp.size());
+            ring->head.store(head + 1, std::memory_order_release);
+            ring->events_written.fetch_add(1, std::memory_order_relaxed);
+
+            const uint64_t count = 1;
+            const auto written = ::write(session.event_fd, &count, sizeof(count));
+            (void)written;
+            return true;
+        }
+
+        const uint32_t slot_count;
+        const uint32_t slot_size;
+
+        // protects the sessions and resources, since activations and link state changes are reported on the library's threads
+        std::mutex mutex;
+
+        // the senders and receivers, with internal ids as keys
+        std::map<std::string, resource> resources;
+    };
+
+    int usage(const char* name)
+    {
+        std::cerr
+            << "Usage:\n"
+            << name << " [-s socket-path] [-n slots] [-z slot-size] [-t data-plane-timeout] [-l] host-name port [log-level]\n"
+            << "  -s  path of the UNIX domain socket for clients (default: " << nvnmos::ipc::default_socket_path << ")\n"
+            << "  -n  number of events which each client's ring can hold, a power of two (default: 64)\n"
+            << "  -z  maximum size in bytes of each event, including the SDP data (default: 16384)\n"
+            << "  -t  data plane timeout in milliseconds, within which any client must indicate it is alive (default: 0, disabled)\n"
+            << "  -l  monitor the network interfaces' link state\n";
+        return 2;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string socket_path = nvnmos::ipc::default_socket_path;
+    uint32_t slot_count = 64;
+    uint32_t slot_size = 16384;
+    unsigned int data_plane_timeout = 0;
+    bool monitor_links = false;
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if ("-s" == arg && i + 1 < argc)
+        {
+            socket_path = argv[++i];
+        }
+        else if ("-n" == arg && i + 1 < argc)
+        {
+            slot_count = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            if (0 == slot_count || 0 != (slot_count & (slot_count - 1))) return usage(argv[0]);
+        }
+        else if ("-z" == arg && i + 1 < argc)
+        {
+            slot_size = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            if (slot_size < sizeof(nvnmos::ipc::event_header)) return usage(argv[0]);
+        }
+        else if ("-t" == arg && i + 1 < argc)
+        {
+            data_plane_timeout = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if ("-l" == arg)
+        {
+            monitor_links = true;
+        }
+        else if (!arg.empty() && '-' != arg[0])
+        {
+            args.push_back(arg);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (args.size() < 2 || 3 < args.size()) return usage(argv[0]);
+
+    // the ring's slots must be aligned for the event header
+    slot_size = (slot_size + alignof(nvnmos::ipc::event_header) - 1) & ~(uint32_t)(alignof(nvnmos::ipc::event_header) - 1);
+
+    struct sigaction action{};
+    action.sa_handler = &handle_signal;
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (sizeof(address.sun_path) <= socket_path.size()) return usage(argv[0]);
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+
+    const int listener = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    ::unlink(socket_path.c_str());
+    if (-1 == listener || -1 == ::bind(listener, (sockaddr*)&address, sizeof(address)) || -1 == ::listen(listener, SOMAXCONN))
+    {
+        std::cerr << "Could not listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    node_daemon d(slot_count, slot_size);
+    d.server.user_data = &d;
+
+    // the seed is derived from the host name and port, so that the node's resource ids are stable across daemon restarts
+    const std::string seed = args[0] + ":" + args[1];
+
+    NvNmosNodeConfig node_config{};
+    node_config.host_name = args[0].c_str();
+    node_config.http_port = (unsigned int)std::strtoul(args[1].c_str(), nullptr, 10);
+    node_config.seed = seed.c_str();
+    node_config.rtp_connection_activated = &node_daemon::handle_rtp_connection_activated;
+    node_config.external_event_loop = true;
+    node_config.data_plane_timeout = data_plane_timeout;
+    node_config.monitor_links = monitor_links;
+    node_config.link_state_changed = &node_daemon::handle_link_state_changed;
+    node_config.log_callback = &node_daemon::handle_log;
+    node_config.log_level = 3 == args.size() ? std::atoi(args[2].c_str()) : NVNMOS_LOG_ERROR;
+
+    if (!create_nmos_node_server(&node_config, &d.server))
+    {
+        ::close(listener);
+        ::unlink(socket_path.c_str());
+        return 1;
+    }
+
+    std::vector<int> node_fds(4);
+    std::vector<pollfd> pfds;
+    while (!stopping)
+    {
+        int timeout = -1;
+        unsigned int num_node_fds = (unsigned int)node_fds.size();
+        while (!nmos_get_poll_fds(&d.server, node_fds.data(), &num_node_fds, &timeout) && node_fds.size() < num_node_fds)
+        {
+            node_fds.resize(num_node_fds);
+        }
+        if (0 != data_plane_timeout)
+        {
+            // at least 1 ms, since a zero timeout would make the loop spin
+            const int check_interval = (std::max)(1, (int)(data_plane_timeout / 4));
+            if (-1 == timeout || check_interval < timeout) timeout = check_interval;
+        }
+
+        pfds.clear();
+        pfds.push_back({ listener, POLLIN, 0 });
+        for (const auto& session : d.sessions) pfds.push_back({ session.first, POLLIN, 0 });
+        for (unsigned int i = 0; i != num_node_fds; ++i) pfds.push_back({ node_fds[i], POLLIN, 0 });
+
+        if (-1 == ::poll(pfds.data(), (nfds_t)pfds.size(), timeout) && EINTR != errno) break;
+
+        const size_t num_sessions = d.sessions.size();
+        for (size_t i = 1; i != 1 + num_sessions; ++i)
+        {
+            if (0 == pfds[i].revents) continue;
+            if (0 != (pfds[i].revents & POLLIN) && d.handle_request(pfds[i].fd)) continue;
+            d.close_session(pfds[i].fd);
+        }
+
+        if (0 != (pfds[0].revents & POLLIN))
+        {
+            const int socket = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (-1 != socket) d.open_session(socket);
+        }
+
+        nmos_run_once(&d.server, 0);
+
+        if (0 != data_plane_timeout) d.check_alive();
+    }
+
+    destroy_nmos_node_server(&d.server);
+
+    while (!d.sessions.empty()) d.close_session(d.sessions.begin()->first);
+    ::close(listener);
+    ::unlink(socket_path.c_str());
+    return 0;
+}